@@ -1,6 +1,8 @@
-glslc ./shaders/default.vert -o ./shaders/default.vert.spv
-glslc ./shaders/default.frag -o ./shaders/default.frag.spv
-glslc ./shaders/default-solid.frag -o ./shaders/default-solid.frag.spv
-glslc ./shaders/phong-light.vert -o ./shaders/phong-light.vert.spv
-glslc ./shaders/phong-light.frag -o ./shaders/phong-light.frag.spv
-glslc ./shaders/phong-light-solid.frag -o ./shaders/phong-light-solid.frag.spv
+# The build compiles every shader into <build>/shaders, rerun it there while the renderer runs to hot-reload
+OUT=${1:-./build/shaders}
+
+mkdir -p "$OUT"
+
+for SHADER in ./shaders/*.vert ./shaders/*.frag ./shaders/*.comp; do
+  glslc "$SHADER" -o "$OUT"/"$(basename "$SHADER")".spv
+done
@@ -0,0 +1,66 @@
+layout(set = 3, binding = 1) uniform ClusterParams {
+  mat4 view;
+  mat4 inverseProjection;
+  uvec4 grid;
+  vec4 screen;
+} clusterParams;
+
+struct PointLight {
+  vec3 pos;
+  float radius;
+  vec3 color;
+  float intensity;
+};
+
+layout(std430, set = 3, binding = 2) readonly buffer PointLights {
+  PointLight pointLights[];
+};
+
+layout(std430, set = 3, binding = 3) readonly buffer Clusters {
+  uint clusterLights[];
+};
+
+const uint CLUSTER_STRIDE = 128;
+
+uint clusterIndex(vec2 fragCoord, float viewDepth) {
+  uvec3 grid = clusterParams.grid.xyz;
+  float near = clusterParams.screen.z;
+  float far = clusterParams.screen.w;
+
+  uvec2 tile = uvec2(fragCoord / (clusterParams.screen.xy / vec2(grid.xy)));
+  uint slice = uint(max(log(viewDepth / near) / log(far / near) * float(grid.z), 0.0));
+
+  uvec3 cluster = min(uvec3(tile, slice), grid - 1);
+
+  return cluster.x + cluster.y * grid.x + cluster.z * grid.x * grid.y;
+}
+
+vec3 clusteredPointLights(vec3 fragPos, vec3 normal, float shininess, float specularStrength) {
+  uint cluster = clusterIndex(gl_FragCoord.xy, -fragPos.z) * CLUSTER_STRIDE;
+  uint count = clusterLights[cluster];
+
+  vec3 view = normalize(-fragPos);
+  vec3 result = vec3(0.0);
+
+  for (uint i = 0; i < count; i++) {
+    PointLight pointLight = pointLights[clusterLights[cluster + 1 + i]];
+
+    vec3 toLight = (clusterParams.view * vec4(pointLight.pos, 1.0)).xyz - fragPos;
+    float lightDistance = length(toLight);
+
+    if (lightDistance >= pointLight.radius) {
+      continue;
+    }
+
+    vec3 direction = toLight / lightDistance;
+    float falloff = 1.0 - (lightDistance * lightDistance) / (pointLight.radius * pointLight.radius);
+    float attenuation = falloff * falloff * pointLight.intensity;
+
+    float diffuse = max(dot(direction, normal), 0.0);
+    float specular = pow(max(dot(view, reflect(-direction, normal)), 0.0), shininess) * specularStrength;
+
+    result += pointLight.color * (diffuse + specular) * attenuation;
+  }
+
+  return result;
+}
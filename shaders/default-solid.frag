@@ -1,4 +1,5 @@
 #version 450 
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 inColor;
 layout(location = 1) in vec2 inTexCoord;
@@ -6,7 +7,13 @@ layout(location = 2) in vec3 inNormals;
 
 layout(location = 0) out vec4 outColor;
 
-layout(set = 0, binding = 0) uniform sampler2D tex0;
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform Draw {
+  uint objectIdx;
+  uint materialIdx;
+  uint textureIdx;
+} draw;
 
 void main() {
   outColor = vec4(inColor, 1.0);
@@ -9,22 +9,36 @@ layout(location = 0) out vec3 outColor;
 layout(location = 1) out vec2 outTexCoord;
 layout(location = 2) out vec3 outNormals;
 
+invariant gl_Position;
+
 layout(set = 1, binding = 0) uniform Projection {
   mat4 model;
   mat4 view;
   mat4 perspective;
 } proj;
 
-layout(set = 2, binding = 0) uniform Object {
-  mat4 translation;
-  mat4 rotation;
-  mat4 scale;
+struct ObjectData {
+  mat4 model;
+  mat3 normal;
   vec3 color;
-} object;
+  vec4 bounds;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Objects {
+  ObjectData objects[];
+};
+
+layout(push_constant) uniform Draw {
+  uint objectIdx;
+  uint materialIdx;
+  uint textureIdx;
+} draw;
 
 void main() {
-  gl_Position = proj.perspective * (proj.view * (object.translation * object.rotation * object.scale * proj.model * vec4(inPosition, 1.0)));
+  ObjectData object = objects[draw.objectIdx];
+
+  gl_Position = proj.perspective * (proj.view * (object.model * (proj.model * vec4(inPosition, 1.0))));
   outColor = object.color;
   outTexCoord = inTexCoord;
-  outNormals = outNormals;
+  outNormals = object.normal * (mat3(proj.model) * inNormals);
 }
@@ -0,0 +1,32 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+layout(set = 1, binding = 0) uniform Projection {
+  mat4 model;
+  mat4 view;
+  mat4 perspective;
+} proj;
+
+struct ObjectData {
+  mat4 model;
+  mat3 normal;
+  vec3 color;
+  vec4 bounds;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Objects {
+  ObjectData objects[];
+};
+
+layout(push_constant) uniform Draw {
+  uint objectIdx;
+  uint materialIdx;
+  uint textureIdx;
+} draw;
+
+void main() {
+  gl_Position = proj.perspective * (proj.view * (objects[draw.objectIdx].model * (proj.model * vec4(inPosition, 1.0))));
+}
@@ -1,4 +1,6 @@
 #version 450 
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
 
 layout(location = 0) in vec3 inColor;
 layout(location = 1) in vec2 inTexCoord;
@@ -11,17 +13,45 @@ layout(set = 3, binding = 0) uniform Light {
   vec3 pos;
   vec3 color;
   float ambient;
+  float shadowFar;
 } light;
 
+layout(set = 3, binding = 4) uniform samplerCubeShadow shadowMap;
+
+#include "clustered-lights.glsl"
+
 layout(set = 1, binding = 0) uniform Projection {
   mat4 model;
   mat4 view;
   mat4 perspective;
 } proj;
 
-layout(set = 0, binding = 0) uniform sampler2D tex0;
+struct Material {
+  float specular;
+  float shininess;
+};
+
+layout(std430, set = 2, binding = 1) readonly buffer Materials {
+  Material materials[];
+};
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform Draw {
+  uint objectIdx;
+  uint materialIdx;
+  uint textureIdx;
+} draw;
+
+float shadowFactor(vec3 fragPos) {
+  vec3 toFrag = fragPos - (proj.view * vec4(light.pos, 1.0)).xyz;
+  vec3 direction = transpose(mat3(proj.view)) * toFrag;
+
+  return texture(shadowMap, vec4(direction, length(toFrag) / light.shadowFar - 0.005));
+}
 
 void main() {
+  Material material = materials[draw.materialIdx];
   vec3 normal = normalize(inNormals);
 
   vec3 direction = normalize((proj.view * vec4(light.pos, 1.0)).xyz - inFragPos);
@@ -30,7 +60,11 @@ void main() {
   vec3 view = normalize(-inFragPos);
   vec3 reflection = reflect(-direction, normal);  
 
-  float specular = pow(max(dot(view, reflection), 0.0), 32) * 0.5;
+  float specular = pow(max(dot(view, reflection), 0.0), material.shininess) * material.specular;
   
-  outColor = vec4(texture(tex0, inTexCoord).xyz * light.color * (diffuse + light.ambient + specular), 1.0);
+  float shadow = shadowFactor(inFragPos);
+
+  vec3 lighting = light.color * (shadow * (diffuse + specular) + light.ambient) + clusteredPointLights(inFragPos, normal, material.shininess, material.specular);
+
+  outColor = vec4(texture(textures[draw.textureIdx], inTexCoord).xyz * lighting, 1.0);
 } 
@@ -10,27 +10,42 @@ layout(location = 1) out vec2 outTexCoord;
 layout(location = 2) out vec3 outFragPos;
 layout(location = 3) out vec3 outNormals;
 
+invariant gl_Position;
+
 layout(set = 1, binding = 0) uniform Projection {
   mat4 model;
   mat4 view;
   mat4 perspective;
 } proj;
 
-layout(set = 2, binding = 0) uniform Object {
-  mat4 translation;
-  mat4 rotation;
-  mat4 scale;
+struct ObjectData {
+  mat4 model;
+  mat3 normal;
   vec3 color;
-} object;
+  vec4 bounds;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Objects {
+  ObjectData objects[];
+};
+
+layout(push_constant) uniform Draw {
+  uint objectIdx;
+  uint materialIdx;
+  uint textureIdx;
+} draw;
 
 void main() {
-  vec3 pos = (proj.view * object.translation * object.rotation * object.scale * proj.model * vec4(inPosition, 1.0)).xyz;
-  vec3 normal = normalize((proj.view * object.rotation * proj.model * vec4(inNormals, 0.0))).xyz;
+  ObjectData object = objects[draw.objectIdx];
+
+  vec4 viewPos = proj.view * (object.model * (proj.model * vec4(inPosition, 1.0)));
+  vec3 pos = viewPos.xyz;
+  vec3 normal = normalize(mat3(proj.view) * (object.normal * (mat3(proj.model) * inNormals)));
 
   outTexCoord = inTexCoord;
   outColor = object.color;
   outNormals = normal;
   outFragPos = pos;
 
-  gl_Position = proj.perspective * vec4(pos, 1.0);
+  gl_Position = proj.perspective * viewPos;
 }
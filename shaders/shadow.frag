@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec3 inWorldPos;
+
+layout(push_constant) uniform Shadow {
+  mat4 viewProjection;
+  vec4 light;
+  uint objectIdx;
+} shadow;
+
+void main() {
+  gl_FragDepth = length(inWorldPos - shadow.light.xyz) / shadow.light.w;
+}
@@ -0,0 +1,35 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+
+layout(location = 0) out vec3 outWorldPos;
+
+layout(set = 1, binding = 0) uniform Projection {
+  mat4 model;
+  mat4 view;
+  mat4 perspective;
+} proj;
+
+struct ObjectData {
+  mat4 model;
+  mat3 normal;
+  vec3 color;
+  vec4 bounds;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Objects {
+  ObjectData objects[];
+};
+
+layout(push_constant) uniform Shadow {
+  mat4 viewProjection;
+  vec4 light;
+  uint objectIdx;
+} shadow;
+
+void main() {
+  vec4 worldPos = objects[shadow.objectIdx].model * (proj.model * vec4(inPosition, 1.0));
+
+  outWorldPos = worldPos.xyz;
+  gl_Position = shadow.viewProjection * worldPos;
+}
@@ -0,0 +1,200 @@
+#include "asset-archive.hpp"
+
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "fs.hpp"
+
+static uint64_t alignUp(const uint64_t value, const uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool inBounds(const uint64_t offset, const uint64_t size, const uint64_t total) {
+  return size <= total && offset <= total - size;
+}
+
+static void readExact(const int fd, void* dst, const uint64_t size, const uint64_t offset, const std::string_view path) {
+  uint64_t done = 0;
+
+  while (done < size) {
+    ssize_t result = pread(fd, static_cast<char*>(dst) + done, size - done, offset + done);
+
+    if (result <= 0) {
+      throw std::runtime_error{std::string{"Asset archive is truncated: "} + path.data()};
+    }
+
+    done += result;
+  }
+}
+
+std::string_view assetName(const std::string_view path) {
+  return path.substr(0, 2) == "./" ? path.substr(2) : path;
+}
+
+AssetArchive::AssetArchive() {
+}
+
+AssetArchive::AssetArchive(const std::string_view path) {
+  fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    throw std::runtime_error{std::string{"Failed to open file: "} + path.data()};
+  }
+
+  try {
+    AssetArchiveHeader header{};
+    readExact(fd, &header, sizeof(header), 0, path);
+
+    if (header.magic != ASSET_ARCHIVE_MAGIC || header.version != ASSET_ARCHIVE_VERSION) {
+      throw std::runtime_error{std::string{"Unsupported asset archive: "} + path.data()};
+    }
+
+    struct stat status{};
+
+    if (fstat(fd, &status) != 0) {
+      throw std::runtime_error{std::string{"Failed to stat file: "} + path.data()};
+    }
+
+    uint64_t fileSize = status.st_size;
+    uint64_t tableSize = static_cast<uint64_t>(header.entryCount) * sizeof(AssetArchiveEntry);
+
+    // The counts come straight from the file, so they are checked before anything is sized from them
+    if (!inBounds(header.entriesOffset, tableSize, fileSize) || !inBounds(header.namesOffset, header.namesSize, fileSize)) {
+      throw std::runtime_error{std::string{"Asset archive is truncated: "} + path.data()};
+    }
+
+    table.resize(header.entryCount);
+    names.resize(header.namesSize);
+
+    readExact(fd, table.data(), table.size() * sizeof(AssetArchiveEntry), header.entriesOffset, path);
+    readExact(fd, names.data(), names.size(), header.namesOffset, path);
+
+    for (uint32_t i = 0; i < table.size(); i++) {
+      if (static_cast<uint64_t>(table[i].nameOffset) + table[i].nameLength > names.size()) {
+        throw std::runtime_error{std::string{"Asset archive has an invalid entry name: "} + path.data()};
+      }
+
+      if (!inBounds(table[i].offset, table[i].size, fileSize)) {
+        throw std::runtime_error{std::string{"Asset archive has an entry past its end: "} + path.data()};
+      }
+
+      lookup[name(table[i])] = i;
+    }
+  } catch (const std::exception&) {
+    close();
+    throw;
+  }
+}
+
+AssetArchive::AssetArchive(AssetArchive&& other) noexcept:
+  fd{std::exchange(other.fd, -1)},
+  table{std::move(other.table)},
+  names{std::move(other.names)},
+  lookup{std::move(other.lookup)} {
+}
+
+AssetArchive& AssetArchive::operator=(AssetArchive&& other) noexcept {
+  if (this != &other) {
+    close();
+    fd = std::exchange(other.fd, -1);
+    table = std::move(other.table);
+    names = std::move(other.names);
+    lookup = std::move(other.lookup);
+  }
+
+  return *this;
+}
+
+AssetArchive::~AssetArchive() {
+  close();
+}
+
+void AssetArchive::close() {
+  if (fd >= 0) {
+    ::close(fd);
+  }
+
+  fd = -1;
+}
+
+const AssetArchiveEntry* AssetArchive::find(const std::string_view path) const {
+  auto it = lookup.find(assetName(path));
+  return it == lookup.end() ? nullptr : &table[it->second];
+}
+
+std::string_view AssetArchive::name(const AssetArchiveEntry& entry) const {
+  return std::string_view{names.data() + entry.nameOffset, entry.nameLength};
+}
+
+const std::vector<AssetArchiveEntry>& AssetArchive::entries() const {
+  return table;
+}
+
+int AssetArchive::descriptor() const {
+  return fd;
+}
+
+bool AssetArchive::isOpen() const {
+  return fd >= 0;
+}
+
+void writeAssetArchive(const std::string_view path, const std::vector<std::string>& inputs) {
+  std::vector<fs::MappedFile> files;
+  std::vector<AssetArchiveEntry> entries;
+  std::string names;
+
+  for (const std::string& input : inputs) {
+    std::string_view name = assetName(input);
+
+    entries.push_back(AssetArchiveEntry{0, 0, static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size())});
+    names += name;
+    files.push_back(fs::MappedFile{input});
+  }
+
+  AssetArchiveHeader header{};
+  header.magic = ASSET_ARCHIVE_MAGIC;
+  header.version = ASSET_ARCHIVE_VERSION;
+  header.entryCount = entries.size();
+  header.namesSize = names.size();
+  header.entriesOffset = sizeof(AssetArchiveHeader);
+  header.namesOffset = header.entriesOffset + entries.size() * sizeof(AssetArchiveEntry);
+
+  // Page aligned payloads can be mapped in place or read with O_DIRECT
+  uint64_t offset = alignUp(header.namesOffset + names.size(), ASSET_ARCHIVE_ALIGNMENT);
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    entries[i].offset = offset;
+    entries[i].size = files[i].size();
+    offset = alignUp(offset + files[i].size(), ASSET_ARCHIVE_ALIGNMENT);
+  }
+
+  std::ofstream file{path.data(), std::ios::out | std::ios::binary | std::ios::trunc};
+
+  if (!file.is_open()) {
+    throw std::runtime_error{std::string{"Failed to open file: "} + path.data()};
+  }
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetArchiveEntry));
+  file.write(names.data(), names.size());
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (files[i].size() == 0) {
+      continue;
+    }
+
+    file.seekp(entries[i].offset);
+    file.write(files[i].data(), files[i].size());
+  }
+
+  // Always extend to the final offset, empty trailing entries point there and would otherwise lie past the end
+  file.seekp(offset - 1);
+  file.put('\0');
+
+  if (!file) {
+    throw std::runtime_error{std::string{"Failed to write asset archive: "} + path.data()};
+  }
+}
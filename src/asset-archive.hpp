@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+const uint32_t ASSET_ARCHIVE_MAGIC = 0x41524b56;
+const uint32_t ASSET_ARCHIVE_VERSION = 1;
+const uint64_t ASSET_ARCHIVE_ALIGNMENT = 4096;
+
+struct AssetArchiveHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t namesSize;
+  uint64_t entriesOffset;
+  uint64_t namesOffset;
+};
+
+struct AssetArchiveEntry {
+  uint64_t offset;
+  uint64_t size;
+  uint32_t nameOffset;
+  uint32_t nameLength;
+};
+
+static_assert(sizeof(AssetArchiveHeader) == 32);
+static_assert(sizeof(AssetArchiveEntry) == 24);
+
+class AssetArchive {
+public:
+  AssetArchive();
+  AssetArchive(const std::string_view path);
+  AssetArchive(AssetArchive&& other) noexcept;
+  AssetArchive& operator=(AssetArchive&& other) noexcept;
+  AssetArchive(const AssetArchive&) = delete;
+  AssetArchive& operator=(const AssetArchive&) = delete;
+  ~AssetArchive();
+
+  const AssetArchiveEntry* find(const std::string_view name) const;
+  std::string_view name(const AssetArchiveEntry& entry) const;
+  const std::vector<AssetArchiveEntry>& entries() const;
+
+  int descriptor() const;
+  bool isOpen() const;
+private:
+  int fd = -1;
+  std::vector<AssetArchiveEntry> table;
+  std::string names;
+  std::unordered_map<std::string_view, uint32_t> lookup;
+
+  void close();
+};
+
+std::string_view assetName(const std::string_view path);
+void writeAssetArchive(const std::string_view path, const std::vector<std::string>& inputs);
@@ -0,0 +1,375 @@
+#include "async-reader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+#include "trace.hpp"
+
+static const uint64_t CHUNK_SIZE = 4 * 1024 * 1024;
+static const uint32_t MAX_WORKERS = 8;
+
+static int ioUringSetup(const uint32_t entries, io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int ioUringEnter(const int fd, const uint32_t toSubmit, const uint32_t minComplete, const uint32_t flags) {
+  return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+static int ioUringRegister(const int fd, const uint32_t opcode, void* arg, const uint32_t argCount) {
+  return syscall(__NR_io_uring_register, fd, opcode, arg, argCount);
+}
+
+// IORING_OP_READ needs Linux 5.6, older kernels either lack the probe or report the opcode as unsupported
+static bool supportsRead(const int ringFd) {
+  const uint32_t opCount = 256;
+  std::vector<char> storage(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op), 0);
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+
+  if (ioUringRegister(ringFd, IORING_REGISTER_PROBE, probe, opCount) < 0) {
+    return false;
+  }
+
+  return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+}
+
+AsyncReader::AsyncReader(const uint32_t q): queueDepth{q} {
+}
+
+AsyncReader::~AsyncReader() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+
+  workAvailable.notify_all();
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  destroyRing();
+}
+
+bool AsyncReader::usingIoUring() const {
+  return ringFd >= 0;
+}
+
+// Nothing is set up until there is something to read, so engines without an archive pay for no ring or threads
+void AsyncReader::start() {
+  if (usingIoUring() || !workers.empty()) {
+    return;
+  }
+
+  if (!setupRing()) {
+    startWorkers();
+  }
+}
+
+void AsyncReader::startWorkers() {
+  uint32_t workerCount = std::clamp(std::thread::hardware_concurrency(), 2u, MAX_WORKERS);
+
+  for (uint32_t i = 0; i < workerCount; i++) {
+    workers.emplace_back(&AsyncReader::work, this);
+  }
+}
+
+// io_uring is unavailable on older kernels and blocked by some container seccomp profiles
+bool AsyncReader::setupRing() {
+  io_uring_params params{};
+
+  ringFd = ioUringSetup(queueDepth, &params);
+
+  if (ringFd < 0) {
+    ringFd = -1;
+    return false;
+  }
+
+  if (!supportsRead(ringFd)) {
+    destroyRing();
+    return false;
+  }
+
+  queueDepth = params.sq_entries;
+
+  sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+  }
+
+  sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+
+  if (sqRing == MAP_FAILED) {
+    sqRing = nullptr;
+    destroyRing();
+    return false;
+  }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cqRing = sqRing;
+  } else {
+    cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+
+    if (cqRing == MAP_FAILED) {
+      cqRing = nullptr;
+      destroyRing();
+      return false;
+    }
+  }
+
+  sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+
+  if (sqes == MAP_FAILED) {
+    sqes = nullptr;
+    destroyRing();
+    return false;
+  }
+
+  char* sq = static_cast<char*>(sqRing);
+  char* cq = static_cast<char*>(cqRing);
+
+  sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+  sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+  sqMask = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+  sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+  cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+  cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+  cqMask = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+  cqes = cq + params.cq_off.cqes;
+
+  return true;
+}
+
+void AsyncReader::destroyRing() {
+  if (sqes) {
+    munmap(sqes, sqesSize);
+  }
+
+  if (cqRing && cqRing != sqRing) {
+    munmap(cqRing, cqRingSize);
+  }
+
+  if (sqRing) {
+    munmap(sqRing, sqRingSize);
+  }
+
+  if (ringFd >= 0) {
+    close(ringFd);
+  }
+
+  sqes = sqRing = cqRing = nullptr;
+  ringFd = -1;
+}
+
+void AsyncReader::read(const std::vector<ReadRequest>& requests) {
+  TRACE_FUNCTION();
+
+  std::vector<Chunk> chunks;
+
+  for (const ReadRequest& request : requests) {
+    for (uint64_t done = 0; done < request.size; done += CHUNK_SIZE) {
+      uint32_t size = static_cast<uint32_t>(std::min(CHUNK_SIZE, request.size - done));
+      chunks.push_back(Chunk{request.fd, request.offset + done, size, static_cast<char*>(request.dst) + done});
+    }
+  }
+
+  start();
+
+  // A kernel that still rejects the opcode hands the unfinished chunks, and every later read, to the pool
+  if (usingIoUring()) {
+    if (readRing(chunks)) {
+      return;
+    }
+
+    destroyRing();
+    startWorkers();
+  }
+
+  readPool(chunks);
+}
+
+void AsyncReader::queue(const Chunk& chunk, const uint64_t userData) {
+  io_uring_sqe* sqeArray = static_cast<io_uring_sqe*>(sqes);
+
+  uint32_t tail = *sqTail;
+  uint32_t index = tail & *sqMask;
+
+  io_uring_sqe& sqe = sqeArray[index];
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_READ;
+  sqe.fd = chunk.fd;
+  sqe.off = chunk.offset;
+  sqe.addr = reinterpret_cast<uint64_t>(chunk.dst);
+  sqe.len = chunk.size;
+  sqe.user_data = userData;
+
+  sqArray[index] = index;
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool AsyncReader::readRing(std::vector<Chunk>& chunks) {
+  io_uring_cqe* cqeArray = static_cast<io_uring_cqe*>(cqes);
+
+  size_t next = 0;
+  size_t inFlight = 0;
+  size_t remaining = chunks.size();
+  uint32_t queued = 0;
+  std::vector<bool> completed(chunks.size(), false);
+  std::string failure;
+  bool rejected = false;
+
+  // Once a read fails nothing new is queued, but reads already in flight still own their buffers
+  while (inFlight > 0 || (failure.empty() && !rejected && remaining > 0)) {
+    while (failure.empty() && !rejected && next < chunks.size() && inFlight < queueDepth) {
+      queue(chunks[next], next);
+      next++;
+      inFlight++;
+      queued++;
+    }
+
+    int submitted = ioUringEnter(ringFd, queued, 1, IORING_ENTER_GETEVENTS);
+
+    if (submitted > 0) {
+      queued -= submitted;
+    }
+
+    if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY && failure.empty()) {
+      failure = std::string{"Failed to submit reads: "} + std::strerror(errno);
+
+      // Without SQPOLL the kernel only takes entries inside io_uring_enter, so the ones it has not taken can be withdrawn
+      uint32_t head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+      inFlight -= *sqTail - head;
+      queued = 0;
+      __atomic_store_n(sqTail, head, __ATOMIC_RELEASE);
+    }
+
+    uint32_t head = *cqHead;
+    uint32_t tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+      const io_uring_cqe& cqe = cqeArray[head & *cqMask];
+      Chunk& chunk = chunks[cqe.user_data];
+      inFlight--;
+
+      if (cqe.res == -EINVAL) {
+        rejected = true;
+        continue;
+      }
+
+      if (cqe.res <= 0) {
+        if (failure.empty()) {
+          failure = cqe.res == 0 ? "Unexpected end of file while reading asset data" : std::string{"Failed to read asset data: "} + std::strerror(-cqe.res);
+        }
+        continue;
+      }
+
+      if (static_cast<uint32_t>(cqe.res) < chunk.size && failure.empty() && !rejected) {
+        chunk.offset += cqe.res;
+        chunk.dst += cqe.res;
+        chunk.size -= cqe.res;
+
+        queue(chunk, cqe.user_data);
+        inFlight++;
+        queued++;
+        continue;
+      }
+
+      completed[cqe.user_data] = true;
+      remaining--;
+    }
+
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+  }
+
+  if (!failure.empty()) {
+    throw std::runtime_error{failure};
+  }
+
+  if (!rejected) {
+    return true;
+  }
+
+  std::vector<Chunk> unfinished;
+
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (!completed[i]) {
+      unfinished.push_back(chunks[i]);
+    }
+  }
+
+  chunks = std::move(unfinished);
+  return false;
+}
+
+void AsyncReader::readPool(std::vector<Chunk>& chunks) {
+  std::unique_lock<std::mutex> lock{mutex};
+
+  error.clear();
+  outstanding += chunks.size();
+  pending.insert(pending.end(), chunks.begin(), chunks.end());
+  workAvailable.notify_all();
+
+  workDone.wait(lock, [&]() { return outstanding == 0; });
+
+  if (!error.empty()) {
+    throw std::runtime_error{error};
+  }
+}
+
+void AsyncReader::work() {
+  trace::setThreadName("asset-reader");
+
+  std::unique_lock<std::mutex> lock{mutex};
+
+  while (true) {
+    workAvailable.wait(lock, [&]() { return stopping || !pending.empty(); });
+
+    if (stopping) {
+      return;
+    }
+
+    Chunk chunk = pending.front();
+    pending.pop_front();
+    lock.unlock();
+
+    TRACE_BEGIN(readZone, "pread");
+    std::string failure;
+
+    while (chunk.size > 0) {
+      ssize_t result = pread(chunk.fd, chunk.dst, chunk.size, chunk.offset);
+
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+
+      if (result <= 0) {
+        failure = result == 0 ? "Unexpected end of file while reading asset data" : std::string{"Failed to read asset data: "} + std::strerror(errno);
+        break;
+      }
+
+      chunk.offset += result;
+      chunk.dst += result;
+      chunk.size -= result;
+    }
+
+    TRACE_END(readZone);
+    lock.lock();
+
+    if (!failure.empty() && error.empty()) {
+      error = failure;
+    }
+
+    if (--outstanding == 0) {
+      workDone.notify_all();
+    }
+  }
+}
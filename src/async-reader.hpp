@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReadRequest {
+  int fd;
+  uint64_t offset;
+  uint64_t size;
+  void* dst;
+};
+
+class AsyncReader {
+public:
+  AsyncReader(const uint32_t queueDepth = 64);
+  AsyncReader(const AsyncReader&) = delete;
+  AsyncReader& operator=(const AsyncReader&) = delete;
+  ~AsyncReader();
+
+  void start();
+  void read(const std::vector<ReadRequest>& requests);
+  bool usingIoUring() const;
+private:
+  struct Chunk {
+    int fd;
+    uint64_t offset;
+    uint32_t size;
+    char* dst;
+  };
+
+  uint32_t queueDepth;
+
+  int ringFd = -1;
+  void* sqRing = nullptr;
+  void* cqRing = nullptr;
+  size_t sqRingSize = 0;
+  size_t cqRingSize = 0;
+  void* sqes = nullptr;
+  size_t sqesSize = 0;
+  uint32_t* sqHead = nullptr;
+  uint32_t* sqTail = nullptr;
+  uint32_t* sqMask = nullptr;
+  uint32_t* sqArray = nullptr;
+  uint32_t* cqHead = nullptr;
+  uint32_t* cqTail = nullptr;
+  uint32_t* cqMask = nullptr;
+  void* cqes = nullptr;
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable workAvailable;
+  std::condition_variable workDone;
+  std::deque<Chunk> pending;
+  size_t outstanding = 0;
+  std::string error;
+  bool stopping = false;
+
+  bool setupRing();
+  void destroyRing();
+  void startWorkers();
+  void queue(const Chunk& chunk, const uint64_t userData);
+  bool readRing(std::vector<Chunk>& chunks);
+  void readPool(std::vector<Chunk>& chunks);
+  void work();
+};
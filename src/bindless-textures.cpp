@@ -0,0 +1,103 @@
+#include "bindless-textures.hpp"
+
+#include <stdexcept>
+
+BindlessTextures::BindlessTextures() {
+}
+
+BindlessTextures::BindlessTextures(const vk::Device& device, const uint32_t c): capacity{c} {
+  createDescriptors(device);
+}
+
+void BindlessTextures::createDescriptors(const vk::Device& device) {
+  vk::DescriptorPoolSize samplerPool = vk::DescriptorPoolSize{}
+    .setDescriptorCount(capacity)
+    .setType(vk::DescriptorType::eCombinedImageSampler);
+
+  vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo = vk::DescriptorPoolCreateInfo{}
+    .setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind)
+    .setMaxSets(1)
+    .setPoolSizes(samplerPool)
+    .setPoolSizeCount(1);
+
+  descriptorPool = device.createDescriptorPool(descriptorPoolCreateInfo, nullptr);
+
+  vk::DescriptorBindingFlags bindingFlags =
+    vk::DescriptorBindingFlagBits::ePartiallyBound |
+    vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+    vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending |
+    vk::DescriptorBindingFlagBits::eVariableDescriptorCount;
+
+  vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfo{}
+    .setBindingFlags(bindingFlags)
+    .setBindingCount(1);
+
+  vk::DescriptorSetLayoutBinding samplerBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(0)
+    .setDescriptorCount(capacity)
+    .setStageFlags(vk::ShaderStageFlagBits::eFragment)
+    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+
+  vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = vk::DescriptorSetLayoutCreateInfo{}
+    .setPNext(&bindingFlagsCreateInfo)
+    .setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+    .setBindings(samplerBinding)
+    .setBindingCount(1);
+
+  descriptorSetLayout = device.createDescriptorSetLayout(descriptorSetLayoutCreateInfo, nullptr);
+
+  vk::DescriptorSetVariableDescriptorCountAllocateInfo variableCountAllocateInfo = vk::DescriptorSetVariableDescriptorCountAllocateInfo{}
+    .setDescriptorCounts(capacity)
+    .setDescriptorSetCount(1);
+
+  vk::DescriptorSetAllocateInfo allocateInfo = vk::DescriptorSetAllocateInfo{}
+    .setPNext(&variableCountAllocateInfo)
+    .setDescriptorPool(descriptorPool)
+    .setDescriptorSetCount(1)
+    .setSetLayouts(descriptorSetLayout);
+
+  descriptorSet = device.allocateDescriptorSets(allocateInfo)[0];
+}
+
+uint32_t BindlessTextures::add(const vk::Device& device, const vk::Sampler& sampler, const vk::ImageView& view) {
+  uint32_t index;
+
+  if (!freeIndices.empty()) {
+    index = freeIndices.back();
+    freeIndices.pop_back();
+  } else if (count < capacity) {
+    index = count++;
+  } else {
+    throw std::runtime_error{"Bindless texture table is full"};
+  }
+
+  write(device, index, sampler, view);
+
+  return index;
+}
+
+void BindlessTextures::write(const vk::Device& device, const uint32_t index, const vk::Sampler& sampler, const vk::ImageView& view) {
+  vk::DescriptorImageInfo imageInfo = vk::DescriptorImageInfo{}
+    .setSampler(sampler)
+    .setImageView(view)
+    .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  vk::WriteDescriptorSet samplerWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(0)
+    .setDstArrayElement(index)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+    .setImageInfo(imageInfo);
+
+  device.updateDescriptorSets(1, &samplerWrite, 0, nullptr);
+}
+
+void BindlessTextures::release(const uint32_t index) {
+  freeIndices.push_back(index);
+}
+
+void BindlessTextures::destroy(const vk::Device& device) {
+  device.destroyDescriptorSetLayout(descriptorSetLayout);
+  device.destroyDescriptorPool(descriptorPool);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+class BindlessTextures {
+public:
+  vk::DescriptorPool descriptorPool;
+  vk::DescriptorSetLayout descriptorSetLayout;
+  vk::DescriptorSet descriptorSet;
+
+  uint32_t capacity = 0;
+  uint32_t count = 0;
+
+  BindlessTextures();
+  BindlessTextures(const vk::Device& device, const uint32_t capacity);
+
+  uint32_t add(const vk::Device& device, const vk::Sampler& sampler, const vk::ImageView& view);
+  void write(const vk::Device& device, const uint32_t index, const vk::Sampler& sampler, const vk::ImageView& view);
+  void release(const uint32_t index);
+
+  void destroy(const vk::Device& device);
+private:
+  std::vector<uint32_t> freeIndices;
+
+  void createDescriptors(const vk::Device& device);
+};
@@ -1,7 +1,25 @@
 #include "stb_image.h"
 #include "buffer.hpp"
+#include "memory-stats.hpp"
 #include "vk-utils.hpp"
 
+static MemoryCategory categoryFor(const vk::BufferUsageFlags usage) {
+  if (usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer)) {
+    return MemoryCategory::Mesh;
+  }
+  if (usage & vk::BufferUsageFlagBits::eUniformBuffer) {
+    return MemoryCategory::Uniform;
+  }
+  if (usage & (vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer)) {
+    return MemoryCategory::Storage;
+  }
+  if (usage == vk::BufferUsageFlagBits::eTransferSrc) {
+    return MemoryCategory::Staging;
+  }
+
+  return MemoryCategory::Other;
+}
+
 Buffer::Buffer() {
 }
 
@@ -18,15 +36,16 @@ Buffer::Buffer(const VmaAllocator& allocator, const void* data, const uint32_t s
   VkBuffer b;
 
   vmaCreateBuffer(allocator, &bufferCreateInfo, &bufferAllocationCreateInfo, &b, &allocation, nullptr);
+  memory::track(allocator, allocation, categoryFor(usage));
   vmaCopyMemoryToAllocation(allocator, data, allocation, 0, size);
 
   buffer = b;
 };
 
-Buffer::Buffer(const VmaAllocator& allocator, const uint32_t s, const vk::BufferUsageFlagBits usage): size{s} {
+Buffer::Buffer(const VmaAllocator& allocator, const uint32_t s, const vk::BufferUsageFlags usage, const VmaAllocationCreateFlags allocationFlags): size{s} {
   VmaAllocationCreateInfo bufferAllocationCreateInfo{};
   bufferAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO; 
-  bufferAllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+  bufferAllocationCreateInfo.flags = allocationFlags;
 
   VkBufferCreateInfo bufferCreateInfo = vk::BufferCreateInfo{}
     .setSize(size)
@@ -36,13 +55,12 @@ Buffer::Buffer(const VmaAllocator& allocator, const uint32_t s, const vk::Buffer
   VkBuffer b;
 
   vmaCreateBuffer(allocator, &bufferCreateInfo, &bufferAllocationCreateInfo, &b, &allocation, nullptr);
+  memory::track(allocator, allocation, categoryFor(usage));
 
   buffer = b;
 }
 
-void Buffer::copyToImage(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Image& image, unsigned char* srcData, const vk::Extent3D& extent) {
-  Buffer stagingBuffer = Buffer{allocator, srcData, size, vk::BufferUsageFlagBits::eTransferSrc};
-
+void Buffer::copyToImage(const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Image& image, const vk::Extent3D& extent) {
   vk::ImageSubresourceLayers imageSubresourceLayers  = vk::ImageSubresourceLayers{}
     .setLayerCount(1)
     .setAspectMask(vk::ImageAspectFlagBits::eColor)
@@ -58,7 +76,7 @@ void Buffer::copyToImage(const VmaAllocator& allocator, const vk::Device& device
     .setImageSubresource(imageSubresourceLayers);
 
   vk::CopyBufferToImageInfo2 copyInfo = vk::CopyBufferToImageInfo2{}
-    .setSrcBuffer(stagingBuffer.buffer)
+    .setSrcBuffer(buffer)
     .setDstImage(image)
     .setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
     .setRegionCount(1)
@@ -69,10 +87,9 @@ void Buffer::copyToImage(const VmaAllocator& allocator, const vk::Device& device
   commandBuffer.copyBufferToImage2(copyInfo);
 
   utils::endSingleSubmitCommand(device, commandPool, commandBuffer, transferQueue);
-  
-  stagingBuffer.destroy(allocator);
 };
 
 void Buffer::destroy(const VmaAllocator& allocator) {
+  memory::untrack(allocator, allocation);
   vmaDestroyBuffer(allocator, buffer, allocation);
 }
@@ -6,14 +6,14 @@
 class Buffer {
 public:
   vk::Buffer buffer;
-  VmaAllocation allocation;
+  VmaAllocation allocation = VK_NULL_HANDLE;
   uint32_t size;
 
   Buffer();
-  Buffer(const VmaAllocator& allocator, const uint32_t size, const vk::BufferUsageFlagBits usage);
+  Buffer(const VmaAllocator& allocator, const uint32_t size, const vk::BufferUsageFlags usage, const VmaAllocationCreateFlags allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
   Buffer(const VmaAllocator& allocator, const void* data, const uint32_t size, const vk::BufferUsageFlagBits usage);
 
-  void copyToImage(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Image& image, unsigned char* srcData, const vk::Extent3D& extent);
+  void copyToImage(const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Image& image, const vk::Extent3D& extent);
 
   void destroy(const VmaAllocator& allocator);
 };
@@ -0,0 +1,183 @@
+#include "clustered-lights.hpp"
+
+#include <stdexcept>
+
+static const uint32_t INITIAL_CAPACITY = 64;
+static const uint32_t WORKGROUP_SIZE = 64;
+static const uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+ClusteredLights::ClusteredLights() {
+}
+
+ClusteredLights::ClusteredLights(const VmaAllocator& allocator, const vk::Device& device, const uint32_t frameCount, const vk::DescriptorSetLayout& descriptorSetLayout) {
+  for (size_t i = 0; i < frameCount; i++) {
+    lightBuffers.push_back(Buffer{allocator, sizeof(PointLight) * INITIAL_CAPACITY, vk::BufferUsageFlagBits::eStorageBuffer});
+    paramBuffers.push_back(Buffer{allocator, sizeof(ClusterParams), vk::BufferUsageFlagBits::eUniformBuffer});
+    clusterBuffers.push_back(Buffer{allocator, sizeof(uint32_t) * CLUSTER_STRIDE * CLUSTER_COUNT, vk::BufferUsageFlagBits::eStorageBuffer, 0});
+  }
+
+  createPipeline(device, descriptorSetLayout);
+}
+
+void ClusteredLights::createPipeline(const vk::Device& device, const vk::DescriptorSetLayout& descriptorSetLayout) {
+  Shader shader{device, "./shaders/cluster-lights.comp.spv"};
+
+  vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
+    .setSetLayouts(descriptorSetLayout)
+    .setSetLayoutCount(1);
+
+  pipelineLayout = device.createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
+
+  vk::PipelineShaderStageCreateInfo computeShaderStage = vk::PipelineShaderStageCreateInfo{}
+    .setStage(vk::ShaderStageFlagBits::eCompute)
+    .setModule(shader.module)
+    .setPName("main");
+
+  vk::ComputePipelineCreateInfo computePipelineCreateInfo = vk::ComputePipelineCreateInfo{}
+    .setStage(computeShaderStage)
+    .setLayout(pipelineLayout);
+
+  vk::ResultValue<vk::Pipeline> pipelineResult = device.createComputePipeline(VK_NULL_HANDLE, computePipelineCreateInfo);
+
+  shader.destroy(device);
+
+  if (pipelineResult.result != vk::Result::eSuccess) {
+    throw std::runtime_error{"Failed to create the light clustering pipeline"};
+  }
+
+  pipeline = pipelineResult.value;
+}
+
+void ClusteredLights::reloadPipeline(const vk::Device& device, const vk::DescriptorSetLayout& descriptorSetLayout, DeletionQueue& deletionQueue, const uint64_t serial) {
+  vk::PipelineLayout oldPipelineLayout = pipelineLayout;
+  vk::Pipeline oldPipeline = pipeline;
+
+  try {
+    createPipeline(device, descriptorSetLayout);
+  } catch (const std::exception&) {
+    if (pipelineLayout != oldPipelineLayout) {
+      device.destroyPipelineLayout(pipelineLayout);
+    }
+
+    pipelineLayout = oldPipelineLayout;
+    pipeline = oldPipeline;
+    throw;
+  }
+
+  deletionQueue.push(serial, [=]() {
+    device.destroyPipeline(oldPipeline);
+    device.destroyPipelineLayout(oldPipelineLayout);
+  });
+}
+
+void ClusteredLights::update(const VmaAllocator& allocator, const uint32_t frame, const std::vector<PointLight>& lights, const Projection& projection, const vk::Extent2D& extent) {
+  Buffer& lightBuffer = lightBuffers[frame];
+
+  uint32_t capacity = lightBuffer.size / sizeof(PointLight);
+
+  if (lights.size() > capacity) {
+    while (capacity < lights.size()) {
+      capacity *= 2;
+    }
+
+    lightBuffer.destroy(allocator);
+    lightBuffer = Buffer{allocator, static_cast<uint32_t>(sizeof(PointLight) * capacity), vk::BufferUsageFlagBits::eStorageBuffer};
+  }
+
+  if (!lights.empty()) {
+    vmaCopyMemoryToAllocation(allocator, lights.data(), lightBuffer.allocation, 0, sizeof(PointLight) * lights.size());
+  }
+
+  // glm::perspective uses the -1..1 depth convention, so near and far fall out of the third column
+  const glm::mat4& perspective = projection.perspective;
+  float near = perspective[3][2] / (perspective[2][2] - 1.0f);
+  float far = perspective[3][2] / (perspective[2][2] + 1.0f);
+
+  ClusterParams params{};
+  params.view = projection.view;
+  params.inverseProjection = glm::inverse(perspective);
+  params.grid = glm::uvec4{CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, static_cast<uint32_t>(lights.size())};
+  params.screen = glm::vec4{extent.width, extent.height, near, far};
+
+  vmaCopyMemoryToAllocation(allocator, &params, paramBuffers[frame].allocation, 0, sizeof(ClusterParams));
+}
+
+vk::DescriptorSet ClusteredLights::allocateDescriptorSet(const vk::Device& device, DescriptorAllocator& descriptorAllocator, const vk::DescriptorSetLayout& descriptorSetLayout, const uint32_t frame, const Buffer& lightUbo) {
+  vk::DescriptorSet descriptorSet = descriptorAllocator.allocate(device, descriptorSetLayout);
+
+  vk::DescriptorBufferInfo lightInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(lightUbo.buffer)
+    .setRange(VK_WHOLE_SIZE)
+    .setOffset(0);
+
+  vk::DescriptorBufferInfo paramsInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(paramBuffers[frame].buffer)
+    .setRange(sizeof(ClusterParams))
+    .setOffset(0);
+
+  vk::DescriptorBufferInfo pointLightsInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(lightBuffers[frame].buffer)
+    .setRange(VK_WHOLE_SIZE)
+    .setOffset(0);
+
+  vk::DescriptorBufferInfo clustersInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(clusterBuffers[frame].buffer)
+    .setRange(VK_WHOLE_SIZE)
+    .setOffset(0);
+
+  vk::WriteDescriptorSet lightWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(0)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eUniformBuffer)
+    .setBufferInfo(lightInfo);
+
+  vk::WriteDescriptorSet paramsWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(1)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eUniformBuffer)
+    .setBufferInfo(paramsInfo);
+
+  vk::WriteDescriptorSet pointLightsWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(2)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+    .setBufferInfo(pointLightsInfo);
+
+  vk::WriteDescriptorSet clustersWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(3)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+    .setBufferInfo(clustersInfo);
+
+  std::vector<vk::WriteDescriptorSet> writes{
+    lightWrite,
+    paramsWrite,
+    pointLightsWrite,
+    clustersWrite,
+  };
+
+  device.updateDescriptorSets(writes.size(), writes.data(), 0, nullptr);
+
+  return descriptorSet;
+}
+
+void ClusteredLights::dispatch(vk::CommandBuffer& commandBuffer, const vk::DescriptorSet& descriptorSet) {
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+  commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+  commandBuffer.dispatch((CLUSTER_COUNT + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+}
+
+void ClusteredLights::destroy(const VmaAllocator& allocator, const vk::Device& device) {
+  device.destroyPipeline(pipeline);
+  device.destroyPipelineLayout(pipelineLayout);
+
+  for (size_t i = 0; i < lightBuffers.size(); i++) {
+    lightBuffers[i].destroy(allocator);
+    paramBuffers[i].destroy(allocator);
+    clusterBuffers[i].destroy(allocator);
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+#include "buffer.hpp"
+#include "deletion-queue.hpp"
+#include "descriptor-allocator.hpp"
+#include "scene.hpp"
+#include "vk-shader.hpp"
+#include "vk_mem_alloc.h"
+
+const uint32_t CLUSTER_GRID_X = 16;
+const uint32_t CLUSTER_GRID_Y = 9;
+const uint32_t CLUSTER_GRID_Z = 24;
+const uint32_t CLUSTER_STRIDE = 128;
+
+struct PointLight {
+  alignas(16) glm::vec3 pos = glm::vec3{0.0f};
+  alignas(4) float radius = 1.0f;
+  alignas(16) glm::vec3 color = glm::vec3{1.0f};
+  alignas(4) float intensity = 1.0f;
+};
+
+struct ClusterParams {
+  alignas(16) glm::mat4 view;
+  alignas(16) glm::mat4 inverseProjection;
+  alignas(16) glm::uvec4 grid;
+  alignas(16) glm::vec4 screen;
+};
+
+class ClusteredLights {
+public:
+  std::vector<Buffer> lightBuffers;
+  std::vector<Buffer> paramBuffers;
+  std::vector<Buffer> clusterBuffers;
+
+  vk::PipelineLayout pipelineLayout;
+  vk::Pipeline pipeline;
+
+  ClusteredLights();
+  ClusteredLights(const VmaAllocator& allocator, const vk::Device& device, const uint32_t frameCount, const vk::DescriptorSetLayout& descriptorSetLayout);
+
+  void update(const VmaAllocator& allocator, const uint32_t frame, const std::vector<PointLight>& lights, const Projection& projection, const vk::Extent2D& extent);
+  vk::DescriptorSet allocateDescriptorSet(const vk::Device& device, DescriptorAllocator& descriptorAllocator, const vk::DescriptorSetLayout& descriptorSetLayout, const uint32_t frame, const Buffer& lightUbo);
+  void dispatch(vk::CommandBuffer& commandBuffer, const vk::DescriptorSet& descriptorSet);
+  void reloadPipeline(const vk::Device& device, const vk::DescriptorSetLayout& descriptorSetLayout, DeletionQueue& deletionQueue, const uint64_t serial);
+
+  void destroy(const VmaAllocator& allocator, const vk::Device& device);
+private:
+  void createPipeline(const vk::Device& device, const vk::DescriptorSetLayout& descriptorSetLayout);
+};
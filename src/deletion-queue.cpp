@@ -0,0 +1,25 @@
+#include "deletion-queue.hpp"
+
+#include <utility>
+
+void DeletionQueue::push(const uint64_t serial, std::function<void()>&& deleter) {
+  entries.push_back(Entry{serial, std::move(deleter)});
+}
+
+void DeletionQueue::flush(const uint64_t completedSerial) {
+  while (!entries.empty() && entries.front().serial <= completedSerial) {
+    entries.front().deleter();
+    entries.pop_front();
+  }
+}
+
+void DeletionQueue::flushAll() {
+  while (!entries.empty()) {
+    entries.front().deleter();
+    entries.pop_front();
+  }
+}
+
+size_t DeletionQueue::size() const {
+  return entries.size();
+}
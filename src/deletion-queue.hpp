@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+class DeletionQueue {
+public:
+  void push(const uint64_t serial, std::function<void()>&& deleter);
+  void flush(const uint64_t completedSerial);
+  void flushAll();
+
+  size_t size() const;
+private:
+  struct Entry {
+    uint64_t serial;
+    std::function<void()> deleter;
+  };
+
+  std::deque<Entry> entries;
+};
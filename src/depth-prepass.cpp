@@ -0,0 +1,224 @@
+#include "depth-prepass.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include "vk-pipeline.hpp"
+
+DepthPrepass::DepthPrepass() {
+}
+
+DepthPrepass::DepthPrepass(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts) {
+  createPipeline(device, descriptorSetLayouts);
+}
+
+void DepthPrepass::createPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts) {
+  Shader vertexShader{device, "./shaders/depth.vert.spv"};
+
+  vk::PipelineShaderStageCreateInfo vertexShaderStage = vk::PipelineShaderStageCreateInfo{}
+    .setStage(vk::ShaderStageFlagBits::eVertex)
+    .setModule(vertexShader.module)
+    .setPName("main");
+
+  vk::PipelineRenderingCreateInfo pipelineRenderingCreateInfo = vk::PipelineRenderingCreateInfo{}
+    .setColorAttachmentCount(0)
+    .setDepthAttachmentFormat(vk::Format::eD32Sfloat);
+
+  vk::VertexInputBindingDescription inputBinding = vk::VertexInputBindingDescription{}
+    .setStride(sizeof(float) * 3)
+    .setInputRate(vk::VertexInputRate::eVertex)
+    .setBinding(0);
+
+  vk::VertexInputAttributeDescription positionAttribute = vk::VertexInputAttributeDescription{}
+    .setBinding(0)
+    .setLocation(0)
+    .setOffset(0)
+    .setFormat(vk::Format::eR32G32B32Sfloat);
+
+  vk::PipelineVertexInputStateCreateInfo vertexInputState = vk::PipelineVertexInputStateCreateInfo{}
+    .setVertexBindingDescriptions(inputBinding)
+    .setVertexBindingDescriptionCount(1)
+    .setVertexAttributeDescriptions(positionAttribute)
+    .setVertexAttributeDescriptionCount(1);
+
+  vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState = vk::PipelineInputAssemblyStateCreateInfo{}
+    .setTopology(vk::PrimitiveTopology::eTriangleList)
+    .setPrimitiveRestartEnable(0);
+
+  vk::PipelineViewportStateCreateInfo viewportState = vk::PipelineViewportStateCreateInfo{}
+    .setViewportCount(1)
+    .setScissorCount(1);
+
+  vk::PipelineRasterizationStateCreateInfo rasterizationState = vk::PipelineRasterizationStateCreateInfo{}
+    .setRasterizerDiscardEnable(0)
+    .setDepthClampEnable(0)
+    .setDepthBiasEnable(0)
+    .setPolygonMode(vk::PolygonMode::eFill)
+    .setCullMode(vk::CullModeFlagBits::eBack)
+    .setFrontFace(vk::FrontFace::eCounterClockwise)
+    .setLineWidth(1.0f);
+
+  vk::PipelineMultisampleStateCreateInfo multisampleState = vk::PipelineMultisampleStateCreateInfo{}
+    .setRasterizationSamples(vk::SampleCountFlagBits::e1)
+    .setSampleShadingEnable(0);
+
+  vk::PipelineDepthStencilStateCreateInfo depthStencilState = vk::PipelineDepthStencilStateCreateInfo{}
+    .setDepthTestEnable(1)
+    .setDepthWriteEnable(1)
+    .setStencilTestEnable(0)
+    .setDepthBoundsTestEnable(0)
+    .setDepthCompareOp(vk::CompareOp::eLessOrEqual);
+
+  vk::PipelineColorBlendStateCreateInfo colorBlendState = vk::PipelineColorBlendStateCreateInfo{}
+    .setAttachmentCount(0);
+
+  vk::DynamicState dynamicStates[2] = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+
+  vk::PipelineDynamicStateCreateInfo dynamicState = vk::PipelineDynamicStateCreateInfo{}
+    .setDynamicStates(dynamicStates)
+    .setDynamicStateCount(2);
+
+  vk::PushConstantRange pushConstantRange = vk::PushConstantRange{}
+    .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment)
+    .setOffset(0)
+    .setSize(sizeof(DrawConstants));
+
+  vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
+    .setSetLayouts(descriptorSetLayouts)
+    .setSetLayoutCount(descriptorSetLayouts.size())
+    .setPushConstantRanges(pushConstantRange)
+    .setPushConstantRangeCount(1);
+
+  pipelineLayout = device.createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
+
+  vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo = vk::GraphicsPipelineCreateInfo{}
+    .setPNext(&pipelineRenderingCreateInfo)
+    .setStages(vertexShaderStage)
+    .setStageCount(1)
+    .setPVertexInputState(&vertexInputState)
+    .setPInputAssemblyState(&inputAssemblyState)
+    .setPViewportState(&viewportState)
+    .setPRasterizationState(&rasterizationState)
+    .setPMultisampleState(&multisampleState)
+    .setPDepthStencilState(&depthStencilState)
+    .setPColorBlendState(&colorBlendState)
+    .setPDynamicState(&dynamicState)
+    .setLayout(pipelineLayout);
+
+  vk::ResultValue<vk::Pipeline> pipelineResult = device.createGraphicsPipeline(VK_NULL_HANDLE, graphicsPipelineCreateInfo);
+
+  vertexShader.destroy(device);
+
+  if (pipelineResult.result != vk::Result::eSuccess) {
+    throw std::runtime_error{"Failed to create the depth pre-pass pipeline"};
+  }
+
+  pipeline = pipelineResult.value;
+}
+
+void DepthPrepass::reloadPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, DeletionQueue& deletionQueue, const uint64_t serial) {
+  vk::PipelineLayout oldPipelineLayout = pipelineLayout;
+  vk::Pipeline oldPipeline = pipeline;
+
+  try {
+    createPipeline(device, descriptorSetLayouts);
+  } catch (const std::exception&) {
+    if (pipelineLayout != oldPipelineLayout) {
+      device.destroyPipelineLayout(pipelineLayout);
+    }
+
+    pipelineLayout = oldPipelineLayout;
+    pipeline = oldPipeline;
+    throw;
+  }
+
+  deletionQueue.push(serial, [=]() {
+    device.destroyPipeline(oldPipeline);
+    device.destroyPipelineLayout(oldPipelineLayout);
+  });
+}
+
+void DepthPrepass::sort(const std::vector<Object>& objects, const TransformStorage& transforms, const glm::mat4& view) {
+  glm::vec3 forward = glm::vec3{view[0][2], view[1][2], view[2][2]};
+
+  keys.resize(objects.size());
+
+  for (size_t i = 0; i < objects.size(); i++) {
+    glm::vec3 position = glm::vec3{transforms.models[i][3]};
+    keys[i] = SortKey{-(glm::dot(forward, position) + view[3][2]), static_cast<uint32_t>(i)};
+  }
+
+  std::sort(keys.begin(), keys.end(), [](const SortKey& a, const SortKey& b) {
+    return a.depth < b.depth;
+  });
+
+  order.resize(keys.size());
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    order[i] = keys[i].objectIdx;
+  }
+}
+
+void DepthPrepass::record(
+  vk::CommandBuffer& commandBuffer,
+  const vk::ImageView& depthView,
+  const vk::Viewport& viewport,
+  const vk::Rect2D& scissors,
+  const vk::DescriptorSet& projectionSet,
+  const vk::DescriptorSet& objectSet,
+  const vk::Buffer& drawBuffer,
+  const std::vector<Object>& objects,
+  const std::vector<Mesh>& meshes
+) {
+  vk::ClearValue clearValue = vk::ClearValue{}
+    .setDepthStencil(vk::ClearDepthStencilValue{1.0f, 0});
+
+  vk::RenderingAttachmentInfo depthAttachment = vk::RenderingAttachmentInfo{}
+    .setImageView(depthView)
+    .setImageLayout(vk::ImageLayout::eDepthAttachmentOptimal)
+    .setLoadOp(vk::AttachmentLoadOp::eClear)
+    .setStoreOp(vk::AttachmentStoreOp::eStore)
+    .setClearValue(clearValue);
+
+  vk::RenderingInfo renderingInfo = vk::RenderingInfo{}
+    .setRenderArea(scissors)
+    .setLayerCount(1)
+    .setViewMask(0)
+    .setColorAttachmentCount(0)
+    .setPDepthAttachment(&depthAttachment);
+
+  commandBuffer.beginRendering(renderingInfo);
+
+  commandBuffer.setViewport(0, 1, &viewport);
+  commandBuffer.setScissor(0, 1, &scissors);
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+
+  std::vector<vk::DescriptorSet> sets{projectionSet, objectSet};
+  commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 1, sets.size(), sets.data(), 0, nullptr);
+
+  vk::DeviceSize offsets[1] = {0};
+
+  for (uint32_t objectIdx : order) {
+    const Object& object = objects[objectIdx];
+    const Mesh& mesh = meshes[object.meshIdx];
+
+    DrawConstants constants{objectIdx, object.materialIdx, 0};
+
+    commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(DrawConstants), &constants);
+    commandBuffer.bindVertexBuffers(0, 1, &mesh.positionBuffer.buffer, offsets);
+    commandBuffer.bindIndexBuffer(mesh.indexBuffer.buffer, 0, vk::IndexType::eUint16);
+
+    // With occlusion culling the same draws as the early forward pass, so rejected objects cost nothing here either
+    if (drawBuffer) {
+      commandBuffer.drawIndexedIndirect(drawBuffer, objectIdx * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
+    } else {
+      commandBuffer.drawIndexed(mesh.indicesCount, 1, 0, 0, 0);
+    }
+  }
+
+  commandBuffer.endRendering();
+}
+
+void DepthPrepass::destroy(const vk::Device& device) {
+  device.destroyPipeline(pipeline);
+  device.destroyPipelineLayout(pipelineLayout);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+#include "deletion-queue.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include "transform.hpp"
+#include "vk-shader.hpp"
+
+class DepthPrepass {
+public:
+  vk::PipelineLayout pipelineLayout;
+  vk::Pipeline pipeline;
+
+  std::vector<uint32_t> order;
+
+  DepthPrepass();
+  DepthPrepass(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts);
+
+  void sort(const std::vector<Object>& objects, const TransformStorage& transforms, const glm::mat4& view);
+  void record(
+    vk::CommandBuffer& commandBuffer,
+    const vk::ImageView& depthView,
+    const vk::Viewport& viewport,
+    const vk::Rect2D& scissors,
+    const vk::DescriptorSet& projectionSet,
+    const vk::DescriptorSet& objectSet,
+    const vk::Buffer& drawBuffer,
+    const std::vector<Object>& objects,
+    const std::vector<Mesh>& meshes
+  );
+  void reloadPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, DeletionQueue& deletionQueue, const uint64_t serial);
+
+  void destroy(const vk::Device& device);
+private:
+  struct SortKey {
+    float depth;
+    uint32_t objectIdx;
+  };
+
+  std::vector<SortKey> keys;
+
+  void createPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts);
+};
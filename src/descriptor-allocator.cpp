@@ -0,0 +1,126 @@
+#include "descriptor-allocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static const uint32_t MAX_SETS_PER_POOL = 4096;
+
+DescriptorAllocator::DescriptorAllocator() {
+}
+
+DescriptorAllocator::DescriptorAllocator(const vk::Device& device, const uint32_t s, const std::vector<PoolSizeRatio>& r): ratios{r}, setsPerPool{s} {
+  readyPools.push_back(createPool(device, setsPerPool));
+}
+
+vk::DescriptorPool DescriptorAllocator::createPool(const vk::Device& device, const uint32_t setCount) {
+  std::vector<vk::DescriptorPoolSize> poolSizes;
+
+  for (const PoolSizeRatio& ratio : ratios) {
+    poolSizes.push_back(
+      vk::DescriptorPoolSize{}
+        .setType(ratio.type)
+        .setDescriptorCount(std::max(1u, static_cast<uint32_t>(ratio.ratio * setCount)))
+    );
+  }
+
+  vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo = vk::DescriptorPoolCreateInfo{}
+    .setMaxSets(setCount)
+    .setPoolSizes(poolSizes)
+    .setPoolSizeCount(poolSizes.size());
+
+  return device.createDescriptorPool(descriptorPoolCreateInfo, nullptr);
+}
+
+vk::DescriptorPool DescriptorAllocator::getPool(const vk::Device& device) {
+  if (!readyPools.empty()) {
+    vk::DescriptorPool pool = readyPools.back();
+    readyPools.pop_back();
+    return pool;
+  }
+
+  setsPerPool = std::min(setsPerPool + setsPerPool / 2, MAX_SETS_PER_POOL);
+
+  return createPool(device, setsPerPool);
+}
+
+vk::DescriptorSet DescriptorAllocator::allocate(const vk::Device& device, const vk::DescriptorSetLayout& layout) {
+  for (size_t i = 0; i < recycled.size(); i++) {
+    if (recycled[i].layout == layout) {
+      vk::DescriptorSet set = recycled[i].set;
+      recycled.erase(recycled.begin() + i);
+      return set;
+    }
+  }
+
+  vk::DescriptorPool pool = getPool(device);
+
+  vk::DescriptorSetAllocateInfo allocateInfo = vk::DescriptorSetAllocateInfo{}
+    .setDescriptorPool(pool)
+    .setDescriptorSetCount(1)
+    .setSetLayouts(layout);
+
+  vk::DescriptorSet set;
+  vk::Result result = device.allocateDescriptorSets(&allocateInfo, &set);
+
+  if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool) {
+    fullPools.push_back(pool);
+
+    pool = getPool(device);
+    allocateInfo.setDescriptorPool(pool);
+
+    result = device.allocateDescriptorSets(&allocateInfo, &set);
+  }
+
+  if (result != vk::Result::eSuccess) {
+    throw std::runtime_error{"Failed to allocate a descriptor set"};
+  }
+
+  readyPools.push_back(pool);
+
+  return set;
+}
+
+std::vector<vk::DescriptorSet> DescriptorAllocator::allocate(const vk::Device& device, const vk::DescriptorSetLayout& layout, const uint32_t count) {
+  std::vector<vk::DescriptorSet> sets(count);
+
+  for (size_t i = 0; i < count; i++) {
+    sets[i] = allocate(device, layout);
+  }
+
+  return sets;
+}
+
+// The pools are not created with FREE_DESCRIPTOR_SET, so released sets are handed out again to the next allocation with their layout
+void DescriptorAllocator::release(const vk::DescriptorSetLayout& layout, const std::vector<vk::DescriptorSet>& sets) {
+  for (const vk::DescriptorSet& set : sets) {
+    recycled.push_back(RecycledSet{layout, set});
+  }
+}
+
+void DescriptorAllocator::reset(const vk::Device& device) {
+  recycled.clear();
+  for (vk::DescriptorPool& pool : readyPools) {
+    device.resetDescriptorPool(pool);
+  }
+
+  for (vk::DescriptorPool& pool : fullPools) {
+    device.resetDescriptorPool(pool);
+    readyPools.push_back(pool);
+  }
+
+  fullPools.clear();
+}
+
+void DescriptorAllocator::destroy(const vk::Device& device) {
+  for (vk::DescriptorPool& pool : readyPools) {
+    device.destroyDescriptorPool(pool);
+  }
+
+  for (vk::DescriptorPool& pool : fullPools) {
+    device.destroyDescriptorPool(pool);
+  }
+
+  readyPools.clear();
+  fullPools.clear();
+  recycled.clear();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+struct PoolSizeRatio {
+  vk::DescriptorType type;
+  float ratio;
+};
+
+class DescriptorAllocator {
+public:
+  DescriptorAllocator();
+  DescriptorAllocator(const vk::Device& device, const uint32_t setsPerPool, const std::vector<PoolSizeRatio>& ratios);
+
+  vk::DescriptorSet allocate(const vk::Device& device, const vk::DescriptorSetLayout& layout);
+  std::vector<vk::DescriptorSet> allocate(const vk::Device& device, const vk::DescriptorSetLayout& layout, const uint32_t count);
+  void release(const vk::DescriptorSetLayout& layout, const std::vector<vk::DescriptorSet>& sets);
+
+  void reset(const vk::Device& device);
+  void destroy(const vk::Device& device);
+private:
+  struct RecycledSet {
+    vk::DescriptorSetLayout layout;
+    vk::DescriptorSet set;
+  };
+
+  std::vector<PoolSizeRatio> ratios;
+  std::vector<RecycledSet> recycled;
+  std::vector<vk::DescriptorPool> fullPools;
+  std::vector<vk::DescriptorPool> readyPools;
+  uint32_t setsPerPool = 0;
+
+  vk::DescriptorPool getPool(const vk::Device& device);
+  vk::DescriptorPool createPool(const vk::Device& device, const uint32_t setCount);
+};
@@ -0,0 +1,75 @@
+#include "frame-pacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+static const FramePacer::Clock::duration SPIN_THRESHOLD = std::chrono::microseconds{1500};
+static const double SMOOTHING = 0.1;
+
+FramePacer::FramePacer(): FramePacer{0.0} {
+}
+
+FramePacer::FramePacer(const double targetFrameRate) {
+  if (targetFrameRate > 0.0) {
+    period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{1.0 / targetFrameRate});
+  }
+
+  previous = Clock::now();
+  deadline = previous + period;
+}
+
+float FramePacer::wait() {
+  if (period != Clock::duration::zero()) {
+    Clock::time_point now = Clock::now();
+
+    if (deadline - now > SPIN_THRESHOLD) {
+      std::this_thread::sleep_until(deadline - SPIN_THRESHOLD);
+    }
+
+    while (Clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+
+    deadline += period;
+
+    if (deadline < Clock::now()) {
+      deadline = Clock::now() + period;
+    }
+  }
+
+  Clock::time_point now = Clock::now();
+  double deltaTime = std::chrono::duration<double, std::milli>{now - previous}.count();
+  previous = now;
+
+  frameStats.frameTime += (deltaTime - frameStats.frameTime) * SMOOTHING;
+
+  return deltaTime;
+}
+
+void FramePacer::inputSampled(const uint64_t presentId) {
+  pendingInputs[presentId % pendingInputs.size()] = PendingInput{presentId, Clock::now()};
+}
+
+void FramePacer::presented(const uint64_t presentId, const Clock::time_point time, const bool measured) {
+  PendingInput& input = pendingInputs[presentId % pendingInputs.size()];
+
+  if (input.presentId != presentId) {
+    return;
+  }
+
+  double latency = std::chrono::duration<double, std::milli>{time - input.time}.count();
+
+  frameStats.inputLatency += (latency - frameStats.inputLatency) * SMOOTHING;
+  frameStats.maxInputLatency = std::max(frameStats.maxInputLatency, latency);
+  frameStats.latencyMeasured = measured;
+
+  input.presentId = 0;
+}
+
+const FrameStats& FramePacer::stats() const {
+  return frameStats;
+}
+
+void FramePacer::resetStats() {
+  frameStats.maxInputLatency = 0.0;
+}
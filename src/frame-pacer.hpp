@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+struct FrameStats {
+  double frameTime = 0.0;
+  double inputLatency = 0.0;
+  double maxInputLatency = 0.0;
+  bool latencyMeasured = false;
+};
+
+class FramePacer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  FramePacer();
+  FramePacer(const double targetFrameRate);
+
+  float wait();
+
+  void inputSampled(const uint64_t presentId);
+  void presented(const uint64_t presentId, const Clock::time_point time, const bool measured);
+
+  const FrameStats& stats() const;
+  void resetStats();
+private:
+  struct PendingInput {
+    uint64_t presentId = 0;
+    Clock::time_point time;
+  };
+
+  Clock::duration period = Clock::duration::zero();
+  Clock::time_point deadline;
+  Clock::time_point previous;
+
+  std::array<PendingInput, 16> pendingInputs;
+  FrameStats frameStats;
+};
@@ -1,6 +1,11 @@
+#include <fcntl.h>
 #include <fstream>
 #include <stdexcept>
 #include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
 #include <vector>
 #include "fs.hpp"
 
@@ -19,3 +24,71 @@ std::vector<char> fs::readFile(const std::string_view path) {
 
   return bytes;
 };
+
+fs::MappedFile::MappedFile() {
+}
+
+fs::MappedFile::MappedFile(const std::string_view path) {
+  int fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    throw std::runtime_error{std::string{"Failed to open file: "} + path.data()};
+  }
+
+  struct stat info;
+
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw std::runtime_error{std::string{"Failed to stat file: "} + path.data()};
+  }
+
+  length = info.st_size;
+
+  if (length > 0) {
+    mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      close(fd);
+      throw std::runtime_error{std::string{"Failed to map file: "} + path.data()};
+    }
+  }
+
+  close(fd);
+}
+
+fs::MappedFile::MappedFile(MappedFile&& other) noexcept:
+  mapping{std::exchange(other.mapping, nullptr)},
+  length{std::exchange(other.length, 0)} {
+}
+
+fs::MappedFile& fs::MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    unmap();
+    mapping = std::exchange(other.mapping, nullptr);
+    length = std::exchange(other.length, 0);
+  }
+
+  return *this;
+}
+
+fs::MappedFile::~MappedFile() {
+  unmap();
+}
+
+void fs::MappedFile::unmap() {
+  if (mapping) {
+    munmap(mapping, length);
+  }
+
+  mapping = nullptr;
+  length = 0;
+}
+
+const char* fs::MappedFile::data() const {
+  return static_cast<const char*>(mapping);
+}
+
+size_t fs::MappedFile::size() const {
+  return length;
+}
@@ -1,8 +1,28 @@
 #pragma once
 
+#include <cstddef>
 #include <string_view>
 #include <vector>
 
 namespace fs {
   std::vector<char> readFile(const std::string_view path);
+
+  class MappedFile {
+  public:
+    MappedFile();
+    MappedFile(const std::string_view path);
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* data() const;
+    size_t size() const;
+  private:
+    void* mapping = nullptr;
+    size_t length = 0;
+
+    void unmap();
+  };
 }
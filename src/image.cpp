@@ -1,12 +1,16 @@
 #include "image.hpp"
 #include "buffer.hpp"
+#include "fs.hpp"
+#include "memory-stats.hpp"
 #include "stb_image.h"
 #include "vk-utils.hpp"
 
+#include <stdexcept>
+
 Image::Image() {
 }
 
-Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Extent3D& extent, const vk::Format format, const vk::ImageUsageFlagBits usage, const vk::ImageAspectFlagBits aspectMask) {
+Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Extent3D& e, const vk::Format format, const vk::ImageUsageFlags usage, const vk::ImageAspectFlagBits aspectMask): extent{e} {
   VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{}
     .setImageType(vk::ImageType::e2D)
     .setFormat(format)
@@ -26,6 +30,7 @@ Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::
   VkImage vkImage;
 
   vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationCreateInfo, &vkImage, &allocation, nullptr);
+  memory::track(allocator, allocation, usage & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment) ? MemoryCategory::RenderTarget : MemoryCategory::Texture);
   
   image = vkImage;
 
@@ -45,11 +50,58 @@ Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::
   view = device.createImageView(imageViewCreateInfo, nullptr);
 }
 
+Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::Extent3D& e, const vk::Format format, const vk::ImageUsageFlags usage, const uint32_t m): extent{e}, mipLevels{m} {
+  VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{}
+    .setImageType(vk::ImageType::e2D)
+    .setFormat(format)
+    .setMipLevels(mipLevels)
+    .setArrayLayers(1)
+    .setSamples(vk::SampleCountFlagBits::e1)
+    .setTiling(vk::ImageTiling::eOptimal)
+    .setUsage(usage)
+    .setSharingMode(vk::SharingMode::eExclusive)
+    .setInitialLayout(vk::ImageLayout::eUndefined)
+    .setExtent(extent);
+
+  VmaAllocationCreateInfo imageAllocationCreateInfo{};
+  imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+  VkImage vkImage;
+
+  if (vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationCreateInfo, &vkImage, &allocation, nullptr) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create an image"};
+  }
+
+  memory::track(allocator, allocation, MemoryCategory::Texture);
+
+  image = vkImage;
+
+  vk::ImageSubresourceRange imageSubresourceRange = vk::ImageSubresourceRange{}
+    .setLayerCount(1)
+    .setAspectMask(vk::ImageAspectFlagBits::eColor)
+    .setBaseMipLevel(0)
+    .setLevelCount(mipLevels)
+    .setBaseArrayLayer(0);
+
+  vk::ImageViewCreateInfo imageViewCreateInfo = vk::ImageViewCreateInfo{}
+      .setImage(image)
+      .setViewType(vk::ImageViewType::e2D)
+      .setFormat(format)
+      .setSubresourceRange(imageSubresourceRange);
+
+  view = device.createImageView(imageViewCreateInfo, nullptr);
+}
+
 Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const std::string_view path, vk::ImageLayout l) {
   int height, width;
 
-  unsigned char* data = stbi_load(path.data(), reinterpret_cast<int*>(&width), reinterpret_cast<int*>(&height), nullptr, STBI_rgb_alpha);
-  
+  fs::MappedFile file{path};
+  unsigned char* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()), file.size(), &width, &height, nullptr, STBI_rgb_alpha);
+
+  if (!data) {
+    throw std::runtime_error{std::string{"Failed to decode image: "} + path.data()};
+  }
+
   extent = vk::Extent3D{}
       .setWidth(width)
       .setHeight(height)
@@ -74,6 +126,7 @@ Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::
   VkImage vkImage;
 
   vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationCreateInfo, &vkImage, &allocation, nullptr);
+  memory::track(allocator, allocation, MemoryCategory::Texture);
 
   image = vkImage;
 
@@ -94,13 +147,13 @@ Image::Image(const VmaAllocator& allocator, const vk::Device& device, const vk::
 
   uint32_t size = width * height * STBI_rgb_alpha;
   Buffer stagingBuffer{allocator, data, size, vk::BufferUsageFlagBits::eTransferSrc};
+  stbi_image_free(data);
   
   transitionImageLayout(device, commandPool, transferQueue, vk::ImageLayout::eTransferDstOptimal);
-  stagingBuffer.copyToImage(allocator, device, commandPool, transferQueue, image, data, extent);
+  stagingBuffer.copyToImage(device, commandPool, transferQueue, image, extent);
   transitionImageLayout(device, commandPool, transferQueue, l);
   
   stagingBuffer.destroy(allocator);
-  stbi_image_free(data);
 };
 
 void Image::transitionImageLayout(const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::ImageLayout& newLayout) {
@@ -138,5 +191,6 @@ void Image::transitionImageLayout(const vk::Device& device, const vk::CommandPoo
 
 void Image::destroy(const VmaAllocator& allocator, const vk::Device& device) {
   device.destroyImageView(view);
+  memory::untrack(allocator, allocation);
   vmaDestroyImage(allocator, image, allocation);
 }
@@ -7,12 +7,14 @@ class Image {
 public:
   vk::Image image;
   vk::ImageView view;
-  VmaAllocation allocation;
+  VmaAllocation allocation = VK_NULL_HANDLE;
   vk::Extent3D extent;
+  uint32_t mipLevels = 1;
   vk::ImageLayout layout = vk::ImageLayout::eUndefined;
 
   Image();
-  Image(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Extent3D& extent, const vk::Format format, const vk::ImageUsageFlagBits usage, const vk::ImageAspectFlagBits aspectMask);
+  Image(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::Extent3D& extent, const vk::Format format, const vk::ImageUsageFlags usage, const vk::ImageAspectFlagBits aspectMask);
+  Image(const VmaAllocator& allocator, const vk::Device& device, const vk::Extent3D& extent, const vk::Format format, const vk::ImageUsageFlags usage, const uint32_t mipLevels);
   Image(const VmaAllocator& allocator, const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const std::string_view path, const vk::ImageLayout layout);
 
   void transitionImageLayout(const vk::Device& device, const vk::CommandPool& commandPool, const vk::Queue& transferQueue, const vk::ImageLayout& newLayout);
@@ -0,0 +1,386 @@
+#include "job-system.hpp"
+
+#include <stdexcept>
+#include "trace.hpp"
+
+static const uint32_t IDLE_SPINS = 64;
+
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local uint32_t currentWorker = UINT32_MAX;
+
+JobCounter::JobCounter() {
+}
+
+bool JobCounter::done() const {
+  return pending.load(std::memory_order_acquire) == 0;
+}
+
+JobDeque::JobDeque(): buffer(JOB_DEQUE_SIZE) {
+}
+
+bool JobDeque::push(Job* job) {
+  int64_t b = bottom.load(std::memory_order_relaxed);
+  int64_t t = top.load(std::memory_order_acquire);
+
+  if (b - t >= static_cast<int64_t>(JOB_DEQUE_SIZE)) {
+    return false;
+  }
+
+  buffer[b & (JOB_DEQUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+  bottom.store(b + 1, std::memory_order_release);
+  return true;
+}
+
+Job* JobDeque::pop() {
+  int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+  bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t t = top.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Job* job = buffer[b & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+
+  // Last job left, race any thief for it
+  if (t == b) {
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  return job;
+}
+
+Job* JobDeque::steal() {
+  int64_t t = top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t b = bottom.load(std::memory_order_acquire);
+
+  if (t >= b) {
+    return nullptr;
+  }
+
+  Job* job = buffer[t & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+
+  if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;
+  }
+
+  return job;
+}
+
+bool JobDeque::empty() const {
+  return top.load(std::memory_order_relaxed) >= bottom.load(std::memory_order_relaxed);
+}
+
+JobSystem::JobSystem() {
+}
+
+JobSystem::~JobSystem() {
+  stop();
+}
+
+void JobSystem::start(const uint32_t workerCount) {
+  if (running) {
+    throw std::runtime_error{"Job system is already running"};
+  }
+
+  uint32_t count = workerCount > 0 ? workerCount : std::max(std::thread::hardware_concurrency(), 1u);
+
+  workers.clear();
+
+  for (uint32_t i = 0; i < count; i++) {
+    Worker& worker = workers.emplace_back();
+    worker.random = 0x9e3779b97f4a7c15ull * (i + 1);
+  }
+
+  currentSystem = this;
+  currentWorker = 0;
+  running = true;
+
+  for (uint32_t i = 1; i < count; i++) {
+    threads.emplace_back(&JobSystem::work, this, i);
+  }
+}
+
+void JobSystem::stop() {
+  if (!running) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{sleepMutex};
+    running = false;
+  }
+
+  wake.notify_all();
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  threads.clear();
+
+  if (currentSystem == this) {
+    currentSystem = nullptr;
+    currentWorker = UINT32_MAX;
+  }
+}
+
+uint32_t JobSystem::threadCount() const {
+  return workers.size();
+}
+
+uint32_t JobSystem::workerIndex() const {
+  return currentSystem == this ? currentWorker : UINT32_MAX;
+}
+
+JobStats JobSystem::stats() const {
+  JobStats stats{};
+
+  for (const Worker& worker : workers) {
+    stats.executed += worker.executed.load(std::memory_order_relaxed);
+    stats.stolen += worker.stolen.load(std::memory_order_relaxed);
+    stats.inlined += worker.inlined.load(std::memory_order_relaxed);
+  }
+
+  return stats;
+}
+
+void JobSystem::resetStats() {
+  for (Worker& worker : workers) {
+    worker.executed.store(0, std::memory_order_relaxed);
+    worker.stolen.store(0, std::memory_order_relaxed);
+    worker.inlined.store(0, std::memory_order_relaxed);
+  }
+}
+
+void JobSystem::work(const uint32_t index) {
+  currentSystem = this;
+  currentWorker = index;
+
+  trace::setThreadName("job-worker");
+
+  while (running.load(std::memory_order_relaxed)) {
+    if (runOne()) {
+      continue;
+    }
+
+    bool found = false;
+
+    for (uint32_t i = 0; i < IDLE_SPINS && !found; i++) {
+      std::this_thread::yield();
+      found = runOne();
+    }
+
+    if (found) {
+      continue;
+    }
+
+    // Park until something is queued, so idle workers leave the cores to the render thread
+    std::unique_lock<std::mutex> lock{sleepMutex};
+    sleeping.fetch_add(1);
+    wake.wait(lock, [&]() { return !running.load(std::memory_order_relaxed) || queued.load() > 0; });
+    sleeping.fetch_sub(1);
+  }
+}
+
+// Pool slots are recycled round robin, a slot still in use means the owner helps until it frees up
+Job* JobSystem::allocate() {
+  if (currentSystem != this) {
+    Job* job = new Job{};
+    job->pooled = false;
+    return job;
+  }
+
+  Worker& worker = workers[currentWorker];
+  Job& job = worker.pool[worker.nextJob++ & (JOB_POOL_SIZE - 1)];
+
+  while (job.busy.load(std::memory_order_acquire)) {
+    if (!runOne()) {
+      std::this_thread::yield();
+    }
+  }
+
+  job.busy.store(true, std::memory_order_relaxed);
+  job.pooled = true;
+  return &job;
+}
+
+void JobSystem::submit(Job* job) {
+  if (!running) {
+    execute(job);
+    return;
+  }
+
+  if (job->after && !job->after->done()) {
+    std::lock_guard<std::mutex> lock{sharedMutex};
+
+    // Checked again under the lock, the dependency may have finished and released the deferred list meanwhile
+    if (!job->after->done()) {
+      deferred.push_back(job);
+      return;
+    }
+  }
+
+  enqueue(job);
+}
+
+void JobSystem::enqueue(Job* job) {
+  if (currentSystem == this) {
+    Worker& worker = workers[currentWorker];
+
+    // A full deque means there is plenty of parallel work already, running this one now is cheapest
+    if (!worker.deque.push(job)) {
+      worker.inlined.fetch_add(1, std::memory_order_relaxed);
+      execute(job);
+      return;
+    }
+  } else {
+    std::lock_guard<std::mutex> lock{sharedMutex};
+    injected.push_back(job);
+    injectedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  queued.fetch_add(1);
+
+  if (sleeping.load() > 0) {
+    std::lock_guard<std::mutex> lock{sleepMutex};
+    wake.notify_one();
+  }
+}
+
+Job* JobSystem::find() {
+  Worker* self = currentSystem == this ? &workers[currentWorker] : nullptr;
+
+  if (self) {
+    if (Job* job = self->deque.pop()) {
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+
+  if (injectedCount.load(std::memory_order_relaxed) > 0) {
+    std::unique_lock<std::mutex> lock{sharedMutex, std::try_to_lock};
+
+    if (lock.owns_lock() && !injected.empty()) {
+      Job* job = injected.back();
+      injected.pop_back();
+      injectedCount.fetch_sub(1, std::memory_order_relaxed);
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    }
+  }
+
+  uint32_t count = workers.size();
+  uint32_t start = 0;
+
+  if (self) {
+    self->random ^= self->random << 13;
+    self->random ^= self->random >> 7;
+    self->random ^= self->random << 17;
+    start = self->random % count;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    Worker& victim = workers[(start + i) % count];
+
+    if (&victim == self || victim.deque.empty()) {
+      continue;
+    }
+
+    if (Job* job = victim.deque.steal()) {
+      queued.fetch_sub(1, std::memory_order_relaxed);
+
+      if (self) {
+        self->stolen.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      return job;
+    }
+  }
+
+  return nullptr;
+}
+
+bool JobSystem::runOne() {
+  Job* job = find();
+
+  if (!job) {
+    return false;
+  }
+
+  execute(job);
+  return true;
+}
+
+void JobSystem::execute(Job* job) {
+  JobCounter* counter = job->counter;
+
+  try {
+    job->invoke(*job);
+  } catch (...) {
+    if (!counter->failed.exchange(true)) {
+      counter->error = std::current_exception();
+    }
+  }
+
+  if (currentSystem == this) {
+    workers[currentWorker].executed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (job->pooled) {
+    job->busy.store(false, std::memory_order_release);
+  } else {
+    delete job;
+  }
+
+  // The waiter may destroy the counter as soon as this lands, so it is the last access to it
+  if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    releaseDeferred();
+  }
+}
+
+void JobSystem::releaseDeferred() {
+  std::vector<Job*> ready;
+
+  {
+    std::lock_guard<std::mutex> lock{sharedMutex};
+
+    if (deferred.empty()) {
+      return;
+    }
+
+    for (size_t i = 0; i < deferred.size();) {
+      if (deferred[i]->after->done()) {
+        ready.push_back(deferred[i]);
+        deferred[i] = deferred.back();
+        deferred.pop_back();
+      } else {
+        i++;
+      }
+    }
+  }
+
+  for (Job* job : ready) {
+    enqueue(job);
+  }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+  while (!counter.done()) {
+    if (!runOne()) {
+      std::this_thread::yield();
+    }
+  }
+
+  if (counter.failed.load(std::memory_order_acquire)) {
+    counter.failed = false;
+    std::rethrow_exception(std::exchange(counter.error, nullptr));
+  }
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+const size_t JOB_STORAGE_SIZE = 48;
+const uint32_t JOB_POOL_SIZE = 4096;
+const uint32_t JOB_DEQUE_SIZE = 4096;
+
+class JobCounter {
+public:
+  JobCounter();
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  bool done() const;
+private:
+  friend class JobSystem;
+
+  std::atomic<uint32_t> pending{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+};
+
+struct Job {
+  void (*invoke)(Job& job) = nullptr;
+  JobCounter* counter = nullptr;
+  const JobCounter* after = nullptr;
+  std::atomic<bool> busy{false};
+  bool pooled = false;
+  alignas(16) unsigned char storage[JOB_STORAGE_SIZE];
+};
+
+// Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from the top
+class JobDeque {
+public:
+  JobDeque();
+  JobDeque(const JobDeque&) = delete;
+  JobDeque& operator=(const JobDeque&) = delete;
+
+  bool push(Job* job);
+  Job* pop();
+  Job* steal();
+  bool empty() const;
+private:
+  alignas(64) std::atomic<int64_t> top{0};
+  alignas(64) std::atomic<int64_t> bottom{0};
+  alignas(64) std::vector<std::atomic<Job*>> buffer;
+};
+
+struct JobStats {
+  uint64_t executed = 0;
+  uint64_t stolen = 0;
+  uint64_t inlined = 0;
+};
+
+class JobSystem {
+public:
+  JobSystem();
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+  ~JobSystem();
+
+  // The calling thread becomes worker 0 and helps out whenever it waits
+  void start(const uint32_t workerCount = 0);
+  void stop();
+
+  template <typename F>
+  void run(JobCounter& counter, const F& function, const JobCounter* after = nullptr);
+
+  template <typename F>
+  void parallelFor(const uint32_t count, const uint32_t grain, const F& function);
+
+  void wait(JobCounter& counter);
+
+  uint32_t threadCount() const;
+  uint32_t workerIndex() const;
+  JobStats stats() const;
+  void resetStats();
+private:
+  struct Worker {
+    JobDeque deque;
+    std::vector<Job> pool = std::vector<Job>(JOB_POOL_SIZE);
+    uint32_t nextJob = 0;
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};
+    std::atomic<uint64_t> inlined{0};
+    uint64_t random = 0;
+  };
+
+  std::deque<Worker> workers;
+  std::vector<std::thread> threads;
+  std::atomic<bool> running{false};
+
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  std::atomic<uint32_t> sleeping{0};
+  std::atomic<int64_t> queued{0};
+
+  // Jobs from threads outside the pool and jobs waiting on another counter
+  std::mutex sharedMutex;
+  std::vector<Job*> injected;
+  std::atomic<uint32_t> injectedCount{0};
+  std::vector<Job*> deferred;
+
+  void work(const uint32_t index);
+  Job* allocate();
+  void submit(Job* job);
+  void enqueue(Job* job);
+  bool runOne();
+  Job* find();
+  void execute(Job* job);
+  void releaseDeferred();
+};
+
+template <typename F>
+void JobSystem::run(JobCounter& counter, const F& function, const JobCounter* after) {
+  static_assert(sizeof(F) <= JOB_STORAGE_SIZE, "Job function is too large, capture by reference instead");
+  static_assert(std::is_trivially_copyable_v<F> && std::is_trivially_destructible_v<F>, "Job function must be trivially copyable");
+
+  counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+  Job* job = allocate();
+  new (job->storage) F(function);
+  job->invoke = [](Job& j) {
+    (*std::launder(reinterpret_cast<F*>(j.storage)))();
+  };
+  job->counter = &counter;
+  job->after = after;
+
+  submit(job);
+}
+
+template <typename F>
+void JobSystem::parallelFor(const uint32_t count, const uint32_t grain, const F& function) {
+  if (count == 0) {
+    return;
+  }
+
+  // A few chunks per thread leaves room for stealing to even out uneven chunks
+  uint32_t chunks = std::min((count + std::max(grain, 1u) - 1) / std::max(grain, 1u), threadCount() * 4);
+
+  if (chunks <= 1) {
+    function(0, count);
+    return;
+  }
+
+  JobCounter counter;
+  uint32_t chunkSize = (count + chunks - 1) / chunks;
+
+  for (uint32_t begin = 0; begin < count; begin += chunkSize) {
+    uint32_t end = std::min(begin + chunkSize, count);
+    const F* f = &function;
+
+    run(counter, [f, begin, end]() {
+      (*f)(begin, end);
+    });
+  }
+
+  wait(counter);
+}
@@ -10,6 +10,7 @@ struct LightProperties {
   alignas(16) glm::vec3 pos;
   alignas(16) glm::vec3 color;
   alignas(4) float ambient;
+  alignas(4) float shadowFar;
 };
 
 class Light {
@@ -18,20 +19,8 @@ public:
 
   Buffer ubo;
 
-  vk::DescriptorSetLayout descriptorSetLayout;
-  std::vector<vk::DescriptorSet> descriptorSets;
-
   Light();
-
-  Light(
-    const VmaAllocator& allocator,
-    const vk::Device& device, 
-    const uint32_t swapchainImageCount,
-    const vk::DescriptorPool& descriptorPool,
-    const vk::DescriptorSetLayout& descriptorSetLayout
-  );
+  Light(const VmaAllocator& allocator);
 
   void destroy(const VmaAllocator& allocator);
-private:
-  void createDescriptors(const vk::DescriptorPool& descriptorPool, const vk::DescriptorSetLayout& descriptorSetLayout, const VmaAllocator& allocator, const vk::Device& device, const uint32_t swapchainImageCount);
 };
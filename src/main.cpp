@@ -4,13 +4,26 @@
 #define VMA_DYNAMIC_VULKAN_FUNCTIONS 1
 #include "vk_mem_alloc.h"
 
+#include <chrono>
+#include <cstdio>
+#include <random>
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
 #include "vk-engine.hpp"
+#include "settings.hpp"
+#include "trace.hpp"
+
+int main(int argc, char** argv) {
+  Settings settings = parseSettings(argc, argv);
+
+  trace::setThreadName("main");
+
+  if (!settings.tracePath.empty() && !trace::enabled) {
+    std::fprintf(stderr, "--trace has no effect, tracing was compiled out (configure with -DVKR_TRACE=ON)\n");
+  }
 
-int main() {
   Display display{};
   display.init();
 
@@ -28,34 +41,80 @@ int main() {
 
   engine.setProjection(proj);
   
-  engine.init(display);
+  engine.init(display, settings);
   
-  engine.loadMesh("./assets/cube.obj");
-  engine.loadMesh("./assets/suzanne.obj");
+  if (!settings.scenePath.empty()) {
+    engine.loadScene(settings.scenePath);
+  } else {
+    engine.loadMesh("./assets/cube.obj");
+    engine.loadMesh("./assets/suzanne.obj");
+
+    engine.loadTexture("./textures/default.jpg");
 
-  engine.loadTexture("./textures/default.jpg");
+    Transform obj1{};
+    obj1.position = glm::vec3{0.0, 0.0, -10.0};
+    obj1.scale = glm::vec3{2.5};
 
-  UniformBuffer obj1{};
-  obj1.translation = glm::translate(obj1.translation, glm::vec3{0.0, 0.0, -10.0});
-  obj1.scale = glm::scale(obj1.scale, glm::vec3{2.5});
+    engine.addObject(obj1, glm::vec3{0.5}, 1, 0, 2);
 
-  engine.addObject(obj1, 1, 0, 2);
+    engine.setLight(glm::vec3{0.0, 0.0, 0.0}, glm::vec3{1.0}, 0.03);
+  }
 
-  engine.setLight(glm::vec3{0.0, 0.0, 0.0}, glm::vec3{1.0}, 0.03);
+  std::mt19937 rng{1337};
+  std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+  for (uint32_t i = 0; i < settings.pointLightCount; i++) {
+    PointLight pointLight{};
+    pointLight.pos = glm::vec3{unit(rng) * 40.0f - 20.0f, unit(rng) * 20.0f - 10.0f, -unit(rng) * 40.0f};
+    pointLight.color = glm::vec3{unit(rng), unit(rng), unit(rng)};
+    pointLight.radius = 1.0f + unit(rng) * 4.0f;
+
+    engine.addPointLight(pointLight);
+  }
   
-  float previousTicks = SDL_GetTicks();
-  float deltaTime;
+  FramePacer::Clock::time_point lastReport = FramePacer::Clock::now();
 
   while (engine.isRunning) {
-    float currentTicks = SDL_GetTicks();
-    deltaTime = currentTicks - previousTicks;
-    previousTicks = currentTicks;
+    float deltaTime = engine.beginFrame();
 
     engine.processInput(deltaTime);
     engine.drawFrame(deltaTime);
 
-    SDL_Delay(1);
+    if (settings.printStats && FramePacer::Clock::now() - lastReport >= std::chrono::seconds{1}) {
+      const FrameStats& stats = engine.frameStats();
+      const ShadowStats& shadowStats = engine.shadowStats();
+      const RenderStats& renderStats = engine.renderStats();
+      MemoryReport memoryReport = engine.memoryReport();
+
+      std::printf(
+        "frame %.2f ms, input-to-present %.2f ms (max %.2f ms, %s), shadow map reused %u/%u frames, overdraw %.2fx, gpu %.2f ms at %.0f%% resolution, textures %.0f/%.0f MB, vram %.0f/%.0f MB\n",
+        stats.frameTime,
+        stats.inputLatency,
+        stats.maxInputLatency,
+        stats.latencyMeasured ? "measured" : "estimated",
+        shadowStats.reusedFrames,
+        shadowStats.reusedFrames + shadowStats.renderedFrames,
+        renderStats.overdraw,
+        renderStats.gpuTime,
+        renderStats.resolutionScale * 100.0f,
+        renderStats.textureMemory,
+        renderStats.textureBudget,
+        memoryReport.deviceUsage / (1024.0f * 1024.0f),
+        memoryReport.deviceBudget / (1024.0f * 1024.0f)
+      );
+
+      if (memoryReport.deviceUsageRatio() > 0.9f) {
+        std::fprintf(stderr, "device memory at %.0f%% of budget\n", memoryReport.deviceUsageRatio() * 100.0f);
+      }
+
+      engine.resetFrameStats();
+      lastReport = FramePacer::Clock::now();
+    }
   }
 
   engine.destroy();
+
+  if (!settings.tracePath.empty()) {
+    trace::writeChromeTrace(settings.tracePath);
+  }
 }
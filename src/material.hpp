@@ -0,0 +1,6 @@
+#pragma once
+
+struct Material {
+  alignas(4) float specular = 0.5f;
+  alignas(4) float shininess = 32.0f;
+};
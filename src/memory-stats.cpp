@@ -0,0 +1,152 @@
+#include "memory-stats.hpp"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+static const size_t CATEGORY_COUNT = static_cast<size_t>(MemoryCategory::Count);
+
+static std::array<std::atomic<uint64_t>, CATEGORY_COUNT> categoryBytes{};
+static std::array<std::atomic<uint32_t>, CATEGORY_COUNT> categoryAllocations{};
+
+float MemoryReport::deviceUsageRatio() const {
+  return deviceBudget > 0 ? static_cast<float>(deviceUsage) / deviceBudget : 0.0f;
+}
+
+namespace memory {
+  // The category rides along in the allocation's user data so untrack needs no lookup table
+  void track(const VmaAllocator& allocator, const VmaAllocation allocation, const MemoryCategory category) {
+    if (!allocation) {
+      return;
+    }
+
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(allocator, allocation, &info);
+
+    vmaSetAllocationUserData(allocator, allocation, reinterpret_cast<void*>(static_cast<uintptr_t>(category) + 1));
+    vmaSetAllocationName(allocator, allocation, categoryName(category).data());
+
+    categoryBytes[static_cast<size_t>(category)] += info.size;
+    categoryAllocations[static_cast<size_t>(category)]++;
+  }
+
+  void untrack(const VmaAllocator& allocator, const VmaAllocation allocation) {
+    if (!allocation) {
+      return;
+    }
+
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(allocator, allocation, &info);
+
+    uintptr_t tag = reinterpret_cast<uintptr_t>(info.pUserData);
+
+    if (tag == 0 || tag > CATEGORY_COUNT) {
+      return;
+    }
+
+    categoryBytes[tag - 1] -= info.size;
+    categoryAllocations[tag - 1]--;
+
+    vmaSetAllocationUserData(allocator, allocation, nullptr);
+  }
+
+  MemoryReport report(const VmaAllocator& allocator) {
+    MemoryReport result{};
+
+    for (size_t i = 0; i < CATEGORY_COUNT; i++) {
+      result.categories[i].bytes = categoryBytes[i];
+      result.categories[i].allocations = categoryAllocations[i];
+    }
+
+    const VkPhysicalDeviceMemoryProperties* memoryProperties;
+    vmaGetMemoryProperties(allocator, &memoryProperties);
+
+    std::vector<VmaBudget> budgets(memoryProperties->memoryHeapCount);
+    vmaGetHeapBudgets(allocator, budgets.data());
+
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+      MemoryHeapStats heap{};
+      heap.size = memoryProperties->memoryHeaps[i].size;
+      heap.budget = budgets[i].budget;
+      heap.usage = budgets[i].usage;
+      heap.blockBytes = budgets[i].statistics.blockBytes;
+      heap.allocationBytes = budgets[i].statistics.allocationBytes;
+      heap.deviceLocal = memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+      if (heap.deviceLocal) {
+        result.deviceBudget += heap.budget;
+        result.deviceUsage += heap.usage;
+      }
+
+      result.heaps.push_back(heap);
+    }
+
+    return result;
+  }
+
+  std::string reportJson(const VmaAllocator& allocator, const bool detailed) {
+    MemoryReport r = report(allocator);
+    char line[256];
+
+    std::string json = "{\n  \"categories\": {\n";
+
+    for (size_t i = 0; i < CATEGORY_COUNT; i++) {
+      std::snprintf(line, sizeof(line), "    \"%s\": {\"bytes\": %" PRIu64 ", \"allocations\": %u}%s\n",
+        categoryName(static_cast<MemoryCategory>(i)).data(),
+        r.categories[i].bytes,
+        r.categories[i].allocations,
+        i + 1 < CATEGORY_COUNT ? "," : "");
+      json += line;
+    }
+
+    json += "  },\n  \"heaps\": [\n";
+
+    for (size_t i = 0; i < r.heaps.size(); i++) {
+      const MemoryHeapStats& heap = r.heaps[i];
+
+      std::snprintf(line, sizeof(line), "    {\"size\": %" PRIu64 ", \"budget\": %" PRIu64 ", \"usage\": %" PRIu64 ", \"blockBytes\": %" PRIu64 ", \"allocationBytes\": %" PRIu64 ", \"deviceLocal\": %s}%s\n",
+        heap.size,
+        heap.budget,
+        heap.usage,
+        heap.blockBytes,
+        heap.allocationBytes,
+        heap.deviceLocal ? "true" : "false",
+        i + 1 < r.heaps.size() ? "," : "");
+      json += line;
+    }
+
+    std::snprintf(line, sizeof(line), "  ],\n  \"deviceBudget\": %" PRIu64 ",\n  \"deviceUsage\": %" PRIu64 ",\n  \"deviceUsageRatio\": %.4f,\n",
+      r.deviceBudget,
+      r.deviceUsage,
+      r.deviceUsageRatio());
+    json += line;
+
+    char* statsString;
+    vmaBuildStatsString(allocator, &statsString, detailed);
+    json += "  \"vma\": ";
+    json += statsString;
+    json += "\n}\n";
+    vmaFreeStatsString(allocator, statsString);
+
+    return json;
+  }
+
+  std::string_view categoryName(const MemoryCategory category) {
+    switch (category) {
+      case MemoryCategory::Mesh:
+        return "mesh";
+      case MemoryCategory::Texture:
+        return "texture";
+      case MemoryCategory::Uniform:
+        return "uniform";
+      case MemoryCategory::Storage:
+        return "storage";
+      case MemoryCategory::Staging:
+        return "staging";
+      case MemoryCategory::RenderTarget:
+        return "render-target";
+      default:
+        return "other";
+    }
+  }
+}
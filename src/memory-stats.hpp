@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "vk_mem_alloc.h"
+
+enum class MemoryCategory : uint32_t {
+  Mesh,
+  Texture,
+  Uniform,
+  Storage,
+  Staging,
+  RenderTarget,
+  Other,
+  Count
+};
+
+struct MemoryCategoryStats {
+  uint64_t bytes = 0;
+  uint32_t allocations = 0;
+};
+
+struct MemoryHeapStats {
+  uint64_t size = 0;
+  uint64_t budget = 0;
+  uint64_t usage = 0;
+  uint64_t blockBytes = 0;
+  uint64_t allocationBytes = 0;
+  bool deviceLocal = false;
+};
+
+struct MemoryReport {
+  std::array<MemoryCategoryStats, static_cast<size_t>(MemoryCategory::Count)> categories;
+  std::vector<MemoryHeapStats> heaps;
+  uint64_t deviceBudget = 0;
+  uint64_t deviceUsage = 0;
+
+  float deviceUsageRatio() const;
+};
+
+namespace memory {
+  void track(const VmaAllocator& allocator, const VmaAllocation allocation, const MemoryCategory category);
+  void untrack(const VmaAllocator& allocator, const VmaAllocation allocation);
+
+  MemoryReport report(const VmaAllocator& allocator);
+  std::string reportJson(const VmaAllocator& allocator, const bool detailed);
+  std::string_view categoryName(const MemoryCategory category);
+}
@@ -1,20 +1,36 @@
 #include "mesh.hpp"
 #include "buffer.hpp"
+#include "fs.hpp"
 
 #include <assimp/Importer.hpp>      
 #include <assimp/scene.h>           
 #include <assimp/postprocess.h>  
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
+
+Mesh::Mesh() {
+}
 
 Mesh::Mesh(const VmaAllocator& allocator, const std::string_view path) {
+  fs::MappedFile file{path};
+  *this = Mesh{allocator, file.data(), file.size(), path};
+}
+
+Mesh::Mesh(const VmaAllocator& allocator, const char* data, const size_t size, const std::string_view name) {
   Assimp::Importer importer{};
 
-  const aiScene* scene = importer.ReadFile(
-    path.data(), 
+  // Assimp picks the importer from the extension hint when reading from memory
+  std::string_view extension = name.substr(name.find_last_of('.') + 1);
+
+  const aiScene* scene = importer.ReadFileFromMemory(
+    data,
+    size,
     aiProcess_Triangulate | 
     aiProcess_FlipUVs |
     aiProcess_GenNormals |
-    aiProcess_GenUVCoords
+    aiProcess_GenUVCoords,
+    std::string{extension}.c_str()
   );
 
   if (!scene) {
@@ -22,6 +38,7 @@ Mesh::Mesh(const VmaAllocator& allocator, const std::string_view path) {
   }
 
   std::vector<Vertex> vertices;
+  std::vector<float> positions;
   std::vector<uint16_t> indices;
 
   for (size_t i = 0; i < scene->mNumMeshes; i++) {
@@ -48,6 +65,7 @@ Mesh::Mesh(const VmaAllocator& allocator, const std::string_view path) {
       }
 
       vertices.push_back(vertex);
+      positions.insert(positions.end(), std::begin(vertex.pos), std::end(vertex.pos));
     }
 
     for (size_t j = 0; j < assimpMesh->mNumFaces; j++) {
@@ -59,8 +77,29 @@ Mesh::Mesh(const VmaAllocator& allocator, const std::string_view path) {
   }
 
   importer.FreeScene();
+
+  if (!vertices.empty()) {
+    glm::vec3 lower{vertices[0].pos[0], vertices[0].pos[1], vertices[0].pos[2]};
+    glm::vec3 upper = lower;
+
+    for (const Vertex& vertex : vertices) {
+      glm::vec3 pos{vertex.pos[0], vertex.pos[1], vertex.pos[2]};
+      lower = glm::min(lower, pos);
+      upper = glm::max(upper, pos);
+    }
+
+    glm::vec3 center = (lower + upper) * 0.5f;
+    float radius = 0.0f;
+
+    for (const Vertex& vertex : vertices) {
+      radius = std::max(radius, glm::distance(center, glm::vec3{vertex.pos[0], vertex.pos[1], vertex.pos[2]}));
+    }
+
+    bounds = glm::vec4{center, radius};
+  }
   
   vertexBuffer = Buffer{allocator, vertices.data(), static_cast<uint32_t>(sizeof(Vertex) * vertices.size()), vk::BufferUsageFlagBits::eVertexBuffer};
+  positionBuffer = Buffer{allocator, positions.data(), static_cast<uint32_t>(sizeof(float) * positions.size()), vk::BufferUsageFlagBits::eVertexBuffer};
   indexBuffer = Buffer{allocator, indices.data(), static_cast<uint32_t>(sizeof(uint16_t) * indices.size()), vk::BufferUsageFlagBits::eIndexBuffer};
 
   indicesCount = indices.size(); 
@@ -68,5 +107,6 @@ Mesh::Mesh(const VmaAllocator& allocator, const std::string_view path) {
 
 void Mesh::destroy(const VmaAllocator& allocator) {
   vertexBuffer.destroy(allocator);
+  positionBuffer.destroy(allocator);
   indexBuffer.destroy(allocator);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <glm/glm.hpp>
 #include "buffer.hpp"
 
 struct Vertex {
@@ -12,11 +13,14 @@ struct Vertex {
 class Mesh {
 public:
   Buffer vertexBuffer;
+  Buffer positionBuffer;
   Buffer indexBuffer;
-  uint32_t indicesCount;
+  uint32_t indicesCount = 0;
+  glm::vec4 bounds = glm::vec4{0.0f, 0.0f, 0.0f, 0.0f};
 
   Mesh();
   Mesh(const VmaAllocator& allocator, const std::string_view path);
+  Mesh(const VmaAllocator& allocator, const char* data, const size_t size, const std::string_view name);
 
   void destroy(const VmaAllocator& allocator);
 };
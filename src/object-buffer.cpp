@@ -0,0 +1,104 @@
+#include "object-buffer.hpp"
+
+static const uint32_t INITIAL_CAPACITY = 64;
+
+static uint32_t grow(uint32_t capacity, const uint32_t required) {
+  while (capacity < required) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+ObjectBuffer::ObjectBuffer() {
+}
+
+ObjectBuffer::ObjectBuffer(const VmaAllocator& allocator, const uint32_t frameCount) {
+  for (size_t i = 0; i < frameCount; i++) {
+    objectBuffers.push_back(Buffer{allocator, sizeof(ObjectData) * INITIAL_CAPACITY, vk::BufferUsageFlagBits::eStorageBuffer});
+    materialBuffers.push_back(Buffer{allocator, sizeof(Material) * INITIAL_CAPACITY, vk::BufferUsageFlagBits::eStorageBuffer});
+  }
+}
+
+void ObjectBuffer::update(const VmaAllocator& allocator, const uint32_t frame, const std::vector<Object>& objects, const TransformStorage& transforms, const std::vector<Mesh>& meshes, const std::vector<Material>& materials) {
+  Buffer& objectBuffer = objectBuffers[frame];
+  Buffer& materialBuffer = materialBuffers[frame];
+
+  uint32_t objectCapacity = objectBuffer.size / sizeof(ObjectData);
+  uint32_t materialCapacity = materialBuffer.size / sizeof(Material);
+
+  if (objects.size() > objectCapacity) {
+    objectBuffer.destroy(allocator);
+    objectBuffer = Buffer{allocator, static_cast<uint32_t>(sizeof(ObjectData) * grow(objectCapacity, objects.size())), vk::BufferUsageFlagBits::eStorageBuffer};
+  }
+
+  if (materials.size() > materialCapacity) {
+    materialBuffer.destroy(allocator);
+    materialBuffer = Buffer{allocator, static_cast<uint32_t>(sizeof(Material) * grow(materialCapacity, materials.size())), vk::BufferUsageFlagBits::eStorageBuffer};
+  }
+
+  void* mapped;
+
+  vmaMapMemory(allocator, objectBuffer.allocation, &mapped);
+  ObjectData* objectData = static_cast<ObjectData*>(mapped);
+  for (size_t i = 0; i < objects.size(); i++) {
+    const Object& object = objects[i];
+
+    objectData[i].model = transforms.models[i];
+    objectData[i].normal = transforms.normals[i];
+    objectData[i].color = object.color;
+    objectData[i].bounds = meshes[object.meshIdx].bounds;
+  }
+  vmaUnmapMemory(allocator, objectBuffer.allocation);
+  vmaFlushAllocation(allocator, objectBuffer.allocation, 0, VK_WHOLE_SIZE);
+
+  vmaCopyMemoryToAllocation(allocator, materials.data(), materialBuffer.allocation, 0, sizeof(Material) * materials.size());
+}
+
+vk::DescriptorSet ObjectBuffer::allocateDescriptorSet(const vk::Device& device, DescriptorAllocator& descriptorAllocator, const vk::DescriptorSetLayout& descriptorSetLayout, const uint32_t frame) {
+  vk::DescriptorSet descriptorSet = descriptorAllocator.allocate(device, descriptorSetLayout);
+
+  vk::DescriptorBufferInfo objectsInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(objectBuffers[frame].buffer)
+    .setRange(VK_WHOLE_SIZE)
+    .setOffset(0);
+
+  vk::DescriptorBufferInfo materialsInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(materialBuffers[frame].buffer)
+    .setRange(VK_WHOLE_SIZE)
+    .setOffset(0);
+
+  vk::WriteDescriptorSet objectsWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(0)
+    .setDstArrayElement(0)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+    .setBufferInfo(objectsInfo);
+
+  vk::WriteDescriptorSet materialsWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(1)
+    .setDstArrayElement(0)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+    .setBufferInfo(materialsInfo);
+
+  std::vector<vk::WriteDescriptorSet> writes{
+    objectsWrite,
+    materialsWrite,
+  };
+
+  device.updateDescriptorSets(writes.size(), writes.data(), 0, nullptr);
+
+  return descriptorSet;
+}
+
+void ObjectBuffer::destroy(const VmaAllocator& allocator) {
+  for (Buffer& buffer : objectBuffers) {
+    buffer.destroy(allocator);
+  }
+
+  for (Buffer& buffer : materialBuffers) {
+    buffer.destroy(allocator);
+  }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "buffer.hpp"
+#include "descriptor-allocator.hpp"
+#include "material.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include "transform.hpp"
+#include "vk_mem_alloc.h"
+
+class ObjectBuffer {
+public:
+  std::vector<Buffer> objectBuffers;
+  std::vector<Buffer> materialBuffers;
+
+  ObjectBuffer();
+  ObjectBuffer(const VmaAllocator& allocator, const uint32_t frameCount);
+
+  void update(const VmaAllocator& allocator, const uint32_t frame, const std::vector<Object>& objects, const TransformStorage& transforms, const std::vector<Mesh>& meshes, const std::vector<Material>& materials);
+  vk::DescriptorSet allocateDescriptorSet(const vk::Device& device, DescriptorAllocator& descriptorAllocator, const vk::DescriptorSetLayout& descriptorSetLayout, const uint32_t frame);
+
+  void destroy(const VmaAllocator& allocator);
+};
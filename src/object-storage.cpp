@@ -0,0 +1,122 @@
+#include "object-storage.hpp"
+
+#include <stdexcept>
+
+ObjectStorage::ObjectStorage() {
+}
+
+ObjectHandle ObjectStorage::add(const Object& object, const Transform& transform) {
+  uint32_t slotIdx;
+
+  if (freeHead != UINT32_MAX) {
+    slotIdx = freeHead;
+    freeHead = slots[slotIdx].dense;
+  } else {
+    slotIdx = slots.size();
+    slots.push_back(Slot{});
+  }
+
+  Slot& slot = slots[slotIdx];
+  slot.dense = objects.size();
+
+  objects.push_back(object);
+  transforms.add(transform);
+  denseToSlot.push_back(slotIdx);
+
+  return ObjectHandle{slotIdx, slot.generation};
+}
+
+bool ObjectStorage::remove(const ObjectHandle handle) {
+  if (!valid(handle)) {
+    return false;
+  }
+
+  Slot& slot = slots[handle.index];
+  uint32_t dense = slot.dense;
+  uint32_t last = objects.size() - 1;
+
+  if (objects[dense].castsShadow) {
+    shadowCastersChanged = true;
+  }
+
+  if (dense != last) {
+    objects[dense] = objects[last];
+    denseToSlot[dense] = denseToSlot[last];
+    slots[denseToSlot[dense]].dense = dense;
+  }
+
+  objects.pop_back();
+  denseToSlot.pop_back();
+  transforms.remove(dense);
+
+  slot.generation++;
+  slot.dense = freeHead;
+  freeHead = handle.index;
+
+  return true;
+}
+
+bool ObjectStorage::valid(const ObjectHandle handle) const {
+  return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+}
+
+uint32_t ObjectStorage::denseIndex(const ObjectHandle handle) const {
+  if (!valid(handle)) {
+    throw std::runtime_error{"Invalid object handle"};
+  }
+
+  return slots[handle.index].dense;
+}
+
+Object& ObjectStorage::get(const ObjectHandle handle) {
+  return objects[denseIndex(handle)];
+}
+
+Transform ObjectStorage::transform(const ObjectHandle handle) const {
+  return transforms.get(denseIndex(handle));
+}
+
+void ObjectStorage::setTransform(const ObjectHandle handle, const Transform& transform) {
+  transforms.set(denseIndex(handle), transform);
+}
+
+uint32_t ObjectStorage::update(JobSystem& jobs) {
+  uint32_t updated = transforms.update(jobs);
+
+  for (uint32_t idx : transforms.updated) {
+    if (objects[idx].castsShadow) {
+      shadowCastersChanged = true;
+      break;
+    }
+  }
+
+  return updated;
+}
+
+size_t ObjectStorage::size() const {
+  return objects.size();
+}
+
+void ObjectStorage::reserve(const size_t count) {
+  objects.reserve(count);
+  transforms.reserve(count);
+  slots.reserve(count);
+  denseToSlot.reserve(count);
+}
+
+void ObjectStorage::clear() {
+  for (uint32_t slotIdx : denseToSlot) {
+    Slot& slot = slots[slotIdx];
+    slot.generation++;
+    slot.dense = freeHead;
+    freeHead = slotIdx;
+  }
+
+  if (!objects.empty()) {
+    shadowCastersChanged = true;
+  }
+
+  objects.clear();
+  denseToSlot.clear();
+  transforms.clear();
+}
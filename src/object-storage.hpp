@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "object.hpp"
+#include "transform.hpp"
+
+struct ObjectHandle {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+};
+
+class ObjectStorage {
+public:
+  std::vector<Object> objects;
+  TransformStorage transforms;
+
+  bool shadowCastersChanged = false;
+
+  ObjectStorage();
+
+  ObjectHandle add(const Object& object, const Transform& transform);
+  bool remove(const ObjectHandle handle);
+
+  bool valid(const ObjectHandle handle) const;
+  uint32_t denseIndex(const ObjectHandle handle) const;
+
+  Object& get(const ObjectHandle handle);
+  Transform transform(const ObjectHandle handle) const;
+  void setTransform(const ObjectHandle handle, const Transform& transform);
+
+  uint32_t update(JobSystem& jobs);
+
+  size_t size() const;
+  void reserve(const size_t count);
+  void clear();
+private:
+  struct Slot {
+    uint32_t dense = 0;
+    uint32_t generation = 0;
+  };
+
+  std::vector<Slot> slots;
+  std::vector<uint32_t> denseToSlot;
+  uint32_t freeHead = UINT32_MAX;
+};
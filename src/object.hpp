@@ -2,41 +2,24 @@
 
 #include <glm/geometric.hpp>
 #include <glm/glm.hpp>
-#include <vulkan/vulkan.hpp>
-#include "buffer.hpp"
-#include "vk_mem_alloc.h"
 
-struct UniformBuffer {
-  alignas(16) glm::mat4 translation = glm::mat4{1.0f};
-  alignas(16) glm::mat4 rotation = glm::mat4{1.0f};
-  alignas(16) glm::mat4 scale = glm::mat4{1.0};
+struct ObjectData {
+  alignas(16) glm::mat4 model = glm::mat4{1.0f};
+  alignas(16) glm::mat3x4 normal = glm::mat3x4{1.0f};
   alignas(16) glm::vec3 color = glm::vec3{0.5};
+  alignas(16) glm::vec4 bounds = glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};
 };
 
 class Object {
 public:
-  UniformBuffer uniform;
+  glm::vec3 color = glm::vec3{0.5};
 
   uint32_t textureIdx = 0;
   uint32_t meshIdx = 0;
   uint32_t pipelineIdx = 0;
+  uint32_t materialIdx = 0;
 
-  Buffer ubo;
-
-  vk::DescriptorSetLayout descriptorSetLayout;
-  std::vector<vk::DescriptorSet> descriptorSets;
+  bool castsShadow = true;
 
   Object();
-
-  Object(
-    const VmaAllocator& allocator,
-    const vk::Device& device, 
-    const uint32_t swapchainImageCount,
-    const vk::DescriptorPool& descriptorPool,
-    const vk::DescriptorSetLayout& descriptorSetLayout
-  );
-
-  void destroy(const VmaAllocator& allocator);
-private:
-  void createDescriptors(const vk::DescriptorPool& descriptorPool, const vk::DescriptorSetLayout& descriptorSetLayout, const VmaAllocator& allocator, const vk::Device& device, const uint32_t swapchainImageCount);
 };
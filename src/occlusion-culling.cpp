@@ -0,0 +1,450 @@
+#include "occlusion-culling.hpp"
+#include "memory-stats.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static const uint32_t INITIAL_CAPACITY = 64;
+static const uint32_t CULL_WORKGROUP_SIZE = 64;
+static const uint32_t REDUCE_WORKGROUP_SIZE = 8;
+static const vk::Format PYRAMID_FORMAT = vk::Format::eR32Sfloat;
+
+static const std::vector<PoolSizeRatio> REDUCE_RATIOS{
+  {vk::DescriptorType::eCombinedImageSampler, 1.0f},
+  {vk::DescriptorType::eStorageImage, 1.0f},
+};
+
+OcclusionCulling::OcclusionCulling() {
+}
+
+OcclusionCulling::OcclusionCulling(const VmaAllocator& allocator, const vk::Device& device, const uint32_t frameCount, const vk::DescriptorSetLayout& objectSetLayout, const vk::ImageView& depthView, const vk::Extent2D& extent) {
+  for (size_t i = 0; i < frameCount; i++) {
+    drawBuffers.push_back(Buffer{allocator, sizeof(vk::DrawIndexedIndirectCommand) * INITIAL_CAPACITY * 2, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer});
+    paramBuffers.push_back(Buffer{allocator, sizeof(CullParams), vk::BufferUsageFlagBits::eUniformBuffer});
+  }
+
+  reduceDescriptorAllocator = DescriptorAllocator{device, 16, REDUCE_RATIOS};
+
+  createSampler(device);
+  createPipelines(device, objectSetLayout);
+  createPyramid(allocator, device, depthView, extent);
+}
+
+void OcclusionCulling::createSampler(const vk::Device& device) {
+  vk::SamplerCreateInfo samplerCreateInfo = vk::SamplerCreateInfo{}
+    .setMagFilter(vk::Filter::eNearest)
+    .setMinFilter(vk::Filter::eNearest)
+    .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+    .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+    .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+    .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+    .setAnisotropyEnable(0)
+    .setMinLod(0.0f)
+    .setMaxLod(VK_LOD_CLAMP_NONE);
+
+  sampler = device.createSampler(samplerCreateInfo);
+}
+
+static vk::Pipeline createComputePipeline(const vk::Device& device, const std::string_view path, const vk::PipelineLayout& pipelineLayout) {
+  Shader shader{device, path};
+
+  vk::ComputePipelineCreateInfo pipelineCreateInfo = vk::ComputePipelineCreateInfo{}
+    .setStage(vk::PipelineShaderStageCreateInfo{}.setStage(vk::ShaderStageFlagBits::eCompute).setModule(shader.module).setPName("main"))
+    .setLayout(pipelineLayout);
+
+  vk::ResultValue<vk::Pipeline> result = device.createComputePipeline(VK_NULL_HANDLE, pipelineCreateInfo);
+
+  shader.destroy(device);
+
+  if (result.result != vk::Result::eSuccess) {
+    throw std::runtime_error{"Failed to create the occlusion culling pipelines"};
+  }
+
+  return result.value;
+}
+
+void OcclusionCulling::createPipelines(const vk::Device& device, const vk::DescriptorSetLayout& objectSetLayout) {
+  vk::DescriptorSetLayoutBinding sourceBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(0)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+
+  vk::DescriptorSetLayoutBinding destinationBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(1)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eStorageImage);
+
+  std::vector<vk::DescriptorSetLayoutBinding> reduceBindings{sourceBinding, destinationBinding};
+
+  vk::DescriptorSetLayoutCreateInfo reduceSetLayoutCreateInfo = vk::DescriptorSetLayoutCreateInfo{}
+    .setBindings(reduceBindings)
+    .setBindingCount(reduceBindings.size());
+
+  reduceSetLayout = device.createDescriptorSetLayout(reduceSetLayoutCreateInfo, nullptr);
+
+  vk::DescriptorSetLayoutBinding paramsBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(0)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eUniformBuffer);
+
+  vk::DescriptorSetLayoutBinding drawsBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(1)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer);
+
+  vk::DescriptorSetLayoutBinding pyramidBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(2)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+
+  std::vector<vk::DescriptorSetLayoutBinding> cullBindings{paramsBinding, drawsBinding, pyramidBinding};
+
+  vk::DescriptorSetLayoutCreateInfo cullSetLayoutCreateInfo = vk::DescriptorSetLayoutCreateInfo{}
+    .setBindings(cullBindings)
+    .setBindingCount(cullBindings.size());
+
+  cullSetLayout = device.createDescriptorSetLayout(cullSetLayoutCreateInfo, nullptr);
+
+  vk::PushConstantRange reducePushConstantRange = vk::PushConstantRange{}
+    .setStageFlags(vk::ShaderStageFlagBits::eCompute)
+    .setOffset(0)
+    .setSize(sizeof(int32_t) * 2);
+
+  vk::PipelineLayoutCreateInfo reducePipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
+    .setSetLayouts(reduceSetLayout)
+    .setSetLayoutCount(1)
+    .setPushConstantRanges(reducePushConstantRange)
+    .setPushConstantRangeCount(1);
+
+  reducePipelineLayout = device.createPipelineLayout(reducePipelineLayoutCreateInfo, nullptr);
+
+  std::vector<vk::DescriptorSetLayout> cullSetLayouts{objectSetLayout, cullSetLayout};
+
+  vk::PushConstantRange pushConstantRange = vk::PushConstantRange{}
+    .setStageFlags(vk::ShaderStageFlagBits::eCompute)
+    .setOffset(0)
+    .setSize(sizeof(uint32_t));
+
+  vk::PipelineLayoutCreateInfo cullPipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
+    .setSetLayouts(cullSetLayouts)
+    .setSetLayoutCount(cullSetLayouts.size())
+    .setPushConstantRanges(pushConstantRange)
+    .setPushConstantRangeCount(1);
+
+  cullPipelineLayout = device.createPipelineLayout(cullPipelineLayoutCreateInfo, nullptr);
+
+  createComputePipelines(device);
+}
+
+void OcclusionCulling::createComputePipelines(const vk::Device& device) {
+  vk::Pipeline reduce = createComputePipeline(device, "./shaders/hiz-reduce.comp.spv", reducePipelineLayout);
+  vk::Pipeline cull;
+
+  try {
+    cull = createComputePipeline(device, "./shaders/occlusion-cull.comp.spv", cullPipelineLayout);
+  } catch (const std::exception&) {
+    device.destroyPipeline(reduce);
+    throw;
+  }
+
+  reducePipeline = reduce;
+  cullPipeline = cull;
+}
+
+void OcclusionCulling::reloadPipelines(const vk::Device& device, DeletionQueue& deletionQueue, const uint64_t serial) {
+  vk::Pipeline oldReducePipeline = reducePipeline;
+  vk::Pipeline oldCullPipeline = cullPipeline;
+
+  // The layouts and descriptor sets stay, only the shader stages change
+  createComputePipelines(device);
+
+  deletionQueue.push(serial, [=]() {
+    device.destroyPipeline(oldReducePipeline);
+    device.destroyPipeline(oldCullPipeline);
+  });
+}
+
+void OcclusionCulling::createPyramid(const VmaAllocator& allocator, const vk::Device& device, const vk::ImageView& depthView, const vk::Extent2D& extent) {
+  vk::Extent2D baseExtent = vk::Extent2D{std::max(1u, extent.width / 2), std::max(1u, extent.height / 2)};
+  uint32_t levelCount = 1;
+
+  while ((std::max(baseExtent.width, baseExtent.height) >> levelCount) > 0) {
+    levelCount++;
+  }
+
+  VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{}
+    .setImageType(vk::ImageType::e2D)
+    .setFormat(PYRAMID_FORMAT)
+    .setMipLevels(levelCount)
+    .setArrayLayers(1)
+    .setSamples(vk::SampleCountFlagBits::e1)
+    .setTiling(vk::ImageTiling::eOptimal)
+    .setUsage(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled)
+    .setSharingMode(vk::SharingMode::eExclusive)
+    .setInitialLayout(vk::ImageLayout::eUndefined)
+    .setExtent(vk::Extent3D{baseExtent, 1});
+
+  VmaAllocationCreateInfo imageAllocationCreateInfo{};
+  imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+  imageAllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+  VkImage vkImage;
+
+  if (vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationCreateInfo, &vkImage, &pyramidAllocation, nullptr) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create the depth pyramid"};
+  }
+
+  memory::track(allocator, pyramidAllocation, MemoryCategory::RenderTarget);
+
+  pyramid = vkImage;
+
+  vk::ImageViewCreateInfo pyramidViewCreateInfo = vk::ImageViewCreateInfo{}
+    .setImage(pyramid)
+    .setViewType(vk::ImageViewType::e2D)
+    .setFormat(PYRAMID_FORMAT)
+    .setSubresourceRange(vk::ImageSubresourceRange{vk::ImageAspectFlagBits::eColor, 0, levelCount, 0, 1});
+
+  pyramidView = device.createImageView(pyramidViewCreateInfo, nullptr);
+
+  for (uint32_t level = 0; level < levelCount; level++) {
+    vk::ImageViewCreateInfo levelViewCreateInfo = vk::ImageViewCreateInfo{}
+      .setImage(pyramid)
+      .setViewType(vk::ImageViewType::e2D)
+      .setFormat(PYRAMID_FORMAT)
+      .setSubresourceRange(vk::ImageSubresourceRange{vk::ImageAspectFlagBits::eColor, level, 1, 0, 1});
+
+    levelViews.push_back(device.createImageView(levelViewCreateInfo, nullptr));
+    levelExtents.push_back(vk::Extent2D{std::max(1u, baseExtent.width >> level), std::max(1u, baseExtent.height >> level)});
+  }
+
+  for (uint32_t level = 0; level < levelCount; level++) {
+    vk::DescriptorSet descriptorSet = reduceDescriptorAllocator.allocate(device, reduceSetLayout);
+
+    vk::DescriptorImageInfo sourceInfo = vk::DescriptorImageInfo{}
+      .setSampler(sampler)
+      .setImageView(level == 0 ? depthView : levelViews[level - 1])
+      .setImageLayout(level == 0 ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::eGeneral);
+
+    vk::DescriptorImageInfo destinationInfo = vk::DescriptorImageInfo{}
+      .setImageView(levelViews[level])
+      .setImageLayout(vk::ImageLayout::eGeneral);
+
+    vk::WriteDescriptorSet sourceWrite = vk::WriteDescriptorSet{}
+      .setDstSet(descriptorSet)
+      .setDstBinding(0)
+      .setDescriptorCount(1)
+      .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+      .setImageInfo(sourceInfo);
+
+    vk::WriteDescriptorSet destinationWrite = vk::WriteDescriptorSet{}
+      .setDstSet(descriptorSet)
+      .setDstBinding(1)
+      .setDescriptorCount(1)
+      .setDescriptorType(vk::DescriptorType::eStorageImage)
+      .setImageInfo(destinationInfo);
+
+    std::vector<vk::WriteDescriptorSet> writes{
+      sourceWrite,
+      destinationWrite,
+    };
+
+    device.updateDescriptorSets(writes.size(), writes.data(), 0, nullptr);
+
+    reduceSets.push_back(descriptorSet);
+  }
+
+  validExtent = extent;
+  state = ResourceState{};
+  historyValid = false;
+}
+
+void OcclusionCulling::resize(const VmaAllocator& allocator, const vk::Device& device, const vk::ImageView& depthView, const vk::Extent2D& extent, DeletionQueue& deletionQueue, const uint64_t serial) {
+  vk::Image oldPyramid = pyramid;
+  VmaAllocation oldAllocation = pyramidAllocation;
+  vk::ImageView oldView = pyramidView;
+  std::vector<vk::ImageView> oldLevelViews = levelViews;
+  DescriptorAllocator oldDescriptorAllocator = reduceDescriptorAllocator;
+
+  deletionQueue.push(serial, [=]() mutable {
+    for (vk::ImageView& view : oldLevelViews) {
+      device.destroyImageView(view);
+    }
+
+    device.destroyImageView(oldView);
+    memory::untrack(allocator, oldAllocation);
+    vmaDestroyImage(allocator, oldPyramid, oldAllocation);
+    oldDescriptorAllocator.destroy(device);
+  });
+
+  levelViews.clear();
+  levelExtents.clear();
+  reduceSets.clear();
+
+  reduceDescriptorAllocator = DescriptorAllocator{device, 16, REDUCE_RATIOS};
+  createPyramid(allocator, device, depthView, extent);
+}
+
+void OcclusionCulling::update(const VmaAllocator& allocator, const uint32_t frame, const std::vector<Object>& objects, const std::vector<Mesh>& meshes, const Projection& projection, const vk::Extent2D& extent) {
+  Buffer& drawBuffer = drawBuffers[frame];
+
+  uint32_t capacity = drawBuffer.size / (sizeof(vk::DrawIndexedIndirectCommand) * 2);
+
+  if (objects.size() > capacity) {
+    while (capacity < objects.size()) {
+      capacity *= 2;
+    }
+
+    drawBuffer.destroy(allocator);
+    drawBuffer = Buffer{allocator, static_cast<uint32_t>(sizeof(vk::DrawIndexedIndirectCommand) * capacity * 2), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer};
+  }
+
+  void* mapped;
+
+  vmaMapMemory(allocator, drawBuffer.allocation, &mapped);
+  vk::DrawIndexedIndirectCommand* draws = static_cast<vk::DrawIndexedIndirectCommand*>(mapped);
+  for (size_t i = 0; i < objects.size(); i++) {
+    vk::DrawIndexedIndirectCommand draw{meshes[objects[i].meshIdx].indicesCount, 1, 0, 0, 0};
+
+    draws[i] = draw;
+    draws[objects.size() + i] = draw;
+  }
+  vmaUnmapMemory(allocator, drawBuffer.allocation);
+  vmaFlushAllocation(allocator, drawBuffer.allocation, 0, VK_WHOLE_SIZE);
+
+  const glm::mat4& perspective = projection.perspective;
+  float near = perspective[3][2] / (perspective[2][2] - 1.0f);
+
+  CullParams params{};
+  params.view = projection.view;
+  params.perspective = perspective;
+  params.model = projection.model;
+  params.screen = glm::vec4{extent.width, extent.height, near, levelViews.size()};
+  params.info = glm::uvec4{static_cast<uint32_t>(objects.size()), historyValid ? 1 : 0, 0, 0};
+
+  validExtent = extent;
+
+  vmaCopyMemoryToAllocation(allocator, &params, paramBuffers[frame].allocation, 0, sizeof(CullParams));
+}
+
+vk::DescriptorSet OcclusionCulling::allocateDescriptorSet(const vk::Device& device, DescriptorAllocator& descriptorAllocator, const uint32_t frame) {
+  vk::DescriptorSet descriptorSet = descriptorAllocator.allocate(device, cullSetLayout);
+
+  vk::DescriptorBufferInfo paramsInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(paramBuffers[frame].buffer)
+    .setRange(sizeof(CullParams))
+    .setOffset(0);
+
+  vk::DescriptorBufferInfo drawsInfo = vk::DescriptorBufferInfo{}
+    .setBuffer(drawBuffers[frame].buffer)
+    .setRange(VK_WHOLE_SIZE)
+    .setOffset(0);
+
+  vk::DescriptorImageInfo pyramidInfo = vk::DescriptorImageInfo{}
+    .setSampler(sampler)
+    .setImageView(pyramidView)
+    .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  vk::WriteDescriptorSet paramsWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(0)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eUniformBuffer)
+    .setBufferInfo(paramsInfo);
+
+  vk::WriteDescriptorSet drawsWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(1)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+    .setBufferInfo(drawsInfo);
+
+  vk::WriteDescriptorSet pyramidWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(2)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+    .setImageInfo(pyramidInfo);
+
+  std::vector<vk::WriteDescriptorSet> writes{
+    paramsWrite,
+    drawsWrite,
+    pyramidWrite,
+  };
+
+  device.updateDescriptorSets(writes.size(), writes.data(), 0, nullptr);
+
+  return descriptorSet;
+}
+
+void OcclusionCulling::cull(vk::CommandBuffer& commandBuffer, const vk::DescriptorSet& objectSet, const vk::DescriptorSet& cullSet, const uint32_t objectCount, const bool late) {
+  if (objectCount == 0) {
+    return;
+  }
+
+  std::vector<vk::DescriptorSet> sets{objectSet, cullSet};
+  uint32_t phase = late ? 1 : 0;
+
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, cullPipeline);
+  commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cullPipelineLayout, 0, sets.size(), sets.data(), 0, nullptr);
+  commandBuffer.pushConstants(cullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t), &phase);
+  commandBuffer.dispatch((objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+}
+
+void OcclusionCulling::buildPyramid(vk::CommandBuffer& commandBuffer) {
+  vk::MemoryBarrier2 levelBarrier = vk::MemoryBarrier2{}
+    .setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+    .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+    .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+    .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead);
+
+  vk::DependencyInfo dependencyInfo = vk::DependencyInfo{}
+    .setMemoryBarriers(levelBarrier)
+    .setMemoryBarrierCount(1);
+
+  commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, reducePipeline);
+
+  for (uint32_t level = 0; level < levelViews.size(); level++) {
+    if (level > 0) {
+      commandBuffer.pipelineBarrier2(dependencyInfo);
+    }
+
+    const vk::Extent2D& extent = levelExtents[level];
+    const vk::Extent2D& source = level == 0 ? validExtent : levelExtents[level - 1];
+    int32_t sourceExtent[2] = {static_cast<int32_t>(source.width), static_cast<int32_t>(source.height)};
+
+    commandBuffer.pushConstants(reducePipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(sourceExtent), sourceExtent);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, reducePipelineLayout, 0, 1, &reduceSets[level], 0, nullptr);
+    commandBuffer.dispatch((extent.width + REDUCE_WORKGROUP_SIZE - 1) / REDUCE_WORKGROUP_SIZE, (extent.height + REDUCE_WORKGROUP_SIZE - 1) / REDUCE_WORKGROUP_SIZE, 1);
+  }
+
+  historyValid = true;
+}
+
+void OcclusionCulling::destroy(const VmaAllocator& allocator, const vk::Device& device) {
+  for (vk::ImageView& view : levelViews) {
+    device.destroyImageView(view);
+  }
+
+  device.destroyImageView(pyramidView);
+  memory::untrack(allocator, pyramidAllocation);
+  vmaDestroyImage(allocator, pyramid, pyramidAllocation);
+  reduceDescriptorAllocator.destroy(device);
+
+  device.destroyPipeline(reducePipeline);
+  device.destroyPipeline(cullPipeline);
+  device.destroyPipelineLayout(reducePipelineLayout);
+  device.destroyPipelineLayout(cullPipelineLayout);
+  device.destroyDescriptorSetLayout(reduceSetLayout);
+  device.destroyDescriptorSetLayout(cullSetLayout);
+  device.destroySampler(sampler);
+
+  for (size_t i = 0; i < drawBuffers.size(); i++) {
+    drawBuffers[i].destroy(allocator);
+    paramBuffers[i].destroy(allocator);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+#include "buffer.hpp"
+#include "deletion-queue.hpp"
+#include "descriptor-allocator.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include "render-graph.hpp"
+#include "scene.hpp"
+#include "vk-shader.hpp"
+#include "vk_mem_alloc.h"
+
+struct CullParams {
+  alignas(16) glm::mat4 view;
+  alignas(16) glm::mat4 perspective;
+  alignas(16) glm::mat4 model;
+  alignas(16) glm::vec4 screen;
+  alignas(16) glm::uvec4 info;
+};
+
+class OcclusionCulling {
+public:
+  vk::Image pyramid;
+  VmaAllocation pyramidAllocation;
+  vk::ImageView pyramidView;
+  std::vector<vk::ImageView> levelViews;
+  std::vector<vk::Extent2D> levelExtents;
+  vk::Extent2D validExtent;
+  vk::Sampler sampler;
+
+  std::vector<Buffer> drawBuffers;
+  std::vector<Buffer> paramBuffers;
+
+  vk::DescriptorSetLayout reduceSetLayout;
+  vk::DescriptorSetLayout cullSetLayout;
+  vk::PipelineLayout reducePipelineLayout;
+  vk::Pipeline reducePipeline;
+  vk::PipelineLayout cullPipelineLayout;
+  vk::Pipeline cullPipeline;
+
+  ResourceState state;
+  bool historyValid = false;
+
+  OcclusionCulling();
+  OcclusionCulling(const VmaAllocator& allocator, const vk::Device& device, const uint32_t frameCount, const vk::DescriptorSetLayout& objectSetLayout, const vk::ImageView& depthView, const vk::Extent2D& extent);
+
+  void resize(const VmaAllocator& allocator, const vk::Device& device, const vk::ImageView& depthView, const vk::Extent2D& extent, DeletionQueue& deletionQueue, const uint64_t serial);
+  void update(const VmaAllocator& allocator, const uint32_t frame, const std::vector<Object>& objects, const std::vector<Mesh>& meshes, const Projection& projection, const vk::Extent2D& extent);
+  vk::DescriptorSet allocateDescriptorSet(const vk::Device& device, DescriptorAllocator& descriptorAllocator, const uint32_t frame);
+  void cull(vk::CommandBuffer& commandBuffer, const vk::DescriptorSet& objectSet, const vk::DescriptorSet& cullSet, const uint32_t objectCount, const bool late);
+  void buildPyramid(vk::CommandBuffer& commandBuffer);
+  void reloadPipelines(const vk::Device& device, DeletionQueue& deletionQueue, const uint64_t serial);
+
+  void destroy(const VmaAllocator& allocator, const vk::Device& device);
+private:
+  DescriptorAllocator reduceDescriptorAllocator;
+  std::vector<vk::DescriptorSet> reduceSets;
+
+  void createPyramid(const VmaAllocator& allocator, const vk::Device& device, const vk::ImageView& depthView, const vk::Extent2D& extent);
+  void createSampler(const vk::Device& device);
+  void createPipelines(const vk::Device& device, const vk::DescriptorSetLayout& objectSetLayout);
+  void createComputePipelines(const vk::Device& device);
+};
@@ -0,0 +1,553 @@
+#include "render-graph.hpp"
+#include "memory-stats.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static const vk::AccessFlags2 WRITE_ACCESS =
+  vk::AccessFlagBits2::eColorAttachmentWrite |
+  vk::AccessFlagBits2::eDepthStencilAttachmentWrite |
+  vk::AccessFlagBits2::eShaderStorageWrite |
+  vk::AccessFlagBits2::eTransferWrite |
+  vk::AccessFlagBits2::eHostWrite |
+  vk::AccessFlagBits2::eMemoryWrite;
+
+static ResourceState usageState(const ResourceUsage usage) {
+  switch (usage) {
+    case ResourceUsage::ColorAttachment:
+      return {vk::ImageLayout::eColorAttachmentOptimal, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite};
+    case ResourceUsage::DepthAttachment:
+      return {vk::ImageLayout::eDepthAttachmentOptimal, vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite};
+    case ResourceUsage::DepthRead:
+      return {vk::ImageLayout::eDepthReadOnlyOptimal, vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentRead};
+    case ResourceUsage::FragmentSampled:
+      return {vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead};
+    case ResourceUsage::ComputeSampled:
+      return {vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead};
+    case ResourceUsage::FragmentStorageRead:
+      return {vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderStorageRead};
+    case ResourceUsage::VertexStorageRead:
+      return {vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eVertexShader, vk::AccessFlagBits2::eShaderStorageRead};
+    case ResourceUsage::ComputeStorageRead:
+      return {vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead};
+    case ResourceUsage::ComputeStorageWrite:
+      return {vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite};
+    case ResourceUsage::ComputeStorageReadWrite:
+      return {vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite};
+    case ResourceUsage::IndirectRead:
+      return {vk::ImageLayout::eUndefined, vk::PipelineStageFlagBits2::eDrawIndirect, vk::AccessFlagBits2::eIndirectCommandRead};
+    case ResourceUsage::TransferSrc:
+      return {vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead};
+    case ResourceUsage::TransferDst:
+      return {vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite};
+  }
+
+  throw std::runtime_error{"Unknown render graph resource usage"};
+}
+
+bool ImageDesc::operator==(const ImageDesc& other) const {
+  return extent == other.extent && format == other.format && usage == other.usage && aspect == other.aspect;
+}
+
+// The state a pass leaves the resource in, reads drop the usage's write access so e.g. a depth test without depth writes is no hazard
+static ResourceState accessState(const RenderGraphAccess& access) {
+  ResourceState state = usageState(access.usage);
+
+  if (!access.write) {
+    state.access &= ~WRITE_ACCESS;
+  }
+
+  return state;
+}
+
+RenderGraphPass& RenderGraphPass::read(const uint32_t resource, const ResourceUsage usage) {
+  accesses.push_back(RenderGraphAccess{resource, usage, false});
+  return *this;
+}
+
+RenderGraphPass& RenderGraphPass::write(const uint32_t resource, const ResourceUsage usage) {
+  if (!(usageState(usage).access & WRITE_ACCESS)) {
+    throw std::runtime_error{"Render graph pass " + name + " writes through a read-only usage"};
+  }
+
+  accesses.push_back(RenderGraphAccess{resource, usage, true});
+  return *this;
+}
+
+RenderGraph::RenderGraph() {
+}
+
+RenderGraph::RenderGraph(const VmaAllocator& a, const vk::Device& d, const uint32_t f): allocator{a}, device{d}, framesInFlight{f} {
+}
+
+void RenderGraph::reset() {
+  resources.clear();
+  passes.clear();
+}
+
+uint32_t RenderGraph::importImage(const std::string_view name, const vk::Image& image, const vk::ImageView& view, const vk::ImageAspectFlags aspect, const ResourceState& initial, const ResourceState& final) {
+  Resource resource{};
+  resource.name = name;
+  resource.image = image;
+  resource.view = view;
+  resource.aspect = aspect;
+  resource.state = initial;
+  resource.final = final;
+  resource.output = final.layout != vk::ImageLayout::eUndefined;
+
+  resources.push_back(resource);
+  return resources.size() - 1;
+}
+
+uint32_t RenderGraph::importBuffer(const std::string_view name, const vk::Buffer& buffer, const ResourceState& initial, bool output) {
+  Resource resource{};
+  resource.name = name;
+  resource.isBuffer = true;
+  resource.buffer = buffer;
+  resource.state = initial;
+  resource.output = output;
+
+  resources.push_back(resource);
+  return resources.size() - 1;
+}
+
+uint32_t RenderGraph::createImage(const std::string_view name, const ImageDesc& desc) {
+  Resource resource{};
+  resource.name = name;
+  resource.transient = true;
+  resource.desc = desc;
+  resource.aspect = desc.aspect;
+
+  resources.push_back(resource);
+  return resources.size() - 1;
+}
+
+RenderGraphPass& RenderGraph::addPass(const std::string_view name) {
+  RenderGraphPass pass{};
+  pass.name = name;
+
+  passes.push_back(pass);
+  return passes.back();
+}
+
+vk::Image RenderGraph::image(const uint32_t resource) const {
+  const Resource& r = resources[resource];
+  return r.transient ? physicalImages[r.physical].image : r.image;
+}
+
+vk::ImageView RenderGraph::view(const uint32_t resource) const {
+  const Resource& r = resources[resource];
+  return r.transient ? physicalImages[r.physical].view : r.view;
+}
+
+std::vector<bool> RenderGraph::cull() {
+  std::vector<bool> needed(resources.size(), false);
+  std::vector<bool> kept(passes.size(), false);
+
+  for (size_t i = 0; i < resources.size(); i++) {
+    needed[i] = resources[i].output;
+  }
+
+  for (size_t i = passes.size(); i-- > 0;) {
+    const RenderGraphPass& pass = passes[i];
+
+    bool keep = pass.sideEffects;
+
+    for (const RenderGraphAccess& access : pass.accesses) {
+      if (access.write && needed[access.resource]) {
+        keep = true;
+      }
+    }
+
+    if (!keep) {
+      continue;
+    }
+
+    kept[i] = true;
+
+    // Earlier writers only matter for what this pass reads, attachments and read-write storage also read what they overwrite
+    for (const RenderGraphAccess& access : pass.accesses) {
+      if (!access.write || (usageState(access.usage).access & ~WRITE_ACCESS)) {
+        needed[access.resource] = true;
+      }
+    }
+  }
+
+  return kept;
+}
+
+void RenderGraph::computeLifetimes(const std::vector<bool>& kept) {
+  for (size_t i = 0; i < passes.size(); i++) {
+    if (!kept[i]) {
+      continue;
+    }
+
+    for (const RenderGraphAccess& access : passes[i].accesses) {
+      Resource& resource = resources[access.resource];
+      resource.firstPass = std::min<uint32_t>(resource.firstPass, i);
+      resource.lastPass = std::max<uint32_t>(resource.lastPass, i);
+    }
+  }
+}
+
+void RenderGraph::realizeTransients() {
+  struct Candidate {
+    uint32_t resource;
+    vk::MemoryRequirements requirements;
+    uint32_t slot;
+  };
+
+  struct Slot {
+    vk::DeviceSize size;
+    vk::DeviceSize alignment;
+    uint32_t memoryTypeBits;
+    std::vector<uint32_t> occupants;
+  };
+
+  std::vector<Candidate> candidates;
+  std::vector<vk::ImageCreateInfo> createInfos;
+
+  for (size_t i = 0; i < resources.size(); i++) {
+    const Resource& resource = resources[i];
+
+    if (!resource.transient || resource.firstPass == UINT32_MAX) {
+      continue;
+    }
+
+    vk::ImageCreateInfo createInfo = vk::ImageCreateInfo{}
+      .setImageType(vk::ImageType::e2D)
+      .setFormat(resource.desc.format)
+      .setMipLevels(1)
+      .setArrayLayers(1)
+      .setSamples(vk::SampleCountFlagBits::e1)
+      .setTiling(vk::ImageTiling::eOptimal)
+      .setUsage(resource.desc.usage)
+      .setSharingMode(vk::SharingMode::eExclusive)
+      .setInitialLayout(vk::ImageLayout::eUndefined)
+      .setExtent(vk::Extent3D{resource.desc.extent, 1});
+
+    vk::DeviceImageMemoryRequirements requirementsInfo = vk::DeviceImageMemoryRequirements{}
+      .setPCreateInfo(&createInfo);
+
+    vk::MemoryRequirements requirements = device.getImageMemoryRequirements(requirementsInfo).memoryRequirements;
+
+    candidates.push_back(Candidate{static_cast<uint32_t>(i), requirements, 0});
+    createInfos.push_back(createInfo);
+  }
+
+  std::vector<uint32_t> order(candidates.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return candidates[a].requirements.size > candidates[b].requirements.size;
+  });
+
+  std::vector<Slot> slots;
+
+  for (uint32_t c : order) {
+    Candidate& candidate = candidates[c];
+    const Resource& resource = resources[candidate.resource];
+
+    uint32_t chosen = UINT32_MAX;
+
+    for (size_t s = 0; s < slots.size() && chosen == UINT32_MAX; s++) {
+      if (!(slots[s].memoryTypeBits & candidate.requirements.memoryTypeBits)) {
+        continue;
+      }
+
+      bool overlaps = false;
+
+      for (uint32_t occupant : slots[s].occupants) {
+        const Resource& other = resources[candidates[occupant].resource];
+        if (resource.firstPass <= other.lastPass && other.firstPass <= resource.lastPass) {
+          overlaps = true;
+          break;
+        }
+      }
+
+      if (!overlaps) {
+        chosen = s;
+      }
+    }
+
+    if (chosen == UINT32_MAX) {
+      slots.push_back(Slot{0, 1, ~0u, {}});
+      chosen = slots.size() - 1;
+    }
+
+    Slot& slot = slots[chosen];
+    slot.size = std::max(slot.size, candidate.requirements.size);
+    slot.alignment = std::max(slot.alignment, candidate.requirements.alignment);
+    slot.memoryTypeBits &= candidate.requirements.memoryTypeBits;
+    slot.occupants.push_back(c);
+
+    candidate.slot = chosen;
+  }
+
+  bool reusable = candidates.size() == physicalImages.size() && slots.size() == memorySlots.size();
+
+  for (size_t i = 0; i < candidates.size() && reusable; i++) {
+    const PhysicalImage& physical = physicalImages[i];
+    reusable = physical.desc == resources[candidates[i].resource].desc && physical.slot == candidates[i].slot && memorySlots[physical.slot].size >= slots[physical.slot].size;
+  }
+
+  if (!reusable) {
+    if (!physicalImages.empty() || !memorySlots.empty()) {
+      retired.push_back(Retired{physicalImages, memorySlots, framesInFlight});
+    }
+
+    physicalImages.clear();
+    memorySlots.clear();
+    transientMemorySize = 0;
+
+    for (const Slot& slot : slots) {
+      VmaAllocationCreateInfo allocationCreateInfo{};
+      allocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+      allocationCreateInfo.memoryTypeBits = slot.memoryTypeBits;
+
+      VkMemoryRequirements requirements = vk::MemoryRequirements{}
+        .setSize(slot.size)
+        .setAlignment(slot.alignment)
+        .setMemoryTypeBits(slot.memoryTypeBits);
+
+      VmaAllocation allocation;
+
+      if (vmaAllocateMemory(allocator, &requirements, &allocationCreateInfo, &allocation, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error{"Failed to allocate render graph transient memory"};
+      }
+
+      memory::track(allocator, allocation, MemoryCategory::RenderTarget);
+
+      memorySlots.push_back(MemorySlot{allocation, slot.size, ResourceState{}});
+      transientMemorySize += slot.size;
+    }
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+      const Resource& resource = resources[candidates[i].resource];
+
+      vk::Image image = device.createImage(createInfos[i]);
+
+      if (vmaBindImageMemory(allocator, memorySlots[candidates[i].slot].allocation, image) != VK_SUCCESS) {
+        throw std::runtime_error{"Failed to bind render graph transient memory"};
+      }
+
+      vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange{}
+        .setLayerCount(1)
+        .setAspectMask(resource.desc.aspect)
+        .setBaseMipLevel(0)
+        .setLevelCount(1)
+        .setBaseArrayLayer(0);
+
+      vk::ImageViewCreateInfo imageViewCreateInfo = vk::ImageViewCreateInfo{}
+        .setImage(image)
+        .setViewType(vk::ImageViewType::e2D)
+        .setFormat(resource.desc.format)
+        .setSubresourceRange(subresourceRange);
+
+      vk::ImageView view = device.createImageView(imageViewCreateInfo, nullptr);
+
+      physicalImages.push_back(PhysicalImage{resource.desc, image, view, candidates[i].slot});
+    }
+  }
+
+  for (size_t i = 0; i < candidates.size(); i++) {
+    resources[candidates[i].resource].physical = i;
+  }
+}
+
+void RenderGraph::releaseRetired() {
+  for (Retired& r : retired) {
+    r.framesLeft--;
+
+    if (r.framesLeft > 0) {
+      continue;
+    }
+
+    for (PhysicalImage& physical : r.images) {
+      device.destroyImageView(physical.view);
+      device.destroyImage(physical.image);
+    }
+
+    for (MemorySlot& slot : r.slots) {
+      memory::untrack(allocator, slot.allocation);
+      vmaFreeMemory(allocator, slot.allocation);
+    }
+  }
+
+  retired.erase(
+    std::remove_if(retired.begin(), retired.end(), [](const Retired& r) { return r.framesLeft == 0; }),
+    retired.end()
+  );
+}
+
+void RenderGraph::execute(vk::CommandBuffer& commandBuffer) {
+  TRACE_FUNCTION();
+
+  releaseRetired();
+
+  std::vector<bool> kept = cull();
+  computeLifetimes(kept);
+  realizeTransients();
+
+  barrierCount = 0;
+  barrierBatchCount = 0;
+  culledPassCount = std::count(kept.begin(), kept.end(), false);
+
+  std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+  std::vector<vk::BufferMemoryBarrier2> bufferBarriers;
+
+  auto flush = [&]() {
+    if (imageBarriers.empty() && bufferBarriers.empty()) {
+      return;
+    }
+
+    vk::DependencyInfo dependencyInfo = vk::DependencyInfo{}
+      .setImageMemoryBarriers(imageBarriers)
+      .setBufferMemoryBarriers(bufferBarriers);
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+
+    barrierCount += imageBarriers.size() + bufferBarriers.size();
+    barrierBatchCount++;
+
+    imageBarriers.clear();
+    bufferBarriers.clear();
+  };
+
+  auto transition = [&](Resource& resource, const ResourceState& src, const ResourceState& dst) {
+    if (resource.isBuffer) {
+      bufferBarriers.push_back(
+        vk::BufferMemoryBarrier2{}
+          .setBuffer(resource.buffer)
+          .setOffset(0)
+          .setSize(VK_WHOLE_SIZE)
+          .setSrcStageMask(src.stage)
+          .setSrcAccessMask(src.access & WRITE_ACCESS)
+          .setDstStageMask(dst.stage)
+          .setDstAccessMask(dst.access)
+      );
+      return;
+    }
+
+    vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange{}
+      .setLayerCount(VK_REMAINING_ARRAY_LAYERS)
+      .setAspectMask(resource.aspect)
+      .setBaseMipLevel(0)
+      .setLevelCount(VK_REMAINING_MIP_LEVELS)
+      .setBaseArrayLayer(0);
+
+    imageBarriers.push_back(
+      vk::ImageMemoryBarrier2{}
+        .setImage(resource.transient ? physicalImages[resource.physical].image : resource.image)
+        .setOldLayout(src.layout)
+        .setNewLayout(dst.layout)
+        .setSrcStageMask(src.stage)
+        .setSrcAccessMask(src.access & WRITE_ACCESS)
+        .setDstStageMask(dst.stage)
+        .setDstAccessMask(dst.access)
+        .setSubresourceRange(subresourceRange)
+    );
+  };
+
+  for (size_t i = 0; i < passes.size(); i++) {
+    if (!kept[i]) {
+      continue;
+    }
+
+    std::vector<RenderGraphAccess> merged;
+    std::vector<ResourceState> states;
+
+    for (const RenderGraphAccess& access : passes[i].accesses) {
+      ResourceState state = accessState(access);
+
+      auto it = std::find_if(merged.begin(), merged.end(), [&](const RenderGraphAccess& m) { return m.resource == access.resource; });
+
+      if (it == merged.end()) {
+        merged.push_back(access);
+        states.push_back(state);
+      } else {
+        ResourceState& existing = states[it - merged.begin()];
+        existing.stage |= state.stage;
+        existing.access |= state.access;
+        it->write = it->write || access.write;
+      }
+    }
+
+    for (size_t a = 0; a < merged.size(); a++) {
+      Resource& resource = resources[merged[a].resource];
+      ResourceState dst = states[a];
+      ResourceState src = resource.state;
+
+      if (resource.transient && resource.firstPass == i) {
+        src = memorySlots[physicalImages[resource.physical].slot].state;
+        src.layout = vk::ImageLayout::eUndefined;
+      }
+
+      if (resource.isBuffer) {
+        dst.layout = src.layout;
+      }
+
+      bool layoutChange = !resource.isBuffer && src.layout != dst.layout;
+      bool hazard = (src.access & WRITE_ACCESS) || ((dst.access & WRITE_ACCESS) && src.stage);
+
+      if (layoutChange || hazard) {
+        transition(resource, src, dst);
+        resource.state = dst;
+      } else {
+        resource.state.stage |= dst.stage;
+        resource.state.access |= dst.access;
+      }
+    }
+
+    flush();
+
+    if (passes[i].execute) {
+      passes[i].execute(commandBuffer);
+    }
+
+    for (const RenderGraphAccess& access : merged) {
+      Resource& resource = resources[access.resource];
+
+      if (resource.transient && resource.lastPass == i) {
+        memorySlots[physicalImages[resource.physical].slot].state = resource.state;
+      }
+    }
+  }
+
+  for (Resource& resource : resources) {
+    if (resource.isBuffer || resource.final.layout == vk::ImageLayout::eUndefined) {
+      continue;
+    }
+
+    if (resource.state.layout != resource.final.layout) {
+      transition(resource, resource.state, resource.final);
+      resource.state = resource.final;
+    }
+  }
+
+  flush();
+}
+
+void RenderGraph::destroy() {
+  for (Retired& r : retired) {
+    r.framesLeft = 1;
+  }
+
+  releaseRetired();
+
+  for (PhysicalImage& physical : physicalImages) {
+    device.destroyImageView(physical.view);
+    device.destroyImage(physical.image);
+  }
+
+  for (MemorySlot& slot : memorySlots) {
+    memory::untrack(allocator, slot.allocation);
+    vmaFreeMemory(allocator, slot.allocation);
+  }
+
+  physicalImages.clear();
+  memorySlots.clear();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "vk_mem_alloc.h"
+
+enum class ResourceUsage {
+  ColorAttachment,
+  DepthAttachment,
+  DepthRead,
+  FragmentSampled,
+  ComputeSampled,
+  FragmentStorageRead,
+  VertexStorageRead,
+  ComputeStorageRead,
+  ComputeStorageWrite,
+  ComputeStorageReadWrite,
+  IndirectRead,
+  TransferSrc,
+  TransferDst,
+};
+
+struct ResourceState {
+  vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+  vk::PipelineStageFlags2 stage = vk::PipelineStageFlagBits2::eNone;
+  vk::AccessFlags2 access = vk::AccessFlagBits2::eNone;
+};
+
+struct ImageDesc {
+  vk::Extent2D extent;
+  vk::Format format;
+  vk::ImageUsageFlags usage;
+  vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor;
+
+  bool operator==(const ImageDesc& other) const;
+};
+
+struct RenderGraphAccess {
+  uint32_t resource;
+  ResourceUsage usage;
+  bool write;
+};
+
+class RenderGraphPass {
+public:
+  std::string name;
+  std::vector<RenderGraphAccess> accesses;
+  std::function<void(vk::CommandBuffer&)> execute;
+  bool sideEffects = false;
+
+  RenderGraphPass& read(const uint32_t resource, const ResourceUsage usage);
+  RenderGraphPass& write(const uint32_t resource, const ResourceUsage usage);
+};
+
+class RenderGraph {
+public:
+  uint32_t barrierCount = 0;
+  uint32_t barrierBatchCount = 0;
+  uint32_t culledPassCount = 0;
+  vk::DeviceSize transientMemorySize = 0;
+
+  RenderGraph();
+  RenderGraph(const VmaAllocator& allocator, const vk::Device& device, const uint32_t framesInFlight);
+
+  void reset();
+
+  uint32_t importImage(const std::string_view name, const vk::Image& image, const vk::ImageView& view, const vk::ImageAspectFlags aspect, const ResourceState& initial, const ResourceState& final = {});
+  uint32_t importBuffer(const std::string_view name, const vk::Buffer& buffer, const ResourceState& initial = {}, bool output = false);
+  uint32_t createImage(const std::string_view name, const ImageDesc& desc);
+
+  RenderGraphPass& addPass(const std::string_view name);
+
+  vk::Image image(const uint32_t resource) const;
+  vk::ImageView view(const uint32_t resource) const;
+
+  void execute(vk::CommandBuffer& commandBuffer);
+
+  void destroy();
+private:
+  struct Resource {
+    std::string name;
+    bool isBuffer = false;
+    bool transient = false;
+    bool output = false;
+
+    vk::Image image;
+    vk::ImageView view;
+    vk::Buffer buffer;
+    vk::ImageAspectFlags aspect;
+    ImageDesc desc;
+
+    ResourceState state;
+    ResourceState final;
+
+    uint32_t physical = UINT32_MAX;
+    uint32_t firstPass = UINT32_MAX;
+    uint32_t lastPass = 0;
+  };
+
+  struct PhysicalImage {
+    ImageDesc desc;
+    vk::Image image;
+    vk::ImageView view;
+    uint32_t slot;
+  };
+
+  struct MemorySlot {
+    VmaAllocation allocation;
+    vk::DeviceSize size;
+    ResourceState state;
+  };
+
+  struct Retired {
+    std::vector<PhysicalImage> images;
+    std::vector<MemorySlot> slots;
+    uint32_t framesLeft;
+  };
+
+  VmaAllocator allocator;
+  vk::Device device;
+  uint32_t framesInFlight = 1;
+
+  std::vector<Resource> resources;
+  std::deque<RenderGraphPass> passes;
+
+  std::vector<ImageDesc> physicalDescs;
+  std::vector<PhysicalImage> physicalImages;
+  std::vector<MemorySlot> memorySlots;
+  std::vector<Retired> retired;
+
+  std::vector<bool> cull();
+  void computeLifetimes(const std::vector<bool>& kept);
+  void realizeTransients();
+  void releaseRetired();
+};
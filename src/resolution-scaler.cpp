@@ -0,0 +1,47 @@
+#include "resolution-scaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const double SMOOTHING = 0.1;
+static const float DEADBAND = 0.02f;
+static const float MAX_STEP = 0.05f;
+static const uint32_t COOLDOWN_FRAMES = 8;
+
+ResolutionScaler::ResolutionScaler() {
+}
+
+ResolutionScaler::ResolutionScaler(const double b): budget{b} {
+}
+
+float ResolutionScaler::update(const double gpuTime) {
+  if (budget <= 0.0 || gpuTime <= 0.0) {
+    return currentScale;
+  }
+
+  smoothedTime = smoothedTime == 0.0 ? gpuTime : smoothedTime + (gpuTime - smoothedTime) * SMOOTHING;
+
+  if (cooldown > 0) {
+    cooldown--;
+    return currentScale;
+  }
+
+  // GPU time follows the pixel count, which grows with the square of the scale
+  float desired = std::clamp(static_cast<float>(currentScale * std::sqrt(budget / smoothedTime)), minScale, maxScale);
+
+  if (std::abs(desired - currentScale) < DEADBAND && desired < maxScale) {
+    return currentScale;
+  }
+
+  float next = currentScale + std::clamp(desired - currentScale, -MAX_STEP, MAX_STEP);
+
+  smoothedTime *= (next * next) / (currentScale * currentScale);
+  currentScale = next;
+  cooldown = COOLDOWN_FRAMES;
+
+  return currentScale;
+}
+
+float ResolutionScaler::scale() const {
+  return currentScale;
+}
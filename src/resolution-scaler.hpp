@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+class ResolutionScaler {
+public:
+  float minScale = 0.5f;
+  float maxScale = 1.0f;
+
+  ResolutionScaler();
+  ResolutionScaler(const double budget);
+
+  float update(const double gpuTime);
+  float scale() const;
+private:
+  double budget = 0.0;
+  double smoothedTime = 0.0;
+  float currentScale = 1.0f;
+  uint32_t cooldown = 0;
+};
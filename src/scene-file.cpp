@@ -0,0 +1,171 @@
+#include "scene-file.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static uint64_t alignUp(const uint64_t value, const uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+SceneFile::SceneFile(const std::string_view path): file{path} {
+  validate(path);
+}
+
+// Written so a crafted offset cannot wrap around and pass
+static bool inBounds(const uint64_t offset, const uint64_t size, const uint64_t total) {
+  return size <= total && offset <= total - size;
+}
+
+void SceneFile::validate(const std::string_view path) const {
+  if (file.size() < sizeof(SceneFileHeader)) {
+    throw std::runtime_error{std::string{"Scene file is truncated: "} + path.data()};
+  }
+
+  const SceneFileHeader& h = header();
+
+  if (h.magic != SCENE_FILE_MAGIC || h.version != SCENE_FILE_VERSION) {
+    throw std::runtime_error{std::string{"Unsupported scene file: "} + path.data()};
+  }
+
+  uint64_t assetCount = static_cast<uint64_t>(h.meshCount) + h.textureCount;
+
+  bool fits =
+    h.assetsOffset % alignof(SceneFileAsset) == 0 &&
+    h.objectsOffset % alignof(SceneFileObject) == 0 &&
+    inBounds(h.assetsOffset, assetCount * sizeof(SceneFileAsset), file.size()) &&
+    inBounds(h.objectsOffset, static_cast<uint64_t>(h.objectCount) * sizeof(SceneFileObject), file.size()) &&
+    inBounds(h.stringsOffset, h.stringsSize, file.size());
+
+  if (!fits) {
+    throw std::runtime_error{std::string{"Scene file is truncated: "} + path.data()};
+  }
+
+  for (uint32_t i = 0; i < assetCount; i++) {
+    if (!inBounds(assets()[i].pathOffset, assets()[i].pathLength, h.stringsSize)) {
+      throw std::runtime_error{std::string{"Scene file has an invalid asset path: "} + path.data()};
+    }
+  }
+
+  for (uint32_t i = 0; i < h.objectCount; i++) {
+    if (objects()[i].meshIdx >= h.meshCount || objects()[i].textureIdx >= h.textureCount) {
+      throw std::runtime_error{std::string{"Scene file has an invalid asset index: "} + path.data()};
+    }
+  }
+}
+
+const SceneFileHeader& SceneFile::header() const {
+  return *reinterpret_cast<const SceneFileHeader*>(file.data());
+}
+
+const SceneFileAsset* SceneFile::assets() const {
+  return reinterpret_cast<const SceneFileAsset*>(file.data() + header().assetsOffset);
+}
+
+const SceneFileObject* SceneFile::objects() const {
+  return reinterpret_cast<const SceneFileObject*>(file.data() + header().objectsOffset);
+}
+
+std::string_view SceneFile::assetPath(const uint32_t idx) const {
+  const SceneFileAsset& asset = assets()[idx];
+  return std::string_view{file.data() + header().stringsOffset + asset.pathOffset, asset.pathLength};
+}
+
+std::string_view SceneFile::meshPath(const uint32_t idx) const {
+  return assetPath(idx);
+}
+
+std::string_view SceneFile::texturePath(const uint32_t idx) const {
+  return assetPath(header().meshCount + idx);
+}
+
+std::string SceneFile::toText() const {
+  const SceneFileHeader& h = header();
+  std::string text;
+  char line[512];
+
+  std::snprintf(line, sizeof(line), "scene version %u\n", h.version);
+  text += line;
+
+  std::snprintf(line, sizeof(line), "meshes %u\n", h.meshCount);
+  text += line;
+  for (uint32_t i = 0; i < h.meshCount; i++) {
+    text += "  " + std::to_string(i) + " " + std::string{meshPath(i)} + "\n";
+  }
+
+  std::snprintf(line, sizeof(line), "textures %u\n", h.textureCount);
+  text += line;
+  for (uint32_t i = 0; i < h.textureCount; i++) {
+    text += "  " + std::to_string(i) + " " + std::string{texturePath(i)} + "\n";
+  }
+
+  if (h.light.enabled) {
+    std::snprintf(
+      line, sizeof(line), "light pos %g %g %g color %g %g %g ambient %g\n",
+      h.light.pos[0], h.light.pos[1], h.light.pos[2],
+      h.light.color[0], h.light.color[1], h.light.color[2],
+      h.light.ambient
+    );
+    text += line;
+  }
+
+  std::snprintf(line, sizeof(line), "objects %u\n", h.objectCount);
+  text += line;
+  for (uint32_t i = 0; i < h.objectCount; i++) {
+    const SceneFileObject& o = objects()[i];
+
+    std::snprintf(
+      line, sizeof(line),
+      "  %u mesh %u texture %u pipeline %u pos %g %g %g rot %g %g %g %g scale %g %g %g color %g %g %g\n",
+      i, o.meshIdx, o.textureIdx, o.pipelineIdx,
+      o.position[0], o.position[1], o.position[2],
+      o.rotation[0], o.rotation[1], o.rotation[2], o.rotation[3],
+      o.scale[0], o.scale[1], o.scale[2],
+      o.color[0], o.color[1], o.color[2]
+    );
+    text += line;
+  }
+
+  return text;
+}
+
+void writeSceneFile(const std::string_view path, const SceneDesc& desc) {
+  std::vector<SceneFileAsset> assets;
+  std::string strings;
+
+  for (const std::vector<std::string>* paths : {&desc.meshes, &desc.textures}) {
+    for (const std::string& assetPath : *paths) {
+      assets.push_back(SceneFileAsset{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(assetPath.size())});
+      strings += assetPath;
+    }
+  }
+
+  SceneFileHeader header{};
+  header.magic = SCENE_FILE_MAGIC;
+  header.version = SCENE_FILE_VERSION;
+  header.meshCount = desc.meshes.size();
+  header.textureCount = desc.textures.size();
+  header.objectCount = desc.objects.size();
+  header.stringsSize = strings.size();
+  header.light = desc.light;
+
+  header.assetsOffset = alignUp(sizeof(SceneFileHeader), 16);
+  header.objectsOffset = alignUp(header.assetsOffset + assets.size() * sizeof(SceneFileAsset), 16);
+  header.stringsOffset = header.objectsOffset + desc.objects.size() * sizeof(SceneFileObject);
+
+  std::vector<char> bytes(header.stringsOffset + strings.size(), 0);
+
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  std::memcpy(bytes.data() + header.assetsOffset, assets.data(), assets.size() * sizeof(SceneFileAsset));
+  std::memcpy(bytes.data() + header.objectsOffset, desc.objects.data(), desc.objects.size() * sizeof(SceneFileObject));
+  std::memcpy(bytes.data() + header.stringsOffset, strings.data(), strings.size());
+
+  std::ofstream file{path.data(), std::ios::out | std::ios::binary | std::ios::trunc};
+
+  if (!file.is_open()) {
+    throw std::runtime_error{std::string{"Failed to open file: "} + path.data()};
+  }
+
+  file.write(bytes.data(), bytes.size());
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "fs.hpp"
+
+const uint32_t SCENE_FILE_MAGIC = 0x53524b56;
+const uint32_t SCENE_FILE_VERSION = 1;
+
+struct SceneFileLight {
+  float pos[3];
+  float color[3];
+  float ambient;
+  uint32_t enabled;
+};
+
+struct SceneFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t meshCount;
+  uint32_t textureCount;
+  uint32_t objectCount;
+  uint32_t stringsSize;
+  uint64_t assetsOffset;
+  uint64_t objectsOffset;
+  uint64_t stringsOffset;
+  SceneFileLight light;
+};
+
+struct SceneFileAsset {
+  uint32_t pathOffset;
+  uint32_t pathLength;
+};
+
+struct SceneFileObject {
+  float position[3];
+  float rotation[4];
+  float scale[3];
+  float color[3];
+  uint32_t meshIdx;
+  uint32_t textureIdx;
+  uint32_t pipelineIdx;
+};
+
+static_assert(sizeof(SceneFileHeader) == 80);
+static_assert(sizeof(SceneFileObject) == 64);
+
+struct SceneDesc {
+  std::vector<std::string> meshes;
+  std::vector<std::string> textures;
+  std::vector<SceneFileObject> objects;
+  SceneFileLight light{};
+};
+
+class SceneFile {
+public:
+  SceneFile(const std::string_view path);
+
+  const SceneFileHeader& header() const;
+  const SceneFileObject* objects() const;
+
+  std::string_view meshPath(const uint32_t idx) const;
+  std::string_view texturePath(const uint32_t idx) const;
+
+  std::string toText() const;
+private:
+  fs::MappedFile file;
+
+  const SceneFileAsset* assets() const;
+  std::string_view assetPath(const uint32_t idx) const;
+  void validate(const std::string_view path) const;
+};
+
+void writeSceneFile(const std::string_view path, const SceneDesc& desc);
@@ -25,7 +25,8 @@ struct Camera {
 
   CameraMode mode = CameraMode::Fixed;
 
-  float velocity = 0.1f;
+  // World units per second while a movement key is held
+  float velocity = 10.0f;
   float sensitivity = 0.1f;
 };
 
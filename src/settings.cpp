@@ -0,0 +1,126 @@
+#include "settings.hpp"
+
+#include <stdexcept>
+#include <string>
+
+static uint32_t parseCount(const std::string_view option, const std::string_view value) {
+  uint32_t count = 0;
+
+  try {
+    count = std::stoul(std::string{value});
+  } catch (const std::exception&) {
+    throw std::runtime_error{std::string{"Invalid value for "} + std::string{option} + ": " + std::string{value}};
+  }
+
+  if (count == 0) {
+    throw std::runtime_error{std::string{option} + " must be at least 1"};
+  }
+
+  return count;
+}
+
+static double parseRate(const std::string_view option, const std::string_view value) {
+  double rate = 0.0;
+
+  try {
+    rate = std::stod(std::string{value});
+  } catch (const std::exception&) {
+    throw std::runtime_error{std::string{"Invalid value for "} + std::string{option} + ": " + std::string{value}};
+  }
+
+  if (rate < 0.0) {
+    throw std::runtime_error{std::string{option} + " must not be negative"};
+  }
+
+  return rate;
+}
+
+vk::PresentModeKHR parsePresentMode(const std::string_view name) {
+  if (name == "fifo") {
+    return vk::PresentModeKHR::eFifo;
+  }
+  if (name == "fifo-relaxed") {
+    return vk::PresentModeKHR::eFifoRelaxed;
+  }
+  if (name == "mailbox") {
+    return vk::PresentModeKHR::eMailbox;
+  }
+  if (name == "immediate") {
+    return vk::PresentModeKHR::eImmediate;
+  }
+
+  throw std::runtime_error{std::string{"Unknown present mode: "} + std::string{name}};
+}
+
+std::string_view presentModeName(const vk::PresentModeKHR presentMode) {
+  switch (presentMode) {
+    case vk::PresentModeKHR::eFifo:
+      return "fifo";
+    case vk::PresentModeKHR::eFifoRelaxed:
+      return "fifo-relaxed";
+    case vk::PresentModeKHR::eMailbox:
+      return "mailbox";
+    case vk::PresentModeKHR::eImmediate:
+      return "immediate";
+    default:
+      return "unknown";
+  }
+}
+
+Settings parseSettings(int argc, char** argv) {
+  Settings settings{};
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    size_t separator = arg.find('=');
+
+    std::string_view option = arg.substr(0, separator);
+    std::string_view value = separator == std::string_view::npos ? std::string_view{} : arg.substr(separator + 1);
+
+    if (option == "--frames-in-flight") {
+      settings.framesInFlight = parseCount(option, value);
+    } else if (option == "--swapchain-images") {
+      settings.swapchainImageCount = parseCount(option, value);
+    } else if (option == "--present-mode") {
+      settings.presentMode = parsePresentMode(value);
+    } else if (option == "--fps-cap") {
+      settings.targetFrameRate = parseRate(option, value);
+    } else if (option == "--low-latency") {
+      settings.lowLatency = true;
+    } else if (option == "--stats") {
+      settings.printStats = true;
+    } else if (option == "--scene") {
+      settings.scenePath = value;
+    } else if (option == "--point-lights") {
+      settings.pointLightCount = parseCount(option, value);
+    } else if (option == "--depth-prepass") {
+      settings.depthPrepass = true;
+    } else if (option == "--occlusion-culling") {
+      settings.occlusionCulling = true;
+    } else if (option == "--dynamic-resolution") {
+      settings.dynamicResolution = true;
+    } else if (option == "--gpu-budget") {
+      settings.gpuBudget = parseRate(option, value);
+    } else if (option == "--texture-budget") {
+      settings.textureBudget = parseCount(option, value);
+    } else if (option == "--memory-report") {
+      settings.memoryReportPath = value;
+    } else if (option == "--archive") {
+      settings.archivePath = value;
+    } else if (option == "--trace") {
+      settings.tracePath = value;
+    } else if (option == "--worker-threads") {
+      settings.workerThreads = parseCount(option, value);
+    } else if (option == "--sim-rate") {
+      settings.simulationRate = parseRate(option, value);
+
+      if (settings.simulationRate == 0.0) {
+        throw std::runtime_error{"--sim-rate must be positive"};
+      }
+    } else {
+      throw std::runtime_error{std::string{"Unknown option: "} + std::string{arg}};
+    }
+  }
+
+  return settings;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vulkan/vulkan.hpp>
+
+struct Settings {
+  uint32_t framesInFlight = 2;
+  uint32_t swapchainImageCount = 3;
+  vk::PresentModeKHR presentMode = vk::PresentModeKHR::eMailbox;
+  double targetFrameRate = 0.0;
+  bool lowLatency = false;
+  bool printStats = false;
+  std::string scenePath;
+  uint32_t pointLightCount = 0;
+  bool depthPrepass = false;
+  bool occlusionCulling = false;
+  bool dynamicResolution = false;
+  double gpuBudget = 0.0;
+  uint32_t textureBudget = 0;
+  std::string memoryReportPath = "memory-report.json";
+  std::string archivePath;
+  std::string tracePath;
+  double simulationRate = 60.0;
+  uint32_t workerThreads = 0;
+};
+
+Settings parseSettings(int argc, char** argv);
+vk::PresentModeKHR parsePresentMode(const std::string_view name);
+std::string_view presentModeName(const vk::PresentModeKHR presentMode);
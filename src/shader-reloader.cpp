@@ -0,0 +1,211 @@
+#include "shader-reloader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <utility>
+#include "trace.hpp"
+
+static const int POLL_TIMEOUT_MS = 100;
+static const std::chrono::milliseconds SETTLE_TIME{50};
+
+static std::string_view fileName(const std::string_view path) {
+  size_t separator = path.find_last_of('/');
+  return separator == std::string_view::npos ? path : path.substr(separator + 1);
+}
+
+ShaderReloader::ShaderReloader() {
+}
+
+void ShaderReloader::start(const vk::Device& d, const std::string_view dir) {
+  device = d;
+  directory = dir;
+
+  inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (inotifyFd < 0) {
+    throw std::runtime_error{"Failed to initialize inotify"};
+  }
+
+  // glslc rewrites outputs in place, other tools write a temporary and rename it over the target
+  if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    close(inotifyFd);
+    inotifyFd = -1;
+    throw std::runtime_error{"Failed to watch shader directory: " + directory};
+  }
+
+  running = true;
+  worker = std::thread{&ShaderReloader::run, this};
+}
+
+void ShaderReloader::watch(const uint32_t pipelineIdx, const Pipeline& pipeline) {
+  std::lock_guard<std::mutex> lock{mutex};
+  watched.push_back(WatchedPipeline{pipelineIdx, pipeline});
+}
+
+void ShaderReloader::watch(const ShaderPass pass, const std::vector<std::string>& paths) {
+  std::lock_guard<std::mutex> lock{mutex};
+  watchedPasses.push_back(WatchedPass{pass, paths});
+}
+
+void ShaderReloader::forget(const uint32_t pipelineIdx) {
+  std::unique_lock<std::mutex> lock{mutex};
+
+  watched.erase(std::remove_if(watched.begin(), watched.end(), [&](const WatchedPipeline& w) {
+    return w.pipelineIdx == pipelineIdx;
+  }), watched.end());
+
+  // A build in flight may still be using the pipeline layout the caller is about to retire
+  idle.wait(lock, [&]() { return !building; });
+}
+
+std::vector<ShaderReload> ShaderReloader::take() {
+  std::lock_guard<std::mutex> lock{mutex};
+  return std::exchange(ready, {});
+}
+
+std::vector<ShaderPass> ShaderReloader::takePasses() {
+  std::lock_guard<std::mutex> lock{mutex};
+  return std::exchange(readyPasses, {});
+}
+
+std::vector<std::string> ShaderReloader::readChanges() {
+  std::vector<std::string> changes;
+  alignas(inotify_event) char buffer[4096];
+  ssize_t length;
+
+  while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+    for (char* ptr = buffer; ptr < buffer + length;) {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+
+      if (event->len > 0 && std::find(changes.begin(), changes.end(), event->name) == changes.end()) {
+        changes.push_back(event->name);
+      }
+
+      ptr += sizeof(inotify_event) + event->len;
+    }
+  }
+
+  return changes;
+}
+
+void ShaderReloader::run() {
+  trace::setThreadName("shader-reloader");
+
+  pollfd pfd{inotifyFd, POLLIN, 0};
+
+  while (running) {
+    if (poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0) {
+      continue;
+    }
+
+    // Let a batch of outputs from one compile land before rebuilding
+    std::this_thread::sleep_for(SETTLE_TIME);
+
+    std::vector<std::string> changes = readChanges();
+    std::vector<WatchedPipeline> affected;
+    std::vector<std::string> unmatched;
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+
+      for (const WatchedPipeline& w : watched) {
+        bool vertexChanged = std::find(changes.begin(), changes.end(), fileName(w.pipeline.vertexShader.path)) != changes.end();
+        bool fragmentChanged = std::find(changes.begin(), changes.end(), fileName(w.pipeline.fragmentShader.path)) != changes.end();
+
+        if (vertexChanged || fragmentChanged) {
+          affected.push_back(w);
+        }
+      }
+
+      for (const WatchedPass& w : watchedPasses) {
+        bool changed = std::any_of(w.paths.begin(), w.paths.end(), [&](const std::string& path) {
+          return std::find(changes.begin(), changes.end(), fileName(path)) != changes.end();
+        });
+
+        if (changed && std::find(readyPasses.begin(), readyPasses.end(), w.pass) == readyPasses.end()) {
+          readyPasses.push_back(w.pass);
+        }
+      }
+
+      for (const std::string& change : changes) {
+        if (change.size() < 4 || change.compare(change.size() - 4, 4, ".spv") != 0) {
+          continue;
+        }
+
+        bool used = std::any_of(watched.begin(), watched.end(), [&](const WatchedPipeline& w) {
+          return fileName(w.pipeline.vertexShader.path) == change || fileName(w.pipeline.fragmentShader.path) == change;
+        }) || std::any_of(watchedPasses.begin(), watchedPasses.end(), [&](const WatchedPass& w) {
+          return std::any_of(w.paths.begin(), w.paths.end(), [&](const std::string& path) { return fileName(path) == change; });
+        });
+
+        if (!used) {
+          unmatched.push_back(change);
+        }
+      }
+
+      building = !affected.empty();
+    }
+
+    for (const std::string& change : unmatched) {
+      std::fprintf(stderr, "No reloadable pipeline uses %s\n", change.c_str());
+    }
+
+    TRACE_BEGIN(buildZone, "rebuild pipelines");
+    std::vector<ShaderReload> built;
+
+    for (const WatchedPipeline& w : affected) {
+      try {
+        Shader vertexShader{device, w.pipeline.vertexShader.path};
+        Shader fragmentShader{device, w.pipeline.fragmentShader.path};
+
+        try {
+          built.push_back(ShaderReload{w.pipelineIdx, vertexShader, fragmentShader, w.pipeline.build(device, vertexShader.module, fragmentShader.module)});
+        } catch (const std::exception&) {
+          vertexShader.destroy(device);
+          fragmentShader.destroy(device);
+          throw;
+        }
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "Failed to reload %s + %s: %s\n", w.pipeline.vertexShader.path.c_str(), w.pipeline.fragmentShader.path.c_str(), e.what());
+      }
+    }
+
+    TRACE_END(buildZone);
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      ready.insert(ready.end(), built.begin(), built.end());
+      building = false;
+    }
+
+    idle.notify_all();
+  }
+}
+
+void ShaderReloader::stop() {
+  if (!running) {
+    return;
+  }
+
+  running = false;
+  worker.join();
+
+  close(inotifyFd);
+  inotifyFd = -1;
+
+  for (ShaderReload& reload : ready) {
+    device.destroyPipeline(reload.graphicsPipeline);
+    reload.vertexShader.destroy(device);
+    reload.fragmentShader.destroy(device);
+  }
+
+  ready.clear();
+  watched.clear();
+  readyPasses.clear();
+  watchedPasses.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "vk-pipeline.hpp"
+#include "vk-shader.hpp"
+
+struct ShaderReload {
+  uint32_t pipelineIdx;
+  Shader vertexShader;
+  Shader fragmentShader;
+  vk::Pipeline graphicsPipeline;
+};
+
+// Passes whose pipelines are rebuilt by their owners on the render thread
+enum class ShaderPass : uint32_t {
+  Shadow,
+  DepthPrepass,
+  OcclusionCulling,
+  ClusteredLights,
+};
+
+class ShaderReloader {
+public:
+  ShaderReloader();
+
+  void start(const vk::Device& device, const std::string_view directory);
+  void watch(const uint32_t pipelineIdx, const Pipeline& pipeline);
+  void watch(const ShaderPass pass, const std::vector<std::string>& paths);
+  void forget(const uint32_t pipelineIdx);
+  std::vector<ShaderReload> take();
+  std::vector<ShaderPass> takePasses();
+  void stop();
+private:
+  struct WatchedPipeline {
+    uint32_t pipelineIdx;
+    Pipeline pipeline;
+  };
+
+  struct WatchedPass {
+    ShaderPass pass;
+    std::vector<std::string> paths;
+  };
+
+  vk::Device device;
+  std::string directory;
+  int inotifyFd = -1;
+
+  std::thread worker;
+  std::atomic<bool> running{false};
+
+  std::mutex mutex;
+  std::condition_variable idle;
+  bool building = false;
+  std::vector<WatchedPipeline> watched;
+  std::vector<ShaderReload> ready;
+  std::vector<WatchedPass> watchedPasses;
+  std::vector<ShaderPass> readyPasses;
+
+  void run();
+  std::vector<std::string> readChanges();
+};
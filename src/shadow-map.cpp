@@ -0,0 +1,341 @@
+#include "shadow-map.hpp"
+#include "memory-stats.hpp"
+
+#include <stdexcept>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+static const vk::Format SHADOW_FORMAT = vk::Format::eD32Sfloat;
+
+ShadowMap::ShadowMap() {
+}
+
+ShadowMap::ShadowMap(const VmaAllocator& allocator, const vk::Device& device, const uint32_t r, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts): resolution{r} {
+  createImage(allocator, device);
+  createSampler(device);
+  createPipeline(device, descriptorSetLayouts);
+}
+
+void ShadowMap::createImage(const VmaAllocator& allocator, const vk::Device& device) {
+  VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{}
+    .setFlags(vk::ImageCreateFlagBits::eCubeCompatible)
+    .setImageType(vk::ImageType::e2D)
+    .setFormat(SHADOW_FORMAT)
+    .setMipLevels(1)
+    .setArrayLayers(6)
+    .setSamples(vk::SampleCountFlagBits::e1)
+    .setTiling(vk::ImageTiling::eOptimal)
+    .setUsage(vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled)
+    .setSharingMode(vk::SharingMode::eExclusive)
+    .setInitialLayout(vk::ImageLayout::eUndefined)
+    .setExtent(vk::Extent3D{resolution, resolution, 1});
+
+  VmaAllocationCreateInfo imageAllocationCreateInfo{};
+  imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+  imageAllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+  VkImage vkImage;
+
+  if (vmaCreateImage(allocator, &imageCreateInfo, &imageAllocationCreateInfo, &vkImage, &allocation, nullptr) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create the shadow map"};
+  }
+
+  memory::track(allocator, allocation, MemoryCategory::RenderTarget);
+
+  image = vkImage;
+
+  vk::ImageSubresourceRange cubeRange = vk::ImageSubresourceRange{}
+    .setLayerCount(6)
+    .setAspectMask(vk::ImageAspectFlagBits::eDepth)
+    .setBaseMipLevel(0)
+    .setLevelCount(1)
+    .setBaseArrayLayer(0);
+
+  vk::ImageViewCreateInfo cubeViewCreateInfo = vk::ImageViewCreateInfo{}
+    .setImage(image)
+    .setViewType(vk::ImageViewType::eCube)
+    .setFormat(SHADOW_FORMAT)
+    .setSubresourceRange(cubeRange);
+
+  cubeView = device.createImageView(cubeViewCreateInfo, nullptr);
+
+  for (uint32_t face = 0; face < faceViews.size(); face++) {
+    vk::ImageSubresourceRange faceRange = vk::ImageSubresourceRange{}
+      .setLayerCount(1)
+      .setAspectMask(vk::ImageAspectFlagBits::eDepth)
+      .setBaseMipLevel(0)
+      .setLevelCount(1)
+      .setBaseArrayLayer(face);
+
+    vk::ImageViewCreateInfo faceViewCreateInfo = vk::ImageViewCreateInfo{}
+      .setImage(image)
+      .setViewType(vk::ImageViewType::e2D)
+      .setFormat(SHADOW_FORMAT)
+      .setSubresourceRange(faceRange);
+
+    faceViews[face] = device.createImageView(faceViewCreateInfo, nullptr);
+  }
+}
+
+void ShadowMap::createSampler(const vk::Device& device) {
+  vk::SamplerCreateInfo samplerCreateInfo = vk::SamplerCreateInfo{}
+    .setMagFilter(vk::Filter::eLinear)
+    .setMinFilter(vk::Filter::eLinear)
+    .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+    .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+    .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+    .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+    .setAnisotropyEnable(0)
+    .setCompareEnable(1)
+    .setCompareOp(vk::CompareOp::eLessOrEqual);
+
+  sampler = device.createSampler(samplerCreateInfo);
+}
+
+void ShadowMap::createPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts) {
+  Shader vertexShader{device, "./shaders/shadow.vert.spv"};
+  Shader fragmentShader{device, "./shaders/shadow.frag.spv"};
+
+  vk::PipelineShaderStageCreateInfo vertexShaderStage = vk::PipelineShaderStageCreateInfo{}
+    .setStage(vk::ShaderStageFlagBits::eVertex)
+    .setModule(vertexShader.module)
+    .setPName("main");
+
+  vk::PipelineShaderStageCreateInfo fragmentShaderStage = vk::PipelineShaderStageCreateInfo{}
+    .setStage(vk::ShaderStageFlagBits::eFragment)
+    .setModule(fragmentShader.module)
+    .setPName("main");
+
+  std::vector<vk::PipelineShaderStageCreateInfo> stages{
+    vertexShaderStage,
+    fragmentShaderStage,
+  };
+
+  vk::PipelineRenderingCreateInfo pipelineRenderingCreateInfo = vk::PipelineRenderingCreateInfo{}
+    .setColorAttachmentCount(0)
+    .setDepthAttachmentFormat(SHADOW_FORMAT);
+
+  vk::VertexInputBindingDescription inputBinding = vk::VertexInputBindingDescription{}
+    .setStride(sizeof(float) * 3)
+    .setInputRate(vk::VertexInputRate::eVertex)
+    .setBinding(0);
+
+  vk::VertexInputAttributeDescription positionAttribute = vk::VertexInputAttributeDescription{}
+    .setBinding(0)
+    .setLocation(0)
+    .setOffset(0)
+    .setFormat(vk::Format::eR32G32B32Sfloat);
+
+  vk::PipelineVertexInputStateCreateInfo vertexInputState = vk::PipelineVertexInputStateCreateInfo{}
+    .setVertexBindingDescriptions(inputBinding)
+    .setVertexBindingDescriptionCount(1)
+    .setVertexAttributeDescriptions(positionAttribute)
+    .setVertexAttributeDescriptionCount(1);
+
+  vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState = vk::PipelineInputAssemblyStateCreateInfo{}
+    .setTopology(vk::PrimitiveTopology::eTriangleList)
+    .setPrimitiveRestartEnable(0);
+
+  vk::PipelineViewportStateCreateInfo viewportState = vk::PipelineViewportStateCreateInfo{}
+    .setViewportCount(1)
+    .setScissorCount(1);
+
+  vk::PipelineRasterizationStateCreateInfo rasterizationState = vk::PipelineRasterizationStateCreateInfo{}
+    .setRasterizerDiscardEnable(0)
+    .setDepthClampEnable(0)
+    .setDepthBiasEnable(0)
+    .setPolygonMode(vk::PolygonMode::eFill)
+    .setCullMode(vk::CullModeFlagBits::eNone)
+    .setFrontFace(vk::FrontFace::eCounterClockwise)
+    .setLineWidth(1.0f);
+
+  vk::PipelineMultisampleStateCreateInfo multisampleState = vk::PipelineMultisampleStateCreateInfo{}
+    .setRasterizationSamples(vk::SampleCountFlagBits::e1)
+    .setSampleShadingEnable(0);
+
+  vk::PipelineDepthStencilStateCreateInfo depthStencilState = vk::PipelineDepthStencilStateCreateInfo{}
+    .setDepthTestEnable(1)
+    .setDepthWriteEnable(1)
+    .setStencilTestEnable(0)
+    .setDepthBoundsTestEnable(0)
+    .setDepthCompareOp(vk::CompareOp::eLessOrEqual);
+
+  vk::PipelineColorBlendStateCreateInfo colorBlendState = vk::PipelineColorBlendStateCreateInfo{}
+    .setAttachmentCount(0);
+
+  vk::DynamicState dynamicStates[2] = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+
+  vk::PipelineDynamicStateCreateInfo dynamicState = vk::PipelineDynamicStateCreateInfo{}
+    .setDynamicStates(dynamicStates)
+    .setDynamicStateCount(2);
+
+  vk::PushConstantRange pushConstantRange = vk::PushConstantRange{}
+    .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment)
+    .setOffset(0)
+    .setSize(sizeof(ShadowConstants));
+
+  vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
+    .setSetLayouts(descriptorSetLayouts)
+    .setSetLayoutCount(descriptorSetLayouts.size())
+    .setPushConstantRanges(pushConstantRange)
+    .setPushConstantRangeCount(1);
+
+  pipelineLayout = device.createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
+
+  vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo = vk::GraphicsPipelineCreateInfo{}
+    .setPNext(&pipelineRenderingCreateInfo)
+    .setStages(stages)
+    .setStageCount(stages.size())
+    .setPVertexInputState(&vertexInputState)
+    .setPInputAssemblyState(&inputAssemblyState)
+    .setPViewportState(&viewportState)
+    .setPRasterizationState(&rasterizationState)
+    .setPMultisampleState(&multisampleState)
+    .setPDepthStencilState(&depthStencilState)
+    .setPColorBlendState(&colorBlendState)
+    .setPDynamicState(&dynamicState)
+    .setLayout(pipelineLayout);
+
+  vk::ResultValue<vk::Pipeline> pipelineResult = device.createGraphicsPipeline(VK_NULL_HANDLE, graphicsPipelineCreateInfo);
+
+  vertexShader.destroy(device);
+  fragmentShader.destroy(device);
+
+  if (pipelineResult.result != vk::Result::eSuccess) {
+    throw std::runtime_error{"Failed to create the shadow pipeline"};
+  }
+
+  pipeline = pipelineResult.value;
+}
+
+void ShadowMap::reloadPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, DeletionQueue& deletionQueue, const uint64_t serial) {
+  vk::PipelineLayout oldPipelineLayout = pipelineLayout;
+  vk::Pipeline oldPipeline = pipeline;
+
+  try {
+    createPipeline(device, descriptorSetLayouts);
+  } catch (const std::exception&) {
+    // Keep drawing with the old pipeline when the new shaders fail to build
+    if (pipelineLayout != oldPipelineLayout) {
+      device.destroyPipelineLayout(pipelineLayout);
+    }
+
+    pipelineLayout = oldPipelineLayout;
+    pipeline = oldPipeline;
+    throw;
+  }
+
+  deletionQueue.push(serial, [=]() {
+    device.destroyPipeline(oldPipeline);
+    device.destroyPipelineLayout(oldPipelineLayout);
+  });
+}
+
+void ShadowMap::writeDescriptor(const vk::Device& device, const vk::DescriptorSet& descriptorSet, const uint32_t binding) {
+  vk::DescriptorImageInfo imageInfo = vk::DescriptorImageInfo{}
+    .setSampler(sampler)
+    .setImageView(cubeView)
+    .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  vk::WriteDescriptorSet shadowWrite = vk::WriteDescriptorSet{}
+    .setDstSet(descriptorSet)
+    .setDstBinding(binding)
+    .setDescriptorCount(1)
+    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+    .setImageInfo(imageInfo);
+
+  device.updateDescriptorSets(1, &shadowWrite, 0, nullptr);
+}
+
+void ShadowMap::record(vk::CommandBuffer& commandBuffer, const vk::DescriptorSet& projectionSet, const vk::DescriptorSet& objectSet, const glm::vec3& lightPos, const std::vector<Object>& objects, const std::vector<Mesh>& meshes) {
+  const glm::vec3 targets[6] = {
+    glm::vec3{1.0f, 0.0f, 0.0f},
+    glm::vec3{-1.0f, 0.0f, 0.0f},
+    glm::vec3{0.0f, 1.0f, 0.0f},
+    glm::vec3{0.0f, -1.0f, 0.0f},
+    glm::vec3{0.0f, 0.0f, 1.0f},
+    glm::vec3{0.0f, 0.0f, -1.0f},
+  };
+
+  const glm::vec3 ups[6] = {
+    glm::vec3{0.0f, -1.0f, 0.0f},
+    glm::vec3{0.0f, -1.0f, 0.0f},
+    glm::vec3{0.0f, 0.0f, 1.0f},
+    glm::vec3{0.0f, 0.0f, -1.0f},
+    glm::vec3{0.0f, -1.0f, 0.0f},
+    glm::vec3{0.0f, -1.0f, 0.0f},
+  };
+
+  glm::mat4 perspective = glm::perspective(glm::radians(90.0f), 1.0f, near, far);
+
+  vk::Viewport viewport = vk::Viewport{0.0f, 0.0f, static_cast<float>(resolution), static_cast<float>(resolution), 0.0f, 1.0f};
+  vk::Rect2D scissors = vk::Rect2D{vk::Offset2D{0, 0}, vk::Extent2D{resolution, resolution}};
+
+  vk::ClearValue clearValue = vk::ClearValue{}
+    .setDepthStencil(vk::ClearDepthStencilValue{1.0f, 0});
+
+  vk::DeviceSize offsets[1] = {0};
+
+  // Same set numbers as the forward pipelines, so casters get the same projection model as the lit geometry
+  std::vector<vk::DescriptorSet> sets{projectionSet, objectSet};
+
+  for (uint32_t face = 0; face < 6; face++) {
+    vk::RenderingAttachmentInfo depthAttachment = vk::RenderingAttachmentInfo{}
+      .setImageView(faceViews[face])
+      .setImageLayout(vk::ImageLayout::eDepthAttachmentOptimal)
+      .setLoadOp(vk::AttachmentLoadOp::eClear)
+      .setStoreOp(vk::AttachmentStoreOp::eStore)
+      .setClearValue(clearValue);
+
+    vk::RenderingInfo renderingInfo = vk::RenderingInfo{}
+      .setRenderArea(scissors)
+      .setLayerCount(1)
+      .setViewMask(0)
+      .setColorAttachmentCount(0)
+      .setPDepthAttachment(&depthAttachment);
+
+    commandBuffer.beginRendering(renderingInfo);
+
+    commandBuffer.setViewport(0, 1, &viewport);
+    commandBuffer.setScissor(0, 1, &scissors);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 1, sets.size(), sets.data(), 0, nullptr);
+
+    ShadowConstants constants{};
+    constants.viewProjection = perspective * glm::lookAt(lightPos, lightPos + targets[face], ups[face]);
+    constants.light = glm::vec4{lightPos, far};
+
+    for (size_t i = 0; i < objects.size(); i++) {
+      const Object& object = objects[i];
+
+      if (!object.castsShadow) {
+        continue;
+      }
+
+      const Mesh& mesh = meshes[object.meshIdx];
+
+      constants.objectIdx = i;
+
+      commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(ShadowConstants), &constants);
+      commandBuffer.bindVertexBuffers(0, 1, &mesh.positionBuffer.buffer, offsets);
+      commandBuffer.bindIndexBuffer(mesh.indexBuffer.buffer, 0, vk::IndexType::eUint16);
+      commandBuffer.drawIndexed(mesh.indicesCount, 1, 0, 0, 0);
+    }
+
+    commandBuffer.endRendering();
+  }
+}
+
+void ShadowMap::destroy(const VmaAllocator& allocator, const vk::Device& device) {
+  device.destroyPipeline(pipeline);
+  device.destroyPipelineLayout(pipelineLayout);
+  device.destroySampler(sampler);
+
+  for (vk::ImageView& faceView : faceViews) {
+    device.destroyImageView(faceView);
+  }
+
+  device.destroyImageView(cubeView);
+  memory::untrack(allocator, allocation);
+  vmaDestroyImage(allocator, image, allocation);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+#include "deletion-queue.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include "render-graph.hpp"
+#include "vk-shader.hpp"
+#include "vk_mem_alloc.h"
+
+struct ShadowConstants {
+  alignas(16) glm::mat4 viewProjection;
+  alignas(16) glm::vec4 light;
+  alignas(4) uint32_t objectIdx;
+};
+
+struct ShadowStats {
+  uint32_t renderedFrames = 0;
+  uint32_t reusedFrames = 0;
+};
+
+class ShadowMap {
+public:
+  vk::Image image;
+  VmaAllocation allocation;
+  vk::ImageView cubeView;
+  std::array<vk::ImageView, 6> faceViews;
+  vk::Sampler sampler;
+
+  vk::PipelineLayout pipelineLayout;
+  vk::Pipeline pipeline;
+
+  uint32_t resolution = 1024;
+  float near = 0.1f;
+  float far = 50.0f;
+
+  ResourceState state;
+  ShadowStats stats;
+  bool dirty = true;
+
+  ShadowMap();
+  ShadowMap(const VmaAllocator& allocator, const vk::Device& device, const uint32_t resolution, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts);
+
+  void writeDescriptor(const vk::Device& device, const vk::DescriptorSet& descriptorSet, const uint32_t binding);
+  void record(vk::CommandBuffer& commandBuffer, const vk::DescriptorSet& projectionSet, const vk::DescriptorSet& objectSet, const glm::vec3& lightPos, const std::vector<Object>& objects, const std::vector<Mesh>& meshes);
+  void reloadPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts, DeletionQueue& deletionQueue, const uint64_t serial);
+
+  void destroy(const VmaAllocator& allocator, const vk::Device& device);
+private:
+  void createImage(const VmaAllocator& allocator, const vk::Device& device);
+  void createSampler(const vk::Device& device);
+  void createPipeline(const vk::Device& device, const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts);
+};
@@ -0,0 +1,249 @@
+#include "simulation.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <glm/gtc/quaternion.hpp>
+#include "trace.hpp"
+
+static const uint32_t MAX_CATCH_UP_TICKS = 5;
+
+static void orient(Camera& camera) {
+  glm::vec3 front{0.0f};
+
+  front.x = glm::cos(glm::radians(camera.yaw)) * glm::cos(glm::radians(camera.pitch));
+  front.y = glm::sin(glm::radians(camera.pitch));
+  front.z = glm::sin(glm::radians(camera.yaw)) * glm::cos(glm::radians(camera.pitch));
+
+  camera.front = glm::normalize(front);
+  camera.right = glm::normalize(glm::cross(camera.front, camera.up));
+}
+
+Camera blendCamera(const Camera& previous, const Camera& current, const float t) {
+  Camera camera = current;
+  camera.pos = glm::mix(previous.pos, current.pos, t);
+
+  // Yaw accumulates without wrapping, so a plain lerp follows the turn the mouse actually made
+  if (previous.yaw != current.yaw || previous.pitch != current.pitch) {
+    camera.yaw = glm::mix(previous.yaw, current.yaw, t);
+    camera.pitch = glm::mix(previous.pitch, current.pitch, t);
+    orient(camera);
+  }
+
+  return camera;
+}
+
+Simulation::Simulation() {
+}
+
+void Simulation::start(const Camera& c, const double rate) {
+  if (rate <= 0.0) {
+    throw std::runtime_error{"Simulation rate must be positive"};
+  }
+
+  step = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>{1.0 / rate});
+  stepSeconds = static_cast<float>(1.0 / rate);
+  camera = c;
+  moving = camera.mode == CameraMode::Move;
+
+  // The renderer may read before the first tick lands
+  publish(camera);
+  snapshots.update();
+
+  running = true;
+  worker = std::thread{&Simulation::run, this};
+}
+
+void Simulation::stop() {
+  running = false;
+
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void Simulation::setKeys(const uint32_t k) {
+  keys.store(k, std::memory_order_relaxed);
+}
+
+void Simulation::addMouseMotion(const int32_t x, const int32_t y) {
+  mouseX.fetch_add(x, std::memory_order_relaxed);
+  mouseY.fetch_add(y, std::memory_order_relaxed);
+}
+
+void Simulation::setCameraMode(const CameraMode mode) {
+  moving.store(mode == CameraMode::Move, std::memory_order_relaxed);
+}
+
+void Simulation::setTransform(const ObjectHandle handle, const Transform& transform) {
+  std::lock_guard<std::mutex> lock{commandMutex};
+  commands.push_back(Command{CommandType::SetTransform, handle, transform, glm::vec3{0.0f}, glm::vec3{0.0f}});
+}
+
+void Simulation::setMotion(const ObjectHandle handle, const Transform& transform, const glm::vec3& velocity, const glm::vec3& angularVelocity) {
+  std::lock_guard<std::mutex> lock{commandMutex};
+  commands.push_back(Command{CommandType::SetMotion, handle, transform, velocity, angularVelocity});
+}
+
+void Simulation::remove(const ObjectHandle handle) {
+  std::lock_guard<std::mutex> lock{commandMutex};
+  commands.push_back(Command{CommandType::Remove, handle, Transform{}, glm::vec3{0.0f}, glm::vec3{0.0f}});
+}
+
+const SimulationSnapshot& Simulation::latest() {
+  snapshots.update();
+  return snapshots.front();
+}
+
+// How far the renderer is between the previous tick and the snapshot's tick
+float Simulation::blend(const SimulationSnapshot& snapshot) const {
+  std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - snapshot.time;
+  return std::clamp(elapsed.count() / stepSeconds, 0.0f, 1.0f);
+}
+
+void Simulation::run() {
+  trace::setThreadName("simulation");
+
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+
+  while (running) {
+    next += step;
+
+    {
+      TRACE_ZONE("simulation tick");
+
+      Camera previousCamera = camera;
+
+      applyCommands();
+      update();
+      publish(previousCamera);
+    }
+
+    // After a long stall drop the missed ticks instead of replaying them all back to back
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (now - next > step * MAX_CATCH_UP_TICKS) {
+      next = now;
+    }
+
+    std::this_thread::sleep_until(next);
+  }
+}
+
+SimulatedBody* Simulation::find(const ObjectHandle handle) {
+  auto it = std::find_if(bodies.begin(), bodies.end(), [&](const SimulatedBody& b) {
+    return b.handle.index == handle.index && b.handle.generation == handle.generation;
+  });
+
+  return it == bodies.end() ? nullptr : &*it;
+}
+
+void Simulation::applyCommands() {
+  std::vector<Command> pending;
+
+  {
+    std::lock_guard<std::mutex> lock{commandMutex};
+    pending.swap(commands);
+  }
+
+  for (const Command& command : pending) {
+    SimulatedBody* b = command.type == CommandType::Remove ? nullptr : find(command.handle);
+
+    // The renderer already applied the transform itself, only moving objects need a body
+    if (!b && command.type == CommandType::SetTransform) {
+      continue;
+    }
+
+    // The command's transform seeds bodies the simulation has not seen yet
+    if (!b && command.type == CommandType::SetMotion) {
+      b = &bodies.emplace_back();
+      b->handle = command.handle;
+      b->transform = command.transform;
+      b->revision = tick + 1;
+    }
+
+    switch (command.type) {
+      case CommandType::SetTransform:
+        b->transform = command.transform;
+        b->revision = tick + 1;
+        break;
+      case CommandType::SetMotion:
+        b->velocity = command.velocity;
+        b->angularVelocity = command.angularVelocity;
+        break;
+      case CommandType::Remove:
+        bodies.erase(std::remove_if(bodies.begin(), bodies.end(), [&](const SimulatedBody& other) {
+          return other.handle.index == command.handle.index && other.handle.generation == command.handle.generation;
+        }), bodies.end());
+        break;
+    }
+  }
+}
+
+void Simulation::update() {
+  tick++;
+
+  // Held keys move the camera at a fixed rate no matter how fast the OS repeats them
+  if (moving.load(std::memory_order_relaxed)) {
+    uint32_t held = keys.load(std::memory_order_relaxed);
+    glm::vec3 direction{0.0f};
+
+    if (held & SIMULATION_KEY_FORWARD) {
+      direction += camera.front;
+    }
+
+    if (held & SIMULATION_KEY_BACK) {
+      direction -= camera.front;
+    }
+
+    if (held & SIMULATION_KEY_LEFT) {
+      direction -= camera.right;
+    }
+
+    if (held & SIMULATION_KEY_RIGHT) {
+      direction += camera.right;
+    }
+
+    camera.pos += direction * camera.velocity * stepSeconds;
+  }
+
+  int32_t x = mouseX.exchange(0, std::memory_order_relaxed);
+  int32_t y = mouseY.exchange(0, std::memory_order_relaxed);
+
+  if (x != 0 || y != 0) {
+    camera.yaw += x * camera.sensitivity;
+    camera.pitch += -y * camera.sensitivity;
+
+    camera.pitch = std::clamp(camera.pitch, -90.0f, 90.0f);
+
+    orient(camera);
+  }
+
+  for (SimulatedBody& b : bodies) {
+    if (b.velocity == glm::vec3{0.0f} && b.angularVelocity == glm::vec3{0.0f}) {
+      continue;
+    }
+
+    b.transform.position += b.velocity * stepSeconds;
+
+    float angle = glm::length(b.angularVelocity) * stepSeconds;
+
+    if (angle > 0.0f) {
+      b.transform.rotation = glm::normalize(glm::angleAxis(angle, glm::normalize(b.angularVelocity)) * b.transform.rotation);
+    }
+
+    b.revision = tick;
+  }
+}
+
+void Simulation::publish(const Camera& previousCamera) {
+  SimulationSnapshot& snapshot = snapshots.back();
+
+  snapshot.tick = tick;
+  snapshot.time = std::chrono::steady_clock::now();
+  snapshot.previousCamera = previousCamera;
+  snapshot.camera = camera;
+  snapshot.bodies.assign(bodies.begin(), bodies.end());
+
+  snapshots.publish();
+}
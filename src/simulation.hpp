@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "object-storage.hpp"
+#include "scene.hpp"
+#include "transform.hpp"
+#include "triple-buffer.hpp"
+
+const uint32_t SIMULATION_KEY_FORWARD = 1 << 0;
+const uint32_t SIMULATION_KEY_BACK = 1 << 1;
+const uint32_t SIMULATION_KEY_LEFT = 1 << 2;
+const uint32_t SIMULATION_KEY_RIGHT = 1 << 3;
+
+struct SimulatedBody {
+  ObjectHandle handle;
+  Transform transform;
+  glm::vec3 velocity = glm::vec3{0.0f};
+  glm::vec3 angularVelocity = glm::vec3{0.0f};
+  uint64_t revision = 0;
+};
+
+struct SimulationSnapshot {
+  uint64_t tick = 0;
+  std::chrono::steady_clock::time_point time;
+  Camera previousCamera;
+  Camera camera;
+  std::vector<SimulatedBody> bodies;
+};
+
+Camera blendCamera(const Camera& previous, const Camera& current, const float t);
+
+class Simulation {
+public:
+  Simulation();
+
+  void start(const Camera& camera, const double rate);
+  void stop();
+
+  void setKeys(const uint32_t keys);
+  void addMouseMotion(const int32_t x, const int32_t y);
+  void setCameraMode(const CameraMode mode);
+
+  void setTransform(const ObjectHandle handle, const Transform& transform);
+  void setMotion(const ObjectHandle handle, const Transform& transform, const glm::vec3& velocity, const glm::vec3& angularVelocity);
+  void remove(const ObjectHandle handle);
+
+  const SimulationSnapshot& latest();
+  float blend(const SimulationSnapshot& snapshot) const;
+private:
+  enum class CommandType {
+    SetTransform,
+    SetMotion,
+    Remove
+  };
+
+  struct Command {
+    CommandType type;
+    ObjectHandle handle;
+    Transform transform;
+    glm::vec3 velocity;
+    glm::vec3 angularVelocity;
+  };
+
+  std::chrono::steady_clock::duration step{};
+  float stepSeconds = 0.0f;
+
+  std::thread worker;
+  std::atomic<bool> running{false};
+
+  std::atomic<uint32_t> keys{0};
+  std::atomic<int32_t> mouseX{0};
+  std::atomic<int32_t> mouseY{0};
+  std::atomic<bool> moving{false};
+
+  std::mutex commandMutex;
+  std::vector<Command> commands;
+
+  uint64_t tick = 0;
+  Camera camera;
+  std::vector<SimulatedBody> bodies;
+
+  TripleBuffer<SimulationSnapshot> snapshots;
+
+  void run();
+  void applyCommands();
+  void update();
+  void publish(const Camera& previousCamera);
+  SimulatedBody* find(const ObjectHandle handle);
+};
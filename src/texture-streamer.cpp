@@ -0,0 +1,599 @@
+#include "texture-streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "fs.hpp"
+#include "image.hpp"
+#include "stb_image.h"
+#include "transform-kernels.hpp"
+
+static const uint32_t TAIL_SIZE = 64;
+static const uint64_t MAX_UPLOAD_BYTES = 32ull * 1024 * 1024;
+static const double HEAP_BUDGET_FRACTION = 0.75;
+static const vk::Format TEXTURE_FORMAT = vk::Format::eR8G8B8A8Srgb;
+
+static std::vector<unsigned char> downsample(const std::vector<unsigned char>& src, const vk::Extent3D& srcExtent, const vk::Extent3D& dstExtent) {
+  std::vector<unsigned char> dst(dstExtent.width * dstExtent.height * 4);
+
+  for (uint32_t y = 0; y < dstExtent.height; y++) {
+    uint32_t y0 = std::min(y * 2, srcExtent.height - 1);
+    uint32_t y1 = std::min(y * 2 + 1, srcExtent.height - 1);
+
+    for (uint32_t x = 0; x < dstExtent.width; x++) {
+      uint32_t x0 = std::min(x * 2, srcExtent.width - 1);
+      uint32_t x1 = std::min(x * 2 + 1, srcExtent.width - 1);
+
+      for (uint32_t c = 0; c < 4; c++) {
+        uint32_t sum =
+          src[(y0 * srcExtent.width + x0) * 4 + c] +
+          src[(y0 * srcExtent.width + x1) * 4 + c] +
+          src[(y1 * srcExtent.width + x0) * 4 + c] +
+          src[(y1 * srcExtent.width + x1) * 4 + c];
+
+        dst[(y * dstExtent.width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+      }
+    }
+  }
+
+  return dst;
+}
+
+static uint64_t levelBytes(const vk::Extent3D& extent) {
+  return static_cast<uint64_t>(extent.width) * extent.height * 4;
+}
+
+static std::vector<unsigned char> decodeImage(const char* bytes, const size_t size, const std::string_view name, vk::Extent3D& extent) {
+  int width, height;
+
+  unsigned char* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(bytes), size, &width, &height, nullptr, STBI_rgb_alpha);
+
+  if (!data) {
+    throw std::runtime_error{std::string{"Failed to load texture: "} + std::string{name}};
+  }
+
+  extent = vk::Extent3D{static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+  std::vector<unsigned char> pixels(data, data + width * height * 4);
+
+  stbi_image_free(data);
+
+  return pixels;
+}
+
+// Walks the mip chain down from the full image, keeping levels first to last - 1
+static std::vector<std::vector<unsigned char>> buildLevels(std::vector<unsigned char>&& pixels, const std::vector<vk::Extent3D>& extents, const uint32_t first, const uint32_t last) {
+  std::vector<std::vector<unsigned char>> levels;
+
+  for (uint32_t i = 0; i < last; i++) {
+    if (i > 0) {
+      pixels = downsample(pixels, extents[i - 1], extents[i]);
+    }
+
+    if (i >= first) {
+      levels.push_back(pixels);
+    }
+  }
+
+  return levels;
+}
+
+// Touches no streamer state, so levels can be decoded on any thread
+static std::vector<std::vector<unsigned char>> decodeLevels(const StreamedTexture& entry, const uint32_t first, const uint32_t last) {
+  vk::Extent3D extent;
+  std::vector<unsigned char> pixels;
+
+  if (entry.source.empty()) {
+    fs::MappedFile file{entry.path};
+    pixels = decodeImage(file.data(), file.size(), entry.path, extent);
+  } else {
+    pixels = decodeImage(entry.source.data(), entry.source.size(), entry.path, extent);
+  }
+
+  if (extent != entry.extents[0]) {
+    throw std::runtime_error{std::string{"Failed to stream texture, its size changed: "} + entry.path};
+  }
+
+  return buildLevels(std::move(pixels), entry.extents, first, last);
+}
+
+static StreamedTexture decodeTail(const char* bytes, const size_t size, const std::string_view name) {
+  StreamedTexture entry{};
+  entry.path = std::string{name};
+
+  vk::Extent3D extent;
+  std::vector<unsigned char> pixels = decodeImage(bytes, size, name, extent);
+
+  entry.extents.push_back(extent);
+
+  while (entry.extents.back().width > 1 || entry.extents.back().height > 1) {
+    const vk::Extent3D& previous = entry.extents.back();
+    entry.extents.push_back(vk::Extent3D{std::max(previous.width / 2, 1u), std::max(previous.height / 2, 1u), 1});
+  }
+
+  while (entry.tailMip + 1 < entry.extents.size() && std::max(entry.extents[entry.tailMip].width, entry.extents[entry.tailMip].height) > TAIL_SIZE) {
+    entry.tailMip++;
+  }
+
+  entry.desiredMip = entry.tailMip;
+  entry.tail = buildLevels(std::move(pixels), entry.extents, entry.tailMip, entry.extents.size());
+
+  return entry;
+}
+
+TextureStreamer::TextureStreamer() {
+}
+
+TextureStreamer::TextureStreamer(const uint64_t b): budgetLimit{b} {
+}
+
+Texture TextureStreamer::load(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, const std::string_view path) {
+  return add(allocator, device, bindlessTextures, sampler, textureIdx, decode(path));
+}
+
+Texture TextureStreamer::load(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, const char* bytes, const size_t size, const std::string_view name) {
+  return add(allocator, device, bindlessTextures, sampler, textureIdx, decode(bytes, size, name));
+}
+
+StreamedTexture TextureStreamer::decode(const std::string_view path) {
+  fs::MappedFile file{path};
+  return decodeTail(file.data(), file.size(), path);
+}
+
+// Keeps the encoded bytes, finer levels are decoded from them once they are needed
+StreamedTexture TextureStreamer::decode(const char* bytes, const size_t size, const std::string_view name) {
+  StreamedTexture entry = decodeTail(bytes, size, name);
+  entry.source.assign(bytes, bytes + size);
+  return entry;
+}
+
+Texture TextureStreamer::add(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, StreamedTexture&& entry) {
+  if (textureIdx >= entries.size()) {
+    entries.resize(textureIdx + 1);
+  }
+
+  entries[textureIdx] = std::move(entry);
+
+  std::vector<std::vector<unsigned char>> tail = std::move(entries[textureIdx].tail);
+  entries[textureIdx].tail.clear();
+
+  return createResident(allocator, device, bindlessTextures, sampler, textureIdx, entries[textureIdx].tailMip, tail, vk::Image{});
+}
+
+void TextureStreamer::unload(const VmaAllocator& allocator, const uint32_t textureIdx) {
+  for (size_t i = 0; i < uploads.size();) {
+    if (uploads[i].textureIdx == textureIdx) {
+      if (uploads[i].staging.buffer) {
+        uploads[i].staging.destroy(allocator);
+      }
+
+      uploads.erase(uploads.begin() + i);
+    } else {
+      i++;
+    }
+  }
+
+  if (textureIdx < entries.size()) {
+    entries[textureIdx] = StreamedTexture{};
+  }
+}
+
+uint64_t TextureStreamer::residentBytes(const StreamedTexture& entry, const uint32_t mip) const {
+  uint64_t bytes = 0;
+
+  for (size_t i = mip; i < entry.extents.size(); i++) {
+    bytes += levelBytes(entry.extents[i]);
+  }
+
+  return bytes;
+}
+
+uint64_t TextureStreamer::computeBudget(const VmaAllocator& allocator, const uint64_t streamedBytes) const {
+  const VkPhysicalDeviceMemoryProperties* memoryProperties;
+  vmaGetMemoryProperties(allocator, &memoryProperties);
+
+  std::vector<VmaBudget> budgets(memoryProperties->memoryHeapCount);
+  vmaGetHeapBudgets(allocator, budgets.data());
+
+  uint64_t heapBudget = 0;
+  uint64_t heapUsage = 0;
+
+  for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+    if (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+      heapBudget += budgets[i].budget;
+      heapUsage += budgets[i].usage;
+    }
+  }
+
+  // Everything in the heap that is not a streamed texture is off limits
+  uint64_t otherUsage = heapUsage > streamedBytes ? heapUsage - streamedBytes : 0;
+  uint64_t budget = heapBudget > otherUsage ? static_cast<uint64_t>((heapBudget - otherUsage) * HEAP_BUDGET_FRACTION) : 0;
+
+  if (budgetLimit > 0) {
+    budget = std::min(budget, budgetLimit);
+  }
+
+  return budget;
+}
+
+void TextureStreamer::computeDesiredMips(const std::vector<Object>& objects, const TransformStorage& transforms, const std::vector<Mesh>& meshes, const Projection& projection, const vk::Extent2D& extent, JobSystem& jobs) {
+  for (StreamedTexture& entry : entries) {
+    entry.desiredMip = entry.tailMip;
+  }
+
+  // The projection may have Y flipped for Vulkan's clip space, only the magnitude is the focal length
+  float focal = std::abs(projection.perspective[1][1]) * extent.height * 0.5f;
+
+  objectMips.assign(objects.size(), UINT32_MAX);
+  viewModels.resize(objects.size());
+
+  // Objects are tested in parallel, several objects share a texture so the minimum is folded in afterwards
+  jobs.parallelFor(objects.size(), 512, [&](const uint32_t begin, const uint32_t end) {
+    const float* view = reinterpret_cast<const float*>(&projection.view);
+    const float* models = reinterpret_cast<const float*>(transforms.models.data() + begin);
+    kernels::multiplyMatrices(end - begin, view, models, reinterpret_cast<float*>(viewModels.data() + begin));
+
+    for (uint32_t i = begin; i < end; i++) {
+      objectMips[i] = objectMip(objects[i], viewModels[i], meshes, focal);
+    }
+  });
+
+  for (size_t i = 0; i < objects.size(); i++) {
+    if (objectMips[i] != UINT32_MAX) {
+      StreamedTexture& entry = entries[objects[i].textureIdx];
+      entry.desiredMip = std::min(entry.desiredMip, objectMips[i]);
+    }
+  }
+}
+
+uint32_t TextureStreamer::objectMip(const Object& object, const glm::mat4& viewModel, const std::vector<Mesh>& meshes, const float focal) const {
+  if (object.textureIdx >= entries.size() || entries[object.textureIdx].extents.empty()) {
+    return UINT32_MAX;
+  }
+
+  const StreamedTexture& entry = entries[object.textureIdx];
+  const glm::vec4& bounds = meshes[object.meshIdx].bounds;
+
+  glm::vec3 viewCenter = glm::vec3{viewModel * glm::vec4{glm::vec3{bounds}, 1.0f}};
+
+  // The view matrix is rigid, so the combined matrix keeps the model's scale
+  float scale = std::max(glm::length(glm::vec3{viewModel[0]}), std::max(glm::length(glm::vec3{viewModel[1]}), glm::length(glm::vec3{viewModel[2]})));
+  float radius = bounds.w * scale;
+
+  if (viewCenter.z - radius > 0.0f) {
+    return UINT32_MAX;
+  }
+
+  float distance = glm::length(viewCenter);
+  uint32_t mip = 0;
+
+  if (distance > radius) {
+    // Assume the texture spans the object once, so its footprint is the projected sphere
+    float diameter = std::max(2.0f * radius / distance * focal, 1.0f);
+    float texels = std::max(entry.extents[0].width, entry.extents[0].height);
+
+    mip = static_cast<uint32_t>(std::max(0.0f, std::floor(std::log2(texels / diameter))));
+  }
+
+  return std::min(mip, entry.tailMip);
+}
+
+void TextureStreamer::update(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, std::vector<Texture>& textures, const std::vector<Object>& objects, const TransformStorage& transforms, const std::vector<Mesh>& meshes, const Projection& projection, const vk::Extent2D& extent, DeletionQueue& deletionQueue, const uint64_t serial, JobSystem& jobs) {
+  computeDesiredMips(objects, transforms, meshes, projection, extent, jobs);
+
+  uint64_t total = 0;
+
+  for (const StreamedTexture& entry : entries) {
+    if (!entry.extents.empty()) {
+      total += residentBytes(entry, entry.residentMip);
+    }
+  }
+
+  // A texture whose image is not uploaded yet cannot be copied from, so it waits a frame
+  std::vector<bool> pending(entries.size(), false);
+
+  for (const Upload& upload : uploads) {
+    pending[upload.textureIdx] = true;
+  }
+
+  stats.budgetBytes = computeBudget(allocator, total);
+
+  std::vector<uint32_t> targets(entries.size());
+  std::vector<uint32_t> upgrades;
+
+  for (uint32_t i = 0; i < entries.size(); i++) {
+    const StreamedTexture& entry = entries[i];
+    targets[i] = entry.residentMip;
+
+    if (entry.extents.empty() || pending[i]) {
+      continue;
+    }
+
+    // Keep one spare level of detail so textures near a mip boundary do not thrash
+    if (entry.desiredMip > entry.residentMip + 1) {
+      targets[i] = entry.desiredMip;
+      total -= residentBytes(entry, entry.residentMip) - residentBytes(entry, entry.desiredMip);
+    } else if (entry.desiredMip < entry.residentMip) {
+      upgrades.push_back(i);
+    }
+  }
+
+  std::sort(upgrades.begin(), upgrades.end(), [&](const uint32_t a, const uint32_t b) {
+    return entries[a].desiredMip < entries[b].desiredMip;
+  });
+
+  uint64_t uploaded = 0;
+
+  for (uint32_t i : upgrades) {
+    const StreamedTexture& entry = entries[i];
+    uint64_t current = residentBytes(entry, entry.residentMip);
+    uint32_t target = entry.desiredMip;
+
+    while (target < entry.residentMip && total - current + residentBytes(entry, target) > stats.budgetBytes) {
+      target++;
+    }
+
+    if (target == entry.residentMip || uploaded + residentBytes(entry, target) > MAX_UPLOAD_BYTES) {
+      continue;
+    }
+
+    targets[i] = target;
+    total += residentBytes(entry, target) - current;
+    uploaded += residentBytes(entry, target);
+  }
+
+  // The budget can shrink under us, so drop detail from the least needed textures until it fits
+  while (total > stats.budgetBytes) {
+    uint32_t victim = UINT32_MAX;
+
+    for (uint32_t i = 0; i < entries.size(); i++) {
+      const StreamedTexture& entry = entries[i];
+
+      if (entry.extents.empty() || pending[i] || targets[i] >= entry.tailMip) {
+        continue;
+      }
+
+      if (victim == UINT32_MAX || entry.desiredMip > entries[victim].desiredMip) {
+        victim = i;
+      }
+    }
+
+    if (victim == UINT32_MAX) {
+      break;
+    }
+
+    const StreamedTexture& entry = entries[victim];
+    total -= residentBytes(entry, targets[victim]) - residentBytes(entry, targets[victim] + 1);
+    targets[victim]++;
+  }
+
+  std::vector<uint32_t> changes;
+
+  for (uint32_t i = 0; i < entries.size(); i++) {
+    if (!entries[i].extents.empty() && targets[i] != entries[i].residentMip) {
+      changes.push_back(i);
+    }
+  }
+
+  // Only the levels finer than what is resident are decoded, coarser ones are copied from the current image
+  std::vector<std::vector<std::vector<unsigned char>>> decoded(changes.size());
+
+  jobs.parallelFor(changes.size(), 1, [&](const uint32_t begin, const uint32_t end) {
+    for (uint32_t c = begin; c < end; c++) {
+      const StreamedTexture& entry = entries[changes[c]];
+
+      if (targets[changes[c]] < entry.residentMip) {
+        try {
+          decoded[c] = decodeLevels(entry, targets[changes[c]], entry.residentMip);
+        } catch (const std::exception&) {
+          // The source went away or changed, the texture stays at its current detail
+        }
+      }
+    }
+  });
+
+  for (uint32_t c = 0; c < changes.size(); c++) {
+    uint32_t i = changes[c];
+    StreamedTexture& entry = entries[i];
+
+    if (targets[i] < entry.residentMip && decoded[c].empty()) {
+      total -= residentBytes(entry, targets[i]) - residentBytes(entry, entry.residentMip);
+      continue;
+    }
+
+    if (targets[i] > entry.residentMip) {
+      stats.evictions++;
+    }
+
+    Texture previous = textures[i];
+    textures[i] = createResident(allocator, device, bindlessTextures, sampler, i, targets[i], decoded[c], previous.image.image);
+    decoded[c].clear();
+
+    // Frames in flight still sample the old image through its own bindless slot
+    BindlessTextures* table = &bindlessTextures;
+    VmaAllocator vma = allocator;
+    vk::Device d = device;
+
+    deletionQueue.push(serial, [table, vma, d, previous]() mutable {
+      previous.destroy(vma, d);
+      table->release(previous.index);
+    });
+  }
+
+  stats.residentBytes = total;
+}
+
+// Levels from mip on are staged from the given pixels, the rest are copied from the previous image of the texture
+Texture TextureStreamer::createResident(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, const uint32_t mip, const std::vector<std::vector<unsigned char>>& levels, const vk::Image& previous) {
+  StreamedTexture& entry = entries[textureIdx];
+  uint32_t levelCount = entry.extents.size() - mip;
+  uint32_t stagedCount = levels.size();
+
+  Image image{allocator, device, entry.extents[mip], TEXTURE_FORMAT, vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, levelCount};
+
+  Upload upload{};
+  upload.image = image.image;
+  upload.source = previous;
+  upload.textureIdx = textureIdx;
+  upload.levelCount = levelCount;
+
+  if (stagedCount > 0) {
+    upload.staging = Buffer{allocator, static_cast<uint32_t>(residentBytes(entry, mip) - residentBytes(entry, mip + stagedCount)), vk::BufferUsageFlagBits::eTransferSrc};
+  }
+
+  uint64_t offset = 0;
+
+  for (uint32_t i = 0; i < stagedCount; i++) {
+    const std::vector<unsigned char>& level = levels[i];
+
+    vmaCopyMemoryToAllocation(allocator, level.data(), upload.staging.allocation, offset, level.size());
+
+    vk::ImageSubresourceLayers subresource = vk::ImageSubresourceLayers{}
+      .setAspectMask(vk::ImageAspectFlagBits::eColor)
+      .setMipLevel(i)
+      .setBaseArrayLayer(0)
+      .setLayerCount(1);
+
+    upload.regions.push_back(vk::BufferImageCopy2{}
+      .setBufferOffset(offset)
+      .setImageSubresource(subresource)
+      .setImageExtent(entry.extents[mip + i]));
+
+    offset += level.size();
+  }
+
+  for (uint32_t i = stagedCount; i < levelCount; i++) {
+    vk::ImageSubresourceLayers srcSubresource = vk::ImageSubresourceLayers{}
+      .setAspectMask(vk::ImageAspectFlagBits::eColor)
+      .setMipLevel(mip + i - entry.residentMip)
+      .setBaseArrayLayer(0)
+      .setLayerCount(1);
+
+    vk::ImageSubresourceLayers dstSubresource = vk::ImageSubresourceLayers{srcSubresource}
+      .setMipLevel(i);
+
+    upload.copies.push_back(vk::ImageCopy2{}
+      .setSrcSubresource(srcSubresource)
+      .setDstSubresource(dstSubresource)
+      .setExtent(entry.extents[mip + i]));
+  }
+
+  uploads.push_back(upload);
+
+  entry.residentMip = mip;
+  stats.uploads++;
+
+  uint32_t index = bindlessTextures.add(device, sampler, image.view);
+
+  return Texture{image, index};
+}
+
+void TextureStreamer::record(vk::CommandBuffer& commandBuffer, const VmaAllocator& allocator, DeletionQueue& deletionQueue, const uint64_t serial) {
+  if (uploads.empty()) {
+    return;
+  }
+
+  std::vector<vk::ImageMemoryBarrier2> transferBarriers;
+  std::vector<vk::ImageMemoryBarrier2> readBarriers;
+
+  for (const Upload& upload : uploads) {
+    vk::ImageSubresourceRange range = vk::ImageSubresourceRange{}
+      .setAspectMask(vk::ImageAspectFlagBits::eColor)
+      .setBaseMipLevel(0)
+      .setLevelCount(upload.levelCount)
+      .setBaseArrayLayer(0)
+      .setLayerCount(1);
+
+    transferBarriers.push_back(vk::ImageMemoryBarrier2{}
+      .setImage(upload.image)
+      .setOldLayout(vk::ImageLayout::eUndefined)
+      .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setSrcStageMask(vk::PipelineStageFlagBits2::eNone)
+      .setSrcAccessMask(vk::AccessFlagBits2::eNone)
+      .setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+      .setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+      .setSubresourceRange(range));
+
+    readBarriers.push_back(vk::ImageMemoryBarrier2{}
+      .setImage(upload.image)
+      .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+      .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+      .setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+      .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+      .setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+      .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead)
+      .setSubresourceRange(range));
+
+    if (upload.copies.empty()) {
+      continue;
+    }
+
+    // The previous image is retired after this frame, so it is left in the transfer layout
+    vk::ImageSubresourceRange sourceRange = vk::ImageSubresourceRange{range}
+      .setBaseMipLevel(upload.copies.front().srcSubresource.mipLevel)
+      .setLevelCount(upload.copies.size());
+
+    transferBarriers.push_back(vk::ImageMemoryBarrier2{}
+      .setImage(upload.source)
+      .setOldLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+      .setNewLayout(vk::ImageLayout::eTransferSrcOptimal)
+      .setSrcStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+      .setSrcAccessMask(vk::AccessFlagBits2::eShaderSampledRead)
+      .setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+      .setDstAccessMask(vk::AccessFlagBits2::eTransferRead)
+      .setSubresourceRange(sourceRange));
+  }
+
+  commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(transferBarriers));
+
+  for (const Upload& upload : uploads) {
+    if (!upload.regions.empty()) {
+      vk::CopyBufferToImageInfo2 copyInfo = vk::CopyBufferToImageInfo2{}
+        .setSrcBuffer(upload.staging.buffer)
+        .setDstImage(upload.image)
+        .setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setRegions(upload.regions);
+
+      commandBuffer.copyBufferToImage2(copyInfo);
+    }
+
+    if (!upload.copies.empty()) {
+      vk::CopyImageInfo2 copyInfo = vk::CopyImageInfo2{}
+        .setSrcImage(upload.source)
+        .setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal)
+        .setDstImage(upload.image)
+        .setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
+        .setRegions(upload.copies);
+
+      commandBuffer.copyImage2(copyInfo);
+    }
+  }
+
+  commandBuffer.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(readBarriers));
+
+  for (const Upload& upload : uploads) {
+    if (!upload.staging.buffer) {
+      continue;
+    }
+
+    Buffer staging = upload.staging;
+    VmaAllocator vma = allocator;
+
+    deletionQueue.push(serial, [vma, staging]() mutable {
+      staging.destroy(vma);
+    });
+  }
+
+  uploads.clear();
+}
+
+void TextureStreamer::destroy(const VmaAllocator& allocator) {
+  for (Upload& upload : uploads) {
+    if (upload.staging.buffer) {
+      upload.staging.destroy(allocator);
+    }
+  }
+
+  uploads.clear();
+  entries.clear();
+}
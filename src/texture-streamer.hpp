@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "bindless-textures.hpp"
+#include "buffer.hpp"
+#include "deletion-queue.hpp"
+#include "job-system.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include "scene.hpp"
+#include "texture.hpp"
+#include "transform.hpp"
+#include "vk_mem_alloc.h"
+
+struct TextureStreamStats {
+  uint64_t residentBytes = 0;
+  uint64_t budgetBytes = 0;
+  uint32_t uploads = 0;
+  uint32_t evictions = 0;
+};
+
+// Finer levels are decoded again from the encoded image when they are needed, the host never keeps uploaded levels
+struct StreamedTexture {
+  std::string path;
+  std::vector<char> source;
+  std::vector<std::vector<unsigned char>> tail;
+  std::vector<vk::Extent3D> extents;
+  uint32_t tailMip = 0;
+  uint32_t residentMip = 0;
+  uint32_t desiredMip = 0;
+};
+
+class TextureStreamer {
+public:
+  std::vector<StreamedTexture> entries;
+  TextureStreamStats stats;
+
+  TextureStreamer();
+  TextureStreamer(const uint64_t budgetLimit);
+
+  Texture load(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, const std::string_view path);
+  Texture load(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, const char* bytes, const size_t size, const std::string_view name);
+  Texture add(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, StreamedTexture&& entry);
+  void unload(const VmaAllocator& allocator, const uint32_t textureIdx);
+  void update(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, std::vector<Texture>& textures, const std::vector<Object>& objects, const TransformStorage& transforms, const std::vector<Mesh>& meshes, const Projection& projection, const vk::Extent2D& extent, DeletionQueue& deletionQueue, const uint64_t serial, JobSystem& jobs);
+  void record(vk::CommandBuffer& commandBuffer, const VmaAllocator& allocator, DeletionQueue& deletionQueue, const uint64_t serial);
+
+  void destroy(const VmaAllocator& allocator);
+
+  static StreamedTexture decode(const std::string_view path);
+  static StreamedTexture decode(const char* bytes, const size_t size, const std::string_view name);
+private:
+  struct Upload {
+    Buffer staging;
+    vk::Image image;
+    vk::Image source;
+    uint32_t textureIdx;
+    uint32_t levelCount;
+    std::vector<vk::BufferImageCopy2> regions;
+    std::vector<vk::ImageCopy2> copies;
+  };
+
+  std::vector<Upload> uploads;
+  uint64_t budgetLimit = 0;
+  std::vector<uint32_t> objectMips;
+  std::vector<glm::mat4> viewModels;
+
+  uint64_t residentBytes(const StreamedTexture& entry, const uint32_t mip) const;
+  uint64_t computeBudget(const VmaAllocator& allocator, const uint64_t streamedBytes) const;
+  void computeDesiredMips(const std::vector<Object>& objects, const TransformStorage& transforms, const std::vector<Mesh>& meshes, const Projection& projection, const vk::Extent2D& extent, JobSystem& jobs);
+  uint32_t objectMip(const Object& object, const glm::mat4& viewModel, const std::vector<Mesh>& meshes, const float focal) const;
+  Texture createResident(const VmaAllocator& allocator, const vk::Device& device, BindlessTextures& bindlessTextures, const vk::Sampler& sampler, const uint32_t textureIdx, const uint32_t mip, const std::vector<std::vector<unsigned char>>& levels, const vk::Image& previous);
+};
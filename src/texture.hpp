@@ -6,12 +6,10 @@
 class Texture {
 public:
   Image image;
-  std::vector<vk::DescriptorSet> descriptorSets;
-  uint32_t swapchainImageCount;
+  uint32_t index = 0;
 
-  Texture(const vk::Sampler& sampler, const vk::Device& device, const vk::DescriptorPool& descriptorPool, const Image& image, const uint32_t swapchainImageCount, const vk::DescriptorSetLayout& textureDescriptorSetLayout);
+  Texture();
+  Texture(const Image& image, const uint32_t index);
   
   void destroy(const VmaAllocator& allocator, const vk::Device& device);
-private:
-  void createSampler();
 };
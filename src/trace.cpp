@@ -0,0 +1,163 @@
+#include "trace.hpp"
+
+#ifdef VKR_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const uint64_t RING_SIZE = 1 << 16;
+
+// Relaxed atomics compile to plain stores, they only keep the exporter's concurrent reads well defined
+struct TraceEvent {
+  std::atomic<const char*> name{nullptr};
+  std::atomic<uint64_t> begin{0};
+  std::atomic<uint64_t> end{0};
+};
+
+struct ThreadRing {
+  uint32_t tid = 0;
+  std::string name;
+  std::atomic<uint64_t> head{0};
+  std::vector<TraceEvent> events = std::vector<TraceEvent>(RING_SIZE);
+};
+
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+// Rings are never freed so events from threads that already exited can still be exported
+static std::mutex ringsMutex;
+static std::deque<ThreadRing> rings;
+
+static thread_local ThreadRing* localRing = nullptr;
+
+static ThreadRing& threadRing() {
+  if (!localRing) {
+    std::lock_guard<std::mutex> lock{ringsMutex};
+    ThreadRing& ring = rings.emplace_back();
+    ring.tid = rings.size();
+    localRing = &ring;
+  }
+
+  return *localRing;
+}
+
+static std::string escape(const std::string_view text) {
+  std::string escaped;
+
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+
+    escaped += c;
+  }
+
+  return escaped;
+}
+
+namespace trace {
+  uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+  }
+
+  // Only the owning thread writes its ring, so publishing an event is a single release store
+  void record(const char* name, const uint64_t begin, const uint64_t end) {
+    ThreadRing& ring = threadRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    TraceEvent& event = ring.events[head & (RING_SIZE - 1)];
+
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+
+    ring.head.store(head + 1, std::memory_order_release);
+  }
+
+  Zone::Zone(const char* n): name{n}, begin{now()} {
+  }
+
+  Zone::~Zone() {
+    end();
+  }
+
+  void Zone::end() {
+    if (name) {
+      record(name, begin, now());
+      name = nullptr;
+    }
+  }
+
+  void setThreadName(const std::string_view name) {
+    ThreadRing& ring = threadRing();
+    std::lock_guard<std::mutex> lock{ringsMutex};
+    ring.name = name;
+  }
+
+  void writeChromeTrace(const std::string_view path) {
+    std::ofstream file{path.data(), std::ios::out | std::ios::trunc};
+
+    if (!file.is_open()) {
+      throw std::runtime_error{std::string{"Failed to open file: "} + path.data()};
+    }
+
+    std::lock_guard<std::mutex> lock{ringsMutex};
+    char line[512];
+    bool first = true;
+
+    file << "{\"traceEvents\": [\n";
+
+    for (ThreadRing& ring : rings) {
+      if (!ring.name.empty()) {
+        std::snprintf(line, sizeof(line), "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+          first ? "" : ",\n",
+          ring.tid,
+          escape(ring.name).c_str());
+        file << line;
+        first = false;
+      }
+
+      uint64_t head = ring.head.load(std::memory_order_acquire);
+      uint64_t start = head > RING_SIZE ? head - RING_SIZE : 0;
+
+      std::vector<std::pair<uint64_t, std::string>> events;
+
+      for (uint64_t i = start; i < head; i++) {
+        const TraceEvent& event = ring.events[i & (RING_SIZE - 1)];
+        uint64_t begin = event.begin.load(std::memory_order_relaxed);
+        uint64_t end = event.end.load(std::memory_order_relaxed);
+
+        std::snprintf(line, sizeof(line), "  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+          escape(event.name.load(std::memory_order_relaxed)).c_str(),
+          ring.tid,
+          begin / 1000.0,
+          (end - begin) / 1000.0);
+        events.emplace_back(i, line);
+      }
+
+      // The owning thread keeps recording while this runs, drop anything it lapped in the meantime
+      uint64_t lapped = ring.head.load(std::memory_order_acquire);
+      uint64_t oldest = lapped >= RING_SIZE ? lapped - RING_SIZE + 1 : 0;
+
+      for (const auto& [index, event] : events) {
+        if (index >= oldest) {
+          file << (first ? "" : ",\n") << event;
+          first = false;
+        }
+      }
+    }
+
+    file << "\n]}\n";
+
+    if (!file) {
+      throw std::runtime_error{std::string{"Failed to write trace: "} + path.data()};
+    }
+  }
+}
+
+#endif
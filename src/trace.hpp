@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef VKR_TRACE
+
+// Zone names are stored by pointer, so they must be string literals or otherwise outlive the trace
+#define TRACE_ZONE(name) trace::Zone TRACE_CONCAT(traceZone, __LINE__){name}
+#define TRACE_FUNCTION() TRACE_ZONE(__func__)
+#define TRACE_BEGIN(zone, name) trace::Zone zone{name}
+#define TRACE_END(zone) zone.end()
+
+namespace trace {
+  const bool enabled = true;
+
+  uint64_t now();
+  void record(const char* name, const uint64_t begin, const uint64_t end);
+
+  class Zone {
+  public:
+    Zone(const char* name);
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+    ~Zone();
+
+    void end();
+  private:
+    const char* name;
+    uint64_t begin;
+  };
+
+  void setThreadName(const std::string_view name);
+  void writeChromeTrace(const std::string_view path);
+}
+
+#else
+
+#define TRACE_ZONE(name) static_cast<void>(0)
+#define TRACE_FUNCTION() static_cast<void>(0)
+#define TRACE_BEGIN(zone, name) static_cast<void>(0)
+#define TRACE_END(zone) static_cast<void>(0)
+
+namespace trace {
+  const bool enabled = false;
+
+  inline void setThreadName(const std::string_view) {}
+  inline void writeChromeTrace(const std::string_view) {}
+}
+
+#endif
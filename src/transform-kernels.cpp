@@ -0,0 +1,505 @@
+#include "transform-kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define VKR_X86_KERNELS
+// GCC 12's AVX-512 intrinsics start from a self initialised _mm512_undefined_ps, which trips
+// -Wuninitialized wherever they are inlined, the diagnostics point into the header so they are silenced there
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+// Scales are clamped away from zero before inverting, a flattened axis then gets a very large
+// but finite normal column instead of infinities, and every variant agrees on the result
+static const float MIN_SCALE = 1e-6f;
+
+struct KernelTable {
+  KernelIsa isa;
+  void (*compose)(const uint32_t count, const uint32_t* indices, const TransformArrays& arrays);
+  void (*multiply)(const uint32_t count, const float* left, const float* rights, float* out);
+};
+
+static void composeScalar(const uint32_t count, const uint32_t* indices, const TransformArrays& arrays) {
+  uint32_t xOffset = arrays.rotationWFirst ? 1 : 0;
+  uint32_t wOffset = arrays.rotationWFirst ? 0 : 3;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t idx = indices[i];
+    const float* position = arrays.positions + idx * 3;
+    const float* rotation = arrays.rotations + idx * 4;
+    const float* scale = arrays.scales + idx * 3;
+
+    float x = rotation[xOffset];
+    float y = rotation[xOffset + 1];
+    float z = rotation[xOffset + 2];
+    float w = rotation[wOffset];
+
+    // Same terms as glm::mat3_cast
+    float r[3][3] = {
+      {1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y)},
+      {2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x)},
+      {2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y)}
+    };
+
+    float* model = arrays.models + idx * 16;
+    float* normal = arrays.normals + idx * 12;
+
+    for (uint32_t c = 0; c < 3; c++) {
+      float inverseScale = std::copysign(1.0f / std::max(std::fabs(scale[c]), MIN_SCALE), scale[c]);
+
+      for (uint32_t k = 0; k < 3; k++) {
+        model[c * 4 + k] = r[c][k] * scale[c];
+        normal[c * 4 + k] = r[c][k] * inverseScale;
+      }
+
+      model[c * 4 + 3] = 0.0f;
+      normal[c * 4 + 3] = 0.0f;
+    }
+
+    model[12] = position[0];
+    model[13] = position[1];
+    model[14] = position[2];
+    model[15] = 1.0f;
+  }
+}
+
+static void multiplyScalar(const uint32_t count, const float* left, const float* rights, float* out) {
+  for (uint32_t i = 0; i < count; i++) {
+    const float* right = rights + i * 16;
+    float result[16];
+
+    for (uint32_t c = 0; c < 4; c++) {
+      for (uint32_t row = 0; row < 4; row++) {
+        result[c * 4 + row] = left[row] * right[c * 4] + left[4 + row] * right[c * 4 + 1] + left[8 + row] * right[c * 4 + 2] + left[12 + row] * right[c * 4 + 3];
+      }
+    }
+
+    std::memcpy(out + i * 16, result, sizeof(result));
+  }
+}
+
+#ifdef VKR_X86_KERNELS
+
+// The SIMD variants work on one object per lane, so the array of structures input is gathered
+// into registers per component and the results are transposed back four floats at a time
+
+__attribute__((target("sse4.1")))
+static inline __m128 gatherSse4(const float* base, const uint32_t* indices, const uint32_t stride) {
+  return _mm_setr_ps(base[indices[0] * stride], base[indices[1] * stride], base[indices[2] * stride], base[indices[3] * stride]);
+}
+
+__attribute__((target("sse4.1")))
+static inline void scatterColumnSse4(__m128 x, __m128 y, __m128 z, __m128 w, float* base, const uint32_t* indices, const uint32_t stride) {
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  _mm_storeu_ps(base + indices[0] * stride, x);
+  _mm_storeu_ps(base + indices[1] * stride, y);
+  _mm_storeu_ps(base + indices[2] * stride, z);
+  _mm_storeu_ps(base + indices[3] * stride, w);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 inverseScaleSse4(__m128 scale) {
+  __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 magnitude = _mm_max_ps(_mm_andnot_ps(sign, scale), _mm_set1_ps(MIN_SCALE));
+  return _mm_or_ps(_mm_div_ps(_mm_set1_ps(1.0f), magnitude), _mm_and_ps(sign, scale));
+}
+
+__attribute__((target("sse4.1")))
+static void composeSse4(const uint32_t count, const uint32_t* indices, const TransformArrays& arrays) {
+  const float* rotations = arrays.rotations + (arrays.rotationWFirst ? 1 : 0);
+  const float* rotationsW = arrays.rotations + (arrays.rotationWFirst ? 0 : 3);
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  uint32_t i = 0;
+
+  for (; i + 4 <= count; i += 4) {
+    const uint32_t* idx = indices + i;
+
+    __m128 px = gatherSse4(arrays.positions, idx, 3);
+    __m128 py = gatherSse4(arrays.positions + 1, idx, 3);
+    __m128 pz = gatherSse4(arrays.positions + 2, idx, 3);
+    __m128 sx = gatherSse4(arrays.scales, idx, 3);
+    __m128 sy = gatherSse4(arrays.scales + 1, idx, 3);
+    __m128 sz = gatherSse4(arrays.scales + 2, idx, 3);
+    __m128 qx = gatherSse4(rotations, idx, 4);
+    __m128 qy = gatherSse4(rotations + 1, idx, 4);
+    __m128 qz = gatherSse4(rotations + 2, idx, 4);
+    __m128 qw = gatherSse4(rotationsW, idx, 4);
+
+    __m128 x2 = _mm_add_ps(qx, qx);
+    __m128 y2 = _mm_add_ps(qy, qy);
+    __m128 z2 = _mm_add_ps(qz, qz);
+    __m128 xx = _mm_mul_ps(qx, x2);
+    __m128 yy = _mm_mul_ps(qy, y2);
+    __m128 zz = _mm_mul_ps(qz, z2);
+    __m128 xy = _mm_mul_ps(qx, y2);
+    __m128 xz = _mm_mul_ps(qx, z2);
+    __m128 yz = _mm_mul_ps(qy, z2);
+    __m128 wx = _mm_mul_ps(qw, x2);
+    __m128 wy = _mm_mul_ps(qw, y2);
+    __m128 wz = _mm_mul_ps(qw, z2);
+
+    __m128 r00 = _mm_sub_ps(one, _mm_add_ps(yy, zz));
+    __m128 r01 = _mm_add_ps(xy, wz);
+    __m128 r02 = _mm_sub_ps(xz, wy);
+    __m128 r10 = _mm_sub_ps(xy, wz);
+    __m128 r11 = _mm_sub_ps(one, _mm_add_ps(xx, zz));
+    __m128 r12 = _mm_add_ps(yz, wx);
+    __m128 r20 = _mm_add_ps(xz, wy);
+    __m128 r21 = _mm_sub_ps(yz, wx);
+    __m128 r22 = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+
+    __m128 ix = inverseScaleSse4(sx);
+    __m128 iy = inverseScaleSse4(sy);
+    __m128 iz = inverseScaleSse4(sz);
+
+    scatterColumnSse4(_mm_mul_ps(r00, sx), _mm_mul_ps(r01, sx), _mm_mul_ps(r02, sx), zero, arrays.models, idx, 16);
+    scatterColumnSse4(_mm_mul_ps(r10, sy), _mm_mul_ps(r11, sy), _mm_mul_ps(r12, sy), zero, arrays.models + 4, idx, 16);
+    scatterColumnSse4(_mm_mul_ps(r20, sz), _mm_mul_ps(r21, sz), _mm_mul_ps(r22, sz), zero, arrays.models + 8, idx, 16);
+    scatterColumnSse4(px, py, pz, one, arrays.models + 12, idx, 16);
+
+    scatterColumnSse4(_mm_mul_ps(r00, ix), _mm_mul_ps(r01, ix), _mm_mul_ps(r02, ix), zero, arrays.normals, idx, 12);
+    scatterColumnSse4(_mm_mul_ps(r10, iy), _mm_mul_ps(r11, iy), _mm_mul_ps(r12, iy), zero, arrays.normals + 4, idx, 12);
+    scatterColumnSse4(_mm_mul_ps(r20, iz), _mm_mul_ps(r21, iz), _mm_mul_ps(r22, iz), zero, arrays.normals + 8, idx, 12);
+  }
+
+  composeScalar(count - i, indices + i, arrays);
+}
+
+__attribute__((target("sse4.1")))
+static void multiplySse4(const uint32_t count, const float* left, const float* rights, float* out) {
+  __m128 l0 = _mm_loadu_ps(left);
+  __m128 l1 = _mm_loadu_ps(left + 4);
+  __m128 l2 = _mm_loadu_ps(left + 8);
+  __m128 l3 = _mm_loadu_ps(left + 12);
+
+  for (uint32_t i = 0; i < count * 4; i++) {
+    __m128 r = _mm_loadu_ps(rights + i * 4);
+    __m128 o = _mm_mul_ps(l0, _mm_shuffle_ps(r, r, 0x00));
+    o = _mm_add_ps(o, _mm_mul_ps(l1, _mm_shuffle_ps(r, r, 0x55)));
+    o = _mm_add_ps(o, _mm_mul_ps(l2, _mm_shuffle_ps(r, r, 0xaa)));
+    o = _mm_add_ps(o, _mm_mul_ps(l3, _mm_shuffle_ps(r, r, 0xff)));
+    _mm_storeu_ps(out + i * 4, o);
+  }
+}
+
+// Transposes within each 128 bit lane, lane k of register c then holds object 4k + c
+__attribute__((target("avx2,fma")))
+static inline void scatterColumnAvx2(const __m256 x, const __m256 y, const __m256 z, const __m256 w, float* base, const uint32_t* indices, const uint32_t stride) {
+  __m256 t0 = _mm256_unpacklo_ps(x, y);
+  __m256 t1 = _mm256_unpacklo_ps(z, w);
+  __m256 t2 = _mm256_unpackhi_ps(x, y);
+  __m256 t3 = _mm256_unpackhi_ps(z, w);
+
+  __m256 c0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 c1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 c2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 c3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+  _mm_storeu_ps(base + indices[0] * stride, _mm256_castps256_ps128(c0));
+  _mm_storeu_ps(base + indices[1] * stride, _mm256_castps256_ps128(c1));
+  _mm_storeu_ps(base + indices[2] * stride, _mm256_castps256_ps128(c2));
+  _mm_storeu_ps(base + indices[3] * stride, _mm256_castps256_ps128(c3));
+  _mm_storeu_ps(base + indices[4] * stride, _mm256_extractf128_ps(c0, 1));
+  _mm_storeu_ps(base + indices[5] * stride, _mm256_extractf128_ps(c1, 1));
+  _mm_storeu_ps(base + indices[6] * stride, _mm256_extractf128_ps(c2, 1));
+  _mm_storeu_ps(base + indices[7] * stride, _mm256_extractf128_ps(c3, 1));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 inverseScaleAvx2(__m256 scale) {
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 magnitude = _mm256_max_ps(_mm256_andnot_ps(sign, scale), _mm256_set1_ps(MIN_SCALE));
+  return _mm256_or_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), magnitude), _mm256_and_ps(sign, scale));
+}
+
+__attribute__((target("avx2,fma")))
+static void composeAvx2(const uint32_t count, const uint32_t* indices, const TransformArrays& arrays) {
+  const float* rotations = arrays.rotations + (arrays.rotationWFirst ? 1 : 0);
+  const float* rotationsW = arrays.rotations + (arrays.rotationWFirst ? 0 : 3);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 one = _mm256_set1_ps(1.0f);
+  uint32_t i = 0;
+
+  for (; i + 8 <= count; i += 8) {
+    const uint32_t* idx = indices + i;
+    __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+    __m256i idx3 = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(3));
+    __m256i idx4 = _mm256_slli_epi32(lanes, 2);
+
+    __m256 px = _mm256_i32gather_ps(arrays.positions, idx3, 4);
+    __m256 py = _mm256_i32gather_ps(arrays.positions + 1, idx3, 4);
+    __m256 pz = _mm256_i32gather_ps(arrays.positions + 2, idx3, 4);
+    __m256 sx = _mm256_i32gather_ps(arrays.scales, idx3, 4);
+    __m256 sy = _mm256_i32gather_ps(arrays.scales + 1, idx3, 4);
+    __m256 sz = _mm256_i32gather_ps(arrays.scales + 2, idx3, 4);
+    __m256 qx = _mm256_i32gather_ps(rotations, idx4, 4);
+    __m256 qy = _mm256_i32gather_ps(rotations + 1, idx4, 4);
+    __m256 qz = _mm256_i32gather_ps(rotations + 2, idx4, 4);
+    __m256 qw = _mm256_i32gather_ps(rotationsW, idx4, 4);
+
+    __m256 x2 = _mm256_add_ps(qx, qx);
+    __m256 y2 = _mm256_add_ps(qy, qy);
+    __m256 z2 = _mm256_add_ps(qz, qz);
+    __m256 xx = _mm256_mul_ps(qx, x2);
+    __m256 yy = _mm256_mul_ps(qy, y2);
+    __m256 zz = _mm256_mul_ps(qz, z2);
+    __m256 xy = _mm256_mul_ps(qx, y2);
+    __m256 xz = _mm256_mul_ps(qx, z2);
+    __m256 yz = _mm256_mul_ps(qy, z2);
+    __m256 wx = _mm256_mul_ps(qw, x2);
+    __m256 wy = _mm256_mul_ps(qw, y2);
+    __m256 wz = _mm256_mul_ps(qw, z2);
+
+    __m256 r00 = _mm256_sub_ps(one, _mm256_add_ps(yy, zz));
+    __m256 r01 = _mm256_add_ps(xy, wz);
+    __m256 r02 = _mm256_sub_ps(xz, wy);
+    __m256 r10 = _mm256_sub_ps(xy, wz);
+    __m256 r11 = _mm256_sub_ps(one, _mm256_add_ps(xx, zz));
+    __m256 r12 = _mm256_add_ps(yz, wx);
+    __m256 r20 = _mm256_add_ps(xz, wy);
+    __m256 r21 = _mm256_sub_ps(yz, wx);
+    __m256 r22 = _mm256_sub_ps(one, _mm256_add_ps(xx, yy));
+
+    __m256 ix = inverseScaleAvx2(sx);
+    __m256 iy = inverseScaleAvx2(sy);
+    __m256 iz = inverseScaleAvx2(sz);
+
+    scatterColumnAvx2(_mm256_mul_ps(r00, sx), _mm256_mul_ps(r01, sx), _mm256_mul_ps(r02, sx), zero, arrays.models, idx, 16);
+    scatterColumnAvx2(_mm256_mul_ps(r10, sy), _mm256_mul_ps(r11, sy), _mm256_mul_ps(r12, sy), zero, arrays.models + 4, idx, 16);
+    scatterColumnAvx2(_mm256_mul_ps(r20, sz), _mm256_mul_ps(r21, sz), _mm256_mul_ps(r22, sz), zero, arrays.models + 8, idx, 16);
+    scatterColumnAvx2(px, py, pz, one, arrays.models + 12, idx, 16);
+
+    scatterColumnAvx2(_mm256_mul_ps(r00, ix), _mm256_mul_ps(r01, ix), _mm256_mul_ps(r02, ix), zero, arrays.normals, idx, 12);
+    scatterColumnAvx2(_mm256_mul_ps(r10, iy), _mm256_mul_ps(r11, iy), _mm256_mul_ps(r12, iy), zero, arrays.normals + 4, idx, 12);
+    scatterColumnAvx2(_mm256_mul_ps(r20, iz), _mm256_mul_ps(r21, iz), _mm256_mul_ps(r22, iz), zero, arrays.normals + 8, idx, 12);
+  }
+
+  composeScalar(count - i, indices + i, arrays);
+}
+
+// Two columns per register, each 128 bit lane broadcasts its own column's components
+__attribute__((target("avx2,fma")))
+static void multiplyAvx2(const uint32_t count, const float* left, const float* rights, float* out) {
+  __m256 l0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left));
+  __m256 l1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left + 4));
+  __m256 l2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left + 8));
+  __m256 l3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(left + 12));
+
+  for (uint32_t i = 0; i < count * 2; i++) {
+    __m256 r = _mm256_loadu_ps(rights + i * 8);
+    __m256 o = _mm256_mul_ps(l0, _mm256_shuffle_ps(r, r, 0x00));
+    o = _mm256_fmadd_ps(l1, _mm256_shuffle_ps(r, r, 0x55), o);
+    o = _mm256_fmadd_ps(l2, _mm256_shuffle_ps(r, r, 0xaa), o);
+    o = _mm256_fmadd_ps(l3, _mm256_shuffle_ps(r, r, 0xff), o);
+    _mm256_storeu_ps(out + i * 8, o);
+  }
+}
+
+__attribute__((target("avx512f")))
+static inline void scatterColumnAvx512(const __m512 x, const __m512 y, const __m512 z, const __m512 w, float* base, const uint32_t* indices, const uint32_t stride) {
+  __m512 t0 = _mm512_unpacklo_ps(x, y);
+  __m512 t1 = _mm512_unpacklo_ps(z, w);
+  __m512 t2 = _mm512_unpackhi_ps(x, y);
+  __m512 t3 = _mm512_unpackhi_ps(z, w);
+
+  __m512 c0 = _mm512_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+  __m512 c1 = _mm512_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+  __m512 c2 = _mm512_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m512 c3 = _mm512_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+  _mm_storeu_ps(base + indices[0] * stride, _mm512_extractf32x4_ps(c0, 0));
+  _mm_storeu_ps(base + indices[1] * stride, _mm512_extractf32x4_ps(c1, 0));
+  _mm_storeu_ps(base + indices[2] * stride, _mm512_extractf32x4_ps(c2, 0));
+  _mm_storeu_ps(base + indices[3] * stride, _mm512_extractf32x4_ps(c3, 0));
+  _mm_storeu_ps(base + indices[4] * stride, _mm512_extractf32x4_ps(c0, 1));
+  _mm_storeu_ps(base + indices[5] * stride, _mm512_extractf32x4_ps(c1, 1));
+  _mm_storeu_ps(base + indices[6] * stride, _mm512_extractf32x4_ps(c2, 1));
+  _mm_storeu_ps(base + indices[7] * stride, _mm512_extractf32x4_ps(c3, 1));
+  _mm_storeu_ps(base + indices[8] * stride, _mm512_extractf32x4_ps(c0, 2));
+  _mm_storeu_ps(base + indices[9] * stride, _mm512_extractf32x4_ps(c1, 2));
+  _mm_storeu_ps(base + indices[10] * stride, _mm512_extractf32x4_ps(c2, 2));
+  _mm_storeu_ps(base + indices[11] * stride, _mm512_extractf32x4_ps(c3, 2));
+  _mm_storeu_ps(base + indices[12] * stride, _mm512_extractf32x4_ps(c0, 3));
+  _mm_storeu_ps(base + indices[13] * stride, _mm512_extractf32x4_ps(c1, 3));
+  _mm_storeu_ps(base + indices[14] * stride, _mm512_extractf32x4_ps(c2, 3));
+  _mm_storeu_ps(base + indices[15] * stride, _mm512_extractf32x4_ps(c3, 3));
+}
+
+// AVX-512F has no float bitwise ops, the sign is moved with integer ones
+__attribute__((target("avx512f")))
+static inline __m512 inverseScaleAvx512(__m512 scale) {
+  __m512i sign = _mm512_and_si512(_mm512_castps_si512(scale), _mm512_set1_epi32(static_cast<int>(0x80000000u)));
+  __m512 magnitude = _mm512_max_ps(_mm512_abs_ps(scale), _mm512_set1_ps(MIN_SCALE));
+  return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(_mm512_div_ps(_mm512_set1_ps(1.0f), magnitude)), sign));
+}
+
+__attribute__((target("avx512f")))
+static void composeAvx512(const uint32_t count, const uint32_t* indices, const TransformArrays& arrays) {
+  const float* rotations = arrays.rotations + (arrays.rotationWFirst ? 1 : 0);
+  const float* rotationsW = arrays.rotations + (arrays.rotationWFirst ? 0 : 3);
+  __m512 zero = _mm512_setzero_ps();
+  __m512 one = _mm512_set1_ps(1.0f);
+  uint32_t i = 0;
+
+  for (; i + 16 <= count; i += 16) {
+    const uint32_t* idx = indices + i;
+    __m512i lanes = _mm512_loadu_si512(idx);
+    __m512i idx3 = _mm512_mullo_epi32(lanes, _mm512_set1_epi32(3));
+    __m512i idx4 = _mm512_slli_epi32(lanes, 2);
+
+    __m512 px = _mm512_i32gather_ps(idx3, arrays.positions, 4);
+    __m512 py = _mm512_i32gather_ps(idx3, arrays.positions + 1, 4);
+    __m512 pz = _mm512_i32gather_ps(idx3, arrays.positions + 2, 4);
+    __m512 sx = _mm512_i32gather_ps(idx3, arrays.scales, 4);
+    __m512 sy = _mm512_i32gather_ps(idx3, arrays.scales + 1, 4);
+    __m512 sz = _mm512_i32gather_ps(idx3, arrays.scales + 2, 4);
+    __m512 qx = _mm512_i32gather_ps(idx4, rotations, 4);
+    __m512 qy = _mm512_i32gather_ps(idx4, rotations + 1, 4);
+    __m512 qz = _mm512_i32gather_ps(idx4, rotations + 2, 4);
+    __m512 qw = _mm512_i32gather_ps(idx4, rotationsW, 4);
+
+    __m512 x2 = _mm512_add_ps(qx, qx);
+    __m512 y2 = _mm512_add_ps(qy, qy);
+    __m512 z2 = _mm512_add_ps(qz, qz);
+    __m512 xx = _mm512_mul_ps(qx, x2);
+    __m512 yy = _mm512_mul_ps(qy, y2);
+    __m512 zz = _mm512_mul_ps(qz, z2);
+    __m512 xy = _mm512_mul_ps(qx, y2);
+    __m512 xz = _mm512_mul_ps(qx, z2);
+    __m512 yz = _mm512_mul_ps(qy, z2);
+    __m512 wx = _mm512_mul_ps(qw, x2);
+    __m512 wy = _mm512_mul_ps(qw, y2);
+    __m512 wz = _mm512_mul_ps(qw, z2);
+
+    __m512 r00 = _mm512_sub_ps(one, _mm512_add_ps(yy, zz));
+    __m512 r01 = _mm512_add_ps(xy, wz);
+    __m512 r02 = _mm512_sub_ps(xz, wy);
+    __m512 r10 = _mm512_sub_ps(xy, wz);
+    __m512 r11 = _mm512_sub_ps(one, _mm512_add_ps(xx, zz));
+    __m512 r12 = _mm512_add_ps(yz, wx);
+    __m512 r20 = _mm512_add_ps(xz, wy);
+    __m512 r21 = _mm512_sub_ps(yz, wx);
+    __m512 r22 = _mm512_sub_ps(one, _mm512_add_ps(xx, yy));
+
+    __m512 ix = inverseScaleAvx512(sx);
+    __m512 iy = inverseScaleAvx512(sy);
+    __m512 iz = inverseScaleAvx512(sz);
+
+    scatterColumnAvx512(_mm512_mul_ps(r00, sx), _mm512_mul_ps(r01, sx), _mm512_mul_ps(r02, sx), zero, arrays.models, idx, 16);
+    scatterColumnAvx512(_mm512_mul_ps(r10, sy), _mm512_mul_ps(r11, sy), _mm512_mul_ps(r12, sy), zero, arrays.models + 4, idx, 16);
+    scatterColumnAvx512(_mm512_mul_ps(r20, sz), _mm512_mul_ps(r21, sz), _mm512_mul_ps(r22, sz), zero, arrays.models + 8, idx, 16);
+    scatterColumnAvx512(px, py, pz, one, arrays.models + 12, idx, 16);
+
+    scatterColumnAvx512(_mm512_mul_ps(r00, ix), _mm512_mul_ps(r01, ix), _mm512_mul_ps(r02, ix), zero, arrays.normals, idx, 12);
+    scatterColumnAvx512(_mm512_mul_ps(r10, iy), _mm512_mul_ps(r11, iy), _mm512_mul_ps(r12, iy), zero, arrays.normals + 4, idx, 12);
+    scatterColumnAvx512(_mm512_mul_ps(r20, iz), _mm512_mul_ps(r21, iz), _mm512_mul_ps(r22, iz), zero, arrays.normals + 8, idx, 12);
+  }
+
+  composeScalar(count - i, indices + i, arrays);
+}
+
+// A whole matrix per register, each 128 bit lane is one column
+__attribute__((target("avx512f")))
+static void multiplyAvx512(const uint32_t count, const float* left, const float* rights, float* out) {
+  __m512 l0 = _mm512_broadcast_f32x4(_mm_loadu_ps(left));
+  __m512 l1 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 4));
+  __m512 l2 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 8));
+  __m512 l3 = _mm512_broadcast_f32x4(_mm_loadu_ps(left + 12));
+
+  for (uint32_t i = 0; i < count; i++) {
+    __m512 r = _mm512_loadu_ps(rights + i * 16);
+    __m512 o = _mm512_mul_ps(l0, _mm512_permute_ps(r, 0x00));
+    o = _mm512_fmadd_ps(l1, _mm512_permute_ps(r, 0x55), o);
+    o = _mm512_fmadd_ps(l2, _mm512_permute_ps(r, 0xaa), o);
+    o = _mm512_fmadd_ps(l3, _mm512_permute_ps(r, 0xff), o);
+    _mm512_storeu_ps(out + i * 16, o);
+  }
+}
+
+#endif
+
+static KernelTable table(const KernelIsa isa) {
+  switch (isa) {
+#ifdef VKR_X86_KERNELS
+    case KernelIsa::Sse4:
+      return KernelTable{isa, composeSse4, multiplySse4};
+    case KernelIsa::Avx2:
+      return KernelTable{isa, composeAvx2, multiplyAvx2};
+    case KernelIsa::Avx512:
+      return KernelTable{isa, composeAvx512, multiplyAvx512};
+#endif
+    default:
+      return KernelTable{KernelIsa::Scalar, composeScalar, multiplyScalar};
+  }
+}
+
+static KernelTable activeKernels = table(kernels::detect());
+
+namespace kernels {
+  KernelIsa detect() {
+#ifdef VKR_X86_KERNELS
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+      return KernelIsa::Avx512;
+    }
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return KernelIsa::Avx2;
+    }
+
+    if (__builtin_cpu_supports("sse4.1")) {
+      return KernelIsa::Sse4;
+    }
+#endif
+
+    return KernelIsa::Scalar;
+  }
+
+  bool supported(const KernelIsa isa) {
+    return isa < KernelIsa::Count && isa <= detect();
+  }
+
+  std::string_view name(const KernelIsa isa) {
+    switch (isa) {
+      case KernelIsa::Scalar:
+        return "scalar";
+      case KernelIsa::Sse4:
+        return "sse4";
+      case KernelIsa::Avx2:
+        return "avx2";
+      case KernelIsa::Avx512:
+        return "avx512";
+      default:
+        return "unknown";
+    }
+  }
+
+  KernelIsa active() {
+    return activeKernels.isa;
+  }
+
+  void use(const KernelIsa isa) {
+    if (!supported(isa)) {
+      throw std::runtime_error{"Kernel variant is not supported by this CPU"};
+    }
+
+    activeKernels = table(isa);
+  }
+
+  void composeTransforms(const uint32_t count, const uint32_t* indices, const TransformArrays& arrays) {
+    activeKernels.compose(count, indices, arrays);
+  }
+
+  void multiplyMatrices(const uint32_t count, const float* left, const float* rights, float* out) {
+    activeKernels.multiply(count, left, rights, out);
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+enum class KernelIsa : uint32_t {
+  Scalar,
+  Sse4,
+  Avx2,
+  Avx512,
+  Count
+};
+
+// Plain float views over the transform arrays, matrices are column major like glm's
+struct TransformArrays {
+  const float* positions = nullptr;
+  const float* rotations = nullptr;
+  const float* scales = nullptr;
+  float* models = nullptr;
+  float* normals = nullptr;
+  bool rotationWFirst = false;
+};
+
+namespace kernels {
+  KernelIsa detect();
+  bool supported(const KernelIsa isa);
+  std::string_view name(const KernelIsa isa);
+
+  // Every variant gives the same results up to rounding, forcing one is only useful for comparing them
+  KernelIsa active();
+  void use(const KernelIsa isa);
+
+  // Builds the model matrix (mat4) and normal matrix (mat3x4) of each listed object from its position, rotation and scale
+  void composeTransforms(const uint32_t count, const uint32_t* indices, const TransformArrays& arrays);
+
+  // out[i] = left * rights[i] for count mat4s
+  void multiplyMatrices(const uint32_t count, const float* left, const float* rights, float* out);
+}
@@ -0,0 +1,162 @@
+#include "transform.hpp"
+#include "transform-kernels.hpp"
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && sizeof(glm::quat) == 4 * sizeof(float), "Transform kernels expect tightly packed glm types");
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float) && sizeof(glm::mat3x4) == 12 * sizeof(float), "Transform kernels expect tightly packed glm types");
+
+// glm changed the quaternion's memory order between releases, so it is probed instead of assumed
+static bool quatWFirst() {
+  glm::quat identity{1.0f, 0.0f, 0.0f, 0.0f};
+  return reinterpret_cast<const float*>(&identity)[0] == 1.0f;
+}
+
+static const bool QUAT_W_FIRST = quatWFirst();
+
+TransformStorage::TransformStorage() {
+}
+
+uint32_t TransformStorage::add(const Transform& transform) {
+  uint32_t idx = positions.size();
+
+  positions.push_back(transform.position);
+  rotations.push_back(transform.rotation);
+  scales.push_back(transform.scale);
+
+  models.push_back(glm::mat4{1.0f});
+  normals.push_back(glm::mat3x4{1.0f});
+  dirty.push_back(0);
+
+  markDirty(idx);
+
+  return idx;
+}
+
+void TransformStorage::remove(const uint32_t idx) {
+  uint32_t last = positions.size() - 1;
+
+  if (idx != last) {
+    positions[idx] = positions[last];
+    rotations[idx] = rotations[last];
+    scales[idx] = scales[last];
+    models[idx] = models[last];
+    normals[idx] = normals[last];
+
+    if (dirty[last] && !dirty[idx]) {
+      dirtyList.push_back(idx);
+    }
+
+    dirty[idx] = dirty[last];
+  }
+
+  positions.pop_back();
+  rotations.pop_back();
+  scales.pop_back();
+  models.pop_back();
+  normals.pop_back();
+  dirty.pop_back();
+}
+
+void TransformStorage::reserve(const size_t count) {
+  positions.reserve(count);
+  rotations.reserve(count);
+  scales.reserve(count);
+  models.reserve(count);
+  normals.reserve(count);
+  dirty.reserve(count);
+  dirtyList.reserve(count);
+}
+
+void TransformStorage::clear() {
+  positions.clear();
+  rotations.clear();
+  scales.clear();
+  models.clear();
+  normals.clear();
+  dirty.clear();
+  dirtyList.clear();
+  updated.clear();
+}
+
+Transform TransformStorage::get(const uint32_t idx) const {
+  Transform transform{};
+
+  transform.position = positions[idx];
+  transform.rotation = rotations[idx];
+  transform.scale = scales[idx];
+
+  return transform;
+}
+
+void TransformStorage::set(const uint32_t idx, const Transform& transform) {
+  positions[idx] = transform.position;
+  rotations[idx] = transform.rotation;
+  scales[idx] = transform.scale;
+  markDirty(idx);
+}
+
+void TransformStorage::setPosition(const uint32_t idx, const glm::vec3& position) {
+  positions[idx] = position;
+  markDirty(idx);
+}
+
+void TransformStorage::setRotation(const uint32_t idx, const glm::quat& rotation) {
+  rotations[idx] = rotation;
+  markDirty(idx);
+}
+
+void TransformStorage::setScale(const uint32_t idx, const glm::vec3& scale) {
+  scales[idx] = scale;
+  markDirty(idx);
+}
+
+void TransformStorage::markDirty(const uint32_t idx) {
+  if (!dirty[idx]) {
+    dirty[idx] = 1;
+    dirtyList.push_back(idx);
+  }
+}
+
+uint32_t TransformStorage::update(JobSystem& jobs) {
+  updated.clear();
+
+  // When much of the scene moved, scanning the flags is cheaper and yields indices in storage order,
+  // which keeps the kernels' loads and stores sequential instead of in whatever order objects were touched
+  if (dirtyList.size() > dirty.size() / 4) {
+    for (uint32_t idx = 0; idx < dirty.size(); idx++) {
+      if (dirty[idx]) {
+        dirty[idx] = 0;
+        updated.push_back(idx);
+      }
+    }
+  } else {
+    for (uint32_t idx : dirtyList) {
+      if (idx >= dirty.size() || !dirty[idx]) {
+        continue;
+      }
+
+      dirty[idx] = 0;
+      updated.push_back(idx);
+    }
+  }
+
+  dirtyList.clear();
+
+  TransformArrays arrays{};
+  arrays.positions = reinterpret_cast<const float*>(positions.data());
+  arrays.rotations = reinterpret_cast<const float*>(rotations.data());
+  arrays.scales = reinterpret_cast<const float*>(scales.data());
+  arrays.models = reinterpret_cast<float*>(models.data());
+  arrays.normals = reinterpret_cast<float*>(normals.data());
+  arrays.rotationWFirst = QUAT_W_FIRST;
+
+  // Each index is written by exactly one chunk, so the matrices can be rebuilt in parallel
+  jobs.parallelFor(updated.size(), 1024, [&](const uint32_t begin, const uint32_t end) {
+    kernels::composeTransforms(end - begin, updated.data() + begin, arrays);
+  });
+
+  return updated.size();
+}
+
+size_t TransformStorage::size() const {
+  return positions.size();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "job-system.hpp"
+
+struct Transform {
+  glm::vec3 position = glm::vec3{0.0f};
+  glm::quat rotation = glm::quat{1.0f, 0.0f, 0.0f, 0.0f};
+  glm::vec3 scale = glm::vec3{1.0f};
+};
+
+class TransformStorage {
+public:
+  std::vector<glm::vec3> positions;
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec3> scales;
+
+  std::vector<glm::mat4> models;
+  std::vector<glm::mat3x4> normals;
+
+  std::vector<uint32_t> updated;
+
+  TransformStorage();
+
+  uint32_t add(const Transform& transform);
+  void remove(const uint32_t idx);
+  void reserve(const size_t count);
+  void clear();
+  Transform get(const uint32_t idx) const;
+
+  void set(const uint32_t idx, const Transform& transform);
+  void setPosition(const uint32_t idx, const glm::vec3& position);
+  void setRotation(const uint32_t idx, const glm::quat& rotation);
+  void setScale(const uint32_t idx, const glm::vec3& scale);
+
+  uint32_t update(JobSystem& jobs);
+
+  size_t size() const;
+private:
+  std::vector<uint8_t> dirty;
+  std::vector<uint32_t> dirtyList;
+
+  void markDirty(const uint32_t idx);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer. The producer fills back() and publishes it, the consumer picks up the
+// most recent publication with update(). Neither side ever waits, skipped publications are simply dropped.
+template <typename T>
+class TripleBuffer {
+public:
+  T& back() {
+    return slots[backIdx].value;
+  }
+
+  void publish() {
+    backIdx = middle.exchange(backIdx | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  bool update() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+      return false;
+    }
+
+    frontIdx = middle.exchange(frontIdx, std::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+  }
+
+  const T& front() const {
+    return slots[frontIdx].value;
+  }
+private:
+  static const uint32_t INDEX_MASK = 3;
+  static const uint32_t FRESH = 4;
+
+  // Keep each slot on its own cache line so the two threads do not false share
+  struct alignas(64) Slot {
+    T value;
+  };
+
+  std::array<Slot, 3> slots;
+  uint32_t backIdx = 0;
+  alignas(64) std::atomic<uint32_t> middle{1};
+  alignas(64) uint32_t frontIdx = 2;
+};
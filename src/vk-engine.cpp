@@ -1,4 +1,6 @@
 #include "vk-engine.hpp"
+#include "trace.hpp"
+#include "scene-file.hpp"
 #include "VkBootstrap.h"
 #include "image.hpp"
 #include "light.hpp"
@@ -11,9 +13,12 @@
 #include <SDL_mouse.h>
 #include <SDL_video.h>
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/geometric.hpp>
 #include <glm/trigonometric.hpp>
@@ -25,91 +30,233 @@
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_structs.hpp>
 
-void VkEngine::init(const Display& d) {
+void VkEngine::init(const Display& d, const Settings& s) {
+  TRACE_FUNCTION();
+
   display = d;
+  settings = s;
+  framePacer = FramePacer{settings.targetFrameRate};
+  resolutionScaler = ResolutionScaler{settings.gpuBudget > 0.0 ? settings.gpuBudget : 1000.0 / (settings.targetFrameRate > 0.0 ? settings.targetFrameRate : 60.0)};
+  createJobSystem();
   createInstance();
   pickPhysicalDevice();
   pickDevice();
   createSwapchain();
   createAllocator();
+  createRenderGraph();
   createQueue();
   createSyncPrimitives();
   createCommandPool();
   createCommandBuffers();
+  createQueryPool();
   createSampler();
-  createDescriptorPool();
+  createBindlessTextures();
+  createTextureStreamer();
+  mountAssetArchive();
+  createDescriptorAllocators();
+  createObjectBuffer();
+  createClusteredLights();
+  createShadowMap();
   createDepthImage();
   createViewportAndScissors();
+  createOcclusionCulling();
   createPipelines();
+  createShaderReloader();
+  createDepthPrepass();
+  createSimulation();
 };
   
 void VkEngine::destroySwapchainResources() {
   vk::Device d = device.device;
 
-  for (size_t i = 0; i < MAX_CONCURRENT_FRAMES; i++) {
+  for (size_t i = 0; i < swapchainImageViews.size(); i++) {
     d.destroyImageView(swapchainImageViews[i]);
+    d.destroySemaphore(renderCompleteSemaphores[i]);
   }
 
-  d.destroyImageView(depthImage.view);
-  vmaDestroyImage(allocator, depthImage.image, depthImage.allocation);
+  depthImage.destroy(allocator, d);
 }
 
-void VkEngine::rebuiltSwapchain() {
+void VkEngine::destroyRetiredSwapchain(const RetiredSwapchain& retired) {
   vk::Device d = device.device;
-  vkb::Swapchain old = swapchain;
 
-  d.waitIdle();
+  for (size_t i = 0; i < retired.imageViews.size(); i++) {
+    d.destroyImageView(retired.imageViews[i]);
+    d.destroySemaphore(retired.semaphores[i]);
+  }
 
-  destroySwapchainResources();
+  vkb::destroy_swapchain(retired.swapchain);
+}
+
+void VkEngine::rebuiltSwapchain() {
+  vk::Device d = device.device;
+  RetiredSwapchain retired{swapchain, swapchainImageViews, renderCompleteSemaphores, presentId + 1};
 
   createSwapchain();
-  createDepthImage();
   createViewportAndScissors();
+  occlusionCulling.historyValid = false;
+
+  // Presents on the old swapchain may still wait on its semaphores, so it goes once the first present on the new one has
+  // completed. Without present ids nothing reports that, the device is drained instead
+  if (presentWaitSupported) {
+    retiredSwapchains.push_back(retired);
+  } else {
+    d.waitIdle();
+    destroyRetiredSwapchain(retired);
+  }
+
+  if (swapchain.extent.width > depthImage.extent.width || swapchain.extent.height > depthImage.extent.height) {
+    Image oldDepthImage = depthImage;
+    VmaAllocator vma = allocator;
+
+    deletionQueue.push(submitSerial, [d, vma, oldDepthImage]() mutable {
+      oldDepthImage.destroy(vma, d);
+    });
+
+    createDepthImage();
+    occlusionCulling.resize(allocator, d, depthImage.view, vk::Extent2D{depthImage.extent.width, depthImage.extent.height}, deletionQueue, submitSerial);
+  }
 
-  vkb::destroy_swapchain(old);
+  lastCompletedPresentId = presentId;
 }
 
-void VkEngine::drawFrame(float deltaTime) {
+float VkEngine::beginFrame() {
+  TRACE_FUNCTION();
+
+  TRACE_BEGIN(paceZone, "frame pacing");
+  float deltaTime = framePacer.wait();
+  TRACE_END(paceZone);
+
   vk::Device d = device.device;
 
+  TRACE_BEGIN(fenceZone, "fence wait");
+
   if (d.waitForFences(1, &fences[frame], 1, UINT64_MAX) != vk::Result::eSuccess) {
     throw std::runtime_error{"Failed to wait for fence"};
   };
 
-  if (shouldBeResized) {
+  TRACE_END(fenceZone);
+
+  deletionQueue.flush(frameSerials[frame]);
+  applyShaderReloads();
+
+  if (shouldRebuildSwapchain) {
     rebuiltSwapchain();
-    shouldBeResized = false;
+    shouldRebuildSwapchain = false;
   }
 
-  vk::SwapchainKHR swap = swapchain.swapchain;
-  
-  uint32_t imageIndex;
-  vk::Result acquireResult = d.acquireNextImageKHR(swap, UINT64_MAX, presentCompleteSemaphores[frame], nullptr, &imageIndex);
+  waitForPresent();
+
+  TRACE_BEGIN(acquireZone, "acquire");
+  vk::Result acquireResult = d.acquireNextImageKHR(swapchain.swapchain, UINT64_MAX, presentCompleteSemaphores[frame], nullptr, &imageIndex);
+  TRACE_END(acquireZone);
 
-  vk::ImageView swapImageView = swapchainImageViews[imageIndex];
-  vk::Image swapImage = swapchainImages[imageIndex];
-  
   switch (acquireResult) {
     case vk::Result::eSuccess:
+      frameAcquired = true;
       break;
     case vk::Result::eSuboptimalKHR:
-      rebuiltSwapchain();
-      return;
+      frameAcquired = true;
+      shouldRebuildSwapchain = true;
+      break;
     case vk::Result::eErrorOutOfDateKHR:
       rebuiltSwapchain();
-      return;
+      break;
     case vk::Result::eNotReady:
     default:
       throw std::runtime_error{"Failed to acquire next image"};
       break;
   }
 
+  return deltaTime;
+}
+
+void VkEngine::waitForPresent() {
+  if (!presentWaitSupported) {
+    return;
+  }
+
+  TRACE_FUNCTION();
+
+  while (lastCompletedPresentId < presentId) {
+    uint64_t id = lastCompletedPresentId + 1;
+    uint64_t timeout = settings.lowLatency && id < presentId ? 100'000'000 : 0;
+
+    if (vkWaitForPresent(device.device, swapchain.swapchain, id, timeout) != VK_SUCCESS) {
+      break;
+    }
+
+    framePacer.presented(id, FramePacer::Clock::now(), true);
+    lastCompletedPresentId = id;
+  }
+
+  while (!retiredSwapchains.empty() && retiredSwapchains.front().presentId <= lastCompletedPresentId) {
+    destroyRetiredSwapchain(retiredSwapchains.front());
+    retiredSwapchains.erase(retiredSwapchains.begin());
+  }
+}
+
+void VkEngine::drawFrame(float deltaTime) {
+  if (!frameAcquired) {
+    return;
+  }
+
+  frameAcquired = false;
+
+  TRACE_FUNCTION();
+
+  vk::Device d = device.device;
+  vk::SwapchainKHR swap = swapchain.swapchain;
+
+  vk::ImageView swapImageView = swapchainImageViews[imageIndex];
+  vk::Image swapImage = swapchainImages[imageIndex];
+
   if (d.resetFences(1, &fences[frame]) != vk::Result::eSuccess) {
     throw std::runtime_error{"Failed to reset fence"};
   };
 
+  frameDescriptorAllocators[frame].reset(d);
+
+  if (statisticsSupported && statisticsPending[frame]) {
+    uint64_t invocations = 0;
+
+    if (d.getQueryPoolResults(statisticsQueryPool, frame, 1, sizeof(uint64_t), &invocations, sizeof(uint64_t), vk::QueryResultFlagBits::e64) == vk::Result::eSuccess) {
+      lastRenderStats.fragmentInvocations = invocations;
+      lastRenderStats.overdraw = invocations / (renderViewport.width * renderViewport.height);
+    }
+
+    statisticsPending[frame] = false;
+  }
+
+  if (timestampsSupported && timestampsPending[frame]) {
+    uint64_t timestamps[2] = {0, 0};
+
+    if (d.getQueryPoolResults(timestampQueryPool, frame * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64) == vk::Result::eSuccess) {
+      lastRenderStats.gpuTime = (timestamps[1] - timestamps[0]) * timestampPeriod / 1000000.0f;
+
+      if (settings.dynamicResolution) {
+        resolutionScaler.update(lastRenderStats.gpuTime);
+      }
+    }
+
+    timestampsPending[frame] = false;
+  }
+
+  float resolutionScale = settings.dynamicResolution ? resolutionScaler.scale() : 1.0f;
+
+  renderViewport = viewport;
+  renderViewport.width = std::max(1.0f, std::floor(viewport.width * resolutionScale));
+  renderViewport.height = std::max(1.0f, std::floor(viewport.height * resolutionScale));
+  lastRenderStats.resolutionScale = resolutionScale;
+
+  // Clears, loads and stores stay inside the scaled region as well, not just rasterisation
+  renderScissors = scissors;
+  renderScissors.extent = vk::Extent2D{static_cast<uint32_t>(renderViewport.width), static_cast<uint32_t>(renderViewport.height)};
+
   vk::CommandBuffer commandBuffer = commadBuffers[frame];
 
+  TRACE_BEGIN(recordZone, "record");
+
   commandBuffer.reset();
 
   vk::CommandBufferBeginInfo beginInfo = vk::CommandBufferBeginInfo{}
@@ -117,115 +264,270 @@ void VkEngine::drawFrame(float deltaTime) {
 
   commandBuffer.begin(beginInfo);
 
-  vk::ClearValue clearValue = vk::ClearValue{}.setColor(vk::ClearColorValue{}.setUint32({0xFF, 0XFF, 0xFF, 0xFF}));
-  vk::ClearValue depthClearValue = vk::ClearValue{}.setDepthStencil(vk::ClearDepthStencilValue{}.setDepth(1.0f).setStencil(0));
+  if (statisticsSupported) {
+    commandBuffer.resetQueryPool(statisticsQueryPool, frame, 1);
+  }
 
-  vk::RenderingAttachmentInfo depthAttachment = vk::RenderingAttachmentInfo{}
-    .setImageView(depthImage.view)
-    .setImageLayout(vk::ImageLayout::eDepthAttachmentOptimal)
-    .setLoadOp(vk::AttachmentLoadOp::eClear)
-    .setStoreOp(vk::AttachmentStoreOp::eNone)
-    .setClearValue(depthClearValue);
+  if (timestampsSupported) {
+    commandBuffer.resetQueryPool(timestampQueryPool, frame * 2, 2);
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, timestampQueryPool, frame * 2);
+  }
 
-  vk::RenderingAttachmentInfo attachment = vk::RenderingAttachmentInfo{}
-    .setImageView(swapImageView)
-    .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
-    .setLoadOp(vk::AttachmentLoadOp::eClear)
-    .setStoreOp(vk::AttachmentStoreOp::eStore)
-    .setClearValue(clearValue);
+  applySimulation();
 
-  vk::RenderingInfo renderingInfo = vk::RenderingInfo{}
-    .setRenderArea(scissors)
-    .setLayerCount(1)
-    .setViewMask(0)
-    .setColorAttachmentCount(1)
-    .setColorAttachments(attachment)
-    .setPDepthAttachment(&depthAttachment);
+  projection.view = glm::lookAt(camera.pos, camera.pos + camera.front, camera.up);
 
-  vk::ImageSubresourceRange depthSubresourceRange = vk::ImageSubresourceRange{}
-    .setLayerCount(1)
-    .setAspectMask(vk::ImageAspectFlagBits::eDepth)
-    .setBaseMipLevel(0)
-    .setLevelCount(1)
-    .setBaseArrayLayer(0);
+  for (Pipeline& pipeline : pipelines) {
+    if (!pipeline.graphicsPipeline) {
+      continue;
+    }
 
-  vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange{}
-    .setLayerCount(1)
-    .setAspectMask(vk::ImageAspectFlagBits::eColor)
-    .setBaseMipLevel(0)
-    .setLevelCount(1)
-    .setBaseArrayLayer(0);
-
-  vk::ImageMemoryBarrier2 depthMemoryBarrier = vk::ImageMemoryBarrier2{}
-    .setImage(depthImage.image)
-    .setOldLayout(vk::ImageLayout::eUndefined)
-    .setNewLayout(vk::ImageLayout::eDepthAttachmentOptimal)
-    .setSrcAccessMask(vk::AccessFlagBits2::eDepthStencilAttachmentWrite)
-    .setDstAccessMask(vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite)
-    .setSrcStageMask(vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests)
-    .setDstStageMask(vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests)
-    .setSubresourceRange(depthSubresourceRange);
-
-  vk::ImageMemoryBarrier2 imageMemoryBarrier = vk::ImageMemoryBarrier2{}
-    .setImage(swapImage)
-    .setOldLayout(vk::ImageLayout::eUndefined)
-    .setNewLayout(vk::ImageLayout::eColorAttachmentOptimal)
-    .setSrcAccessMask(vk::AccessFlagBits2::eNone)
-    .setDstAccessMask(vk::AccessFlagBits2::eColorAttachmentWrite)
-    .setSrcStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput)
-    .setDstStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput)
-    .setSubresourceRange(subresourceRange);
-
-  vk::ImageMemoryBarrier2 presentImageMemoryBarrier = vk::ImageMemoryBarrier2{}
-    .setImage(swapImage)
-    .setOldLayout(vk::ImageLayout::eColorAttachmentOptimal)
-    .setNewLayout(vk::ImageLayout::ePresentSrcKHR)
-    .setSrcAccessMask(vk::AccessFlagBits2::eColorAttachmentWrite)
-    .setDstAccessMask(vk::AccessFlagBits2::eNone)
-    .setSrcStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput)
-    .setDstStageMask(vk::PipelineStageFlagBits2::eBottomOfPipe)
-    .setSubresourceRange(subresourceRange);
-
-  vk::ImageMemoryBarrier2 imageMemoryBarriers[3] = {depthMemoryBarrier, imageMemoryBarrier, presentImageMemoryBarrier};
-
-  vk::DependencyInfo dependencyInfo = vk::DependencyInfo{}
-    .setImageMemoryBarriers(imageMemoryBarriers)
-    .setImageMemoryBarrierCount(3);
-  
-  commandBuffer.pipelineBarrier2(dependencyInfo);
+    vmaCopyMemoryToAllocation(allocator, &projection, pipeline.projection.allocation, 0, sizeof(Projection));
+  }
 
-  commandBuffer.beginRendering(renderingInfo);
+  vmaCopyMemoryToAllocation(allocator, &light.properties, light.ubo.allocation, 0, sizeof(LightProperties));
 
-  commandBuffer.setViewport(0, 1, &viewport);
-  commandBuffer.setScissor(0, 1, &scissors);
+  scene.update(jobs);
+  objectBuffer.update(allocator, frame, scene.objects, scene.transforms, meshes, materials);
 
-  vk::DeviceSize offsets[1] = {0};
+  if (scene.shadowCastersChanged) {
+    shadowMap.dirty = true;
+    scene.shadowCastersChanged = false;
+  }
 
-  for (Object& object : objects) {
-    const Mesh& mesh = meshes[object.meshIdx];
-    const Texture& texture = textures[object.textureIdx];
-    const Pipeline& pipeline = pipelines[object.pipelineIdx];
+  vk::Extent2D extent = vk::Extent2D{static_cast<uint32_t>(renderViewport.width), static_cast<uint32_t>(renderViewport.height)};
+  clusteredLights.update(allocator, frame, pointLights, projection, extent);
+
+  TRACE_BEGIN(streamZone, "texture streaming");
+  textureStreamer.update(allocator, d, bindlessTextures, sampler, textures, scene.objects, scene.transforms, meshes, projection, extent, deletionQueue, submitSerial + 1, jobs);
+  textureStreamer.record(commandBuffer, allocator, deletionQueue, submitSerial + 1);
+  TRACE_END(streamZone);
+  lastRenderStats.textureMemory = textureStreamer.stats.residentBytes / (1024.0f * 1024.0f);
+  lastRenderStats.textureBudget = textureStreamer.stats.budgetBytes / (1024.0f * 1024.0f);
+
+  vk::DescriptorSet objectSet = objectBuffer.allocateDescriptorSet(d, frameDescriptorAllocators[frame], objectSetLayout, frame);
+  vk::DescriptorSet lightSet = clusteredLights.allocateDescriptorSet(d, frameDescriptorAllocators[frame], lightSetLayout, frame, light.ubo);
+  shadowMap.writeDescriptor(d, lightSet, 4);
+
+  renderGraph.reset();
+
+  uint32_t swapchainResource = renderGraph.importImage(
+    "swapchain",
+    swapImage,
+    swapImageView,
+    vk::ImageAspectFlagBits::eColor,
+    ResourceState{vk::ImageLayout::eUndefined, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eNone},
+    ResourceState{vk::ImageLayout::ePresentSrcKHR, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone}
+  );
 
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.graphicsPipeline);
+  uint32_t depthResource = renderGraph.importImage(
+    "depth",
+    depthImage.image,
+    depthImage.view,
+    vk::ImageAspectFlagBits::eDepth,
+    ResourceState{vk::ImageLayout::eUndefined, vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentWrite}
+  );
 
-    std::vector<vk::DescriptorSet> sets{texture.descriptorSets[frame], pipeline.descriptorSets[frame], object.descriptorSets[frame], light.descriptorSets[frame]};
-    
-    projection.view = glm::lookAt(camera.pos, camera.pos + camera.front, camera.up);
+  ResourceState shadowReadState = ResourceState{vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead};
 
-    vmaCopyMemoryToAllocation(allocator, &projection, pipeline.projection.allocation, 0, sizeof(Projection));
-    vmaCopyMemoryToAllocation(allocator, &object.uniform, object.ubo.allocation, 0, sizeof(UniformBuffer));
-    vmaCopyMemoryToAllocation(allocator, &light.properties, light.ubo.allocation, 0, sizeof(LightProperties));
+  uint32_t shadowResource = renderGraph.importImage(
+    "shadow-map",
+    shadowMap.image,
+    shadowMap.cubeView,
+    vk::ImageAspectFlagBits::eDepth,
+    shadowMap.state,
+    shadowReadState
+  );
 
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.pipelineLayout, 0, sets.size(), sets.data(), 0, nullptr);
-    commandBuffer.bindVertexBuffers(0, 1, &mesh.vertexBuffer.buffer, offsets);
-    commandBuffer.bindIndexBuffer(mesh.indexBuffer.buffer, 0, vk::IndexType::eUint16);
-    commandBuffer.drawIndexed(mesh.indicesCount, 1, 0, 0, 1);
+  if (shadowMap.dirty) {
+    RenderGraphPass& shadowPass = renderGraph.addPass("shadow")
+      .write(shadowResource, ResourceUsage::DepthAttachment);
+
+    shadowPass.execute = [&](vk::CommandBuffer& cmd) {
+      shadowMap.record(cmd, pipelines[0].descriptorSets[frame], objectSet, light.properties.pos, scene.objects, meshes);
+    };
+
+    shadowMap.dirty = false;
+    shadowMap.stats.renderedFrames++;
+  } else {
+    shadowMap.stats.reusedFrames++;
   }
 
-  commandBuffer.endRendering();
+  uint32_t clusterResource = renderGraph.importBuffer("clusters", clusteredLights.clusterBuffers[frame].buffer);
+
+  RenderGraphPass& clusterPass = renderGraph.addPass("light-clusters")
+    .write(clusterResource, ResourceUsage::ComputeStorageWrite);
+
+  clusterPass.execute = [&](vk::CommandBuffer& cmd) {
+    clusteredLights.dispatch(cmd, lightSet);
+  };
+
+  uint32_t colorResource = swapchainResource;
+
+  if (settings.dynamicResolution) {
+    colorResource = renderGraph.createImage("scene-color", ImageDesc{swapchain.extent, static_cast<vk::Format>(swapchain.image_format), vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc});
+  }
+
+  bool occlusionCulled = settings.occlusionCulling && !pipelines.empty();
+  uint32_t objectCount = static_cast<uint32_t>(scene.objects.size());
+  vk::DescriptorSet cullSet;
+
+  bool depthPrepassed = settings.depthPrepass && !pipelines.empty();
+
+  // The pre-pass only covers the early draws, so the late phase writes the depth of newly visible objects itself
+  ForwardPhase forward{depthPrepassed};
+  ForwardPhase forwardLate{false, true};
+
+  uint32_t drawResource = UINT32_MAX;
+  uint32_t pyramidResource = UINT32_MAX;
+
+  if (occlusionCulled) {
+    occlusionCulling.update(allocator, frame, scene.objects, meshes, projection, extent);
+    cullSet = occlusionCulling.allocateDescriptorSet(d, frameDescriptorAllocators[frame], frame);
+
+    ResourceState pyramidReadState = ResourceState{vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead};
+
+    pyramidResource = renderGraph.importImage(
+      "depth-pyramid",
+      occlusionCulling.pyramid,
+      occlusionCulling.pyramidView,
+      vk::ImageAspectFlagBits::eColor,
+      occlusionCulling.state,
+      pyramidReadState
+    );
+
+    occlusionCulling.state = pyramidReadState;
+
+    drawResource = renderGraph.importBuffer("draws", occlusionCulling.drawBuffers[frame].buffer);
+
+    forward.storeDepth = !depthPrepassed;
+    forward.drawBuffer = occlusionCulling.drawBuffers[frame].buffer;
+    forwardLate.drawBuffer = occlusionCulling.drawBuffers[frame].buffer;
+    forwardLate.firstDraw = objectCount;
+
+    RenderGraphPass& cullPass = renderGraph.addPass("occlusion-cull")
+      .read(pyramidResource, ResourceUsage::ComputeSampled)
+      .write(drawResource, ResourceUsage::ComputeStorageReadWrite);
+
+    cullPass.execute = [&](vk::CommandBuffer& cmd) {
+      occlusionCulling.cull(cmd, objectSet, cullSet, objectCount, false);
+    };
+  } else {
+    occlusionCulling.historyValid = false;
+  }
+
+  if (depthPrepassed) {
+    depthPrepass.sort(scene.objects, scene.transforms, projection.view);
+
+    RenderGraphPass& prepass = renderGraph.addPass("depth-prepass")
+      .write(depthResource, ResourceUsage::DepthAttachment);
+
+    if (occlusionCulled) {
+      prepass.read(drawResource, ResourceUsage::IndirectRead);
+    }
+
+    prepass.execute = [&](vk::CommandBuffer& cmd) {
+      depthPrepass.record(cmd, depthImage.view, renderViewport, renderScissors, pipelines[0].descriptorSets[frame], objectSet, forward.drawBuffer, scene.objects, meshes);
+    };
+  }
+
+  RenderGraphPass& forwardPass = renderGraph.addPass("forward")
+    .read(clusterResource, ResourceUsage::FragmentStorageRead)
+    .read(shadowResource, ResourceUsage::FragmentSampled)
+    .write(colorResource, ResourceUsage::ColorAttachment);
+
+  if (depthPrepassed) {
+    forwardPass.read(depthResource, ResourceUsage::DepthRead);
+  } else {
+    forwardPass.write(depthResource, ResourceUsage::DepthAttachment);
+  }
+
+  if (occlusionCulled) {
+    forwardPass.read(drawResource, ResourceUsage::IndirectRead);
+  }
+
+  forwardPass.execute = [&](vk::CommandBuffer& cmd) {
+    if (statisticsSupported) {
+      cmd.beginQuery(statisticsQueryPool, frame, vk::QueryControlFlags{});
+    }
+
+    recordForwardPass(cmd, renderGraph.view(colorResource), objectSet, lightSet, forward);
+
+    if (statisticsSupported && !occlusionCulled) {
+      cmd.endQuery(statisticsQueryPool, frame);
+      statisticsPending[frame] = true;
+    }
+  };
+
+  if (occlusionCulled) {
+    RenderGraphPass& pyramidPass = renderGraph.addPass("depth-pyramid")
+      .read(depthResource, ResourceUsage::ComputeSampled)
+      .write(pyramidResource, ResourceUsage::ComputeStorageReadWrite);
+
+    pyramidPass.execute = [&](vk::CommandBuffer& cmd) {
+      occlusionCulling.buildPyramid(cmd);
+    };
+
+    RenderGraphPass& lateCullPass = renderGraph.addPass("occlusion-cull-late")
+      .read(pyramidResource, ResourceUsage::ComputeSampled)
+      .write(drawResource, ResourceUsage::ComputeStorageReadWrite);
+
+    lateCullPass.execute = [&](vk::CommandBuffer& cmd) {
+      occlusionCulling.cull(cmd, objectSet, cullSet, objectCount, true);
+    };
+
+    RenderGraphPass& lateForwardPass = renderGraph.addPass("forward-late")
+      .read(clusterResource, ResourceUsage::FragmentStorageRead)
+      .read(shadowResource, ResourceUsage::FragmentSampled)
+      .read(drawResource, ResourceUsage::IndirectRead)
+      .write(colorResource, ResourceUsage::ColorAttachment)
+      .write(depthResource, ResourceUsage::DepthAttachment);
+
+    lateForwardPass.execute = [&](vk::CommandBuffer& cmd) {
+      recordForwardPass(cmd, renderGraph.view(colorResource), objectSet, lightSet, forwardLate);
+
+      if (statisticsSupported) {
+        cmd.endQuery(statisticsQueryPool, frame);
+        statisticsPending[frame] = true;
+      }
+    };
+  }
+
+  if (settings.dynamicResolution) {
+    RenderGraphPass& upscalePass = renderGraph.addPass("upscale")
+      .read(colorResource, ResourceUsage::TransferSrc)
+      .write(swapchainResource, ResourceUsage::TransferDst);
+
+    upscalePass.execute = [&](vk::CommandBuffer& cmd) {
+      vk::ImageSubresourceLayers subresource = vk::ImageSubresourceLayers{}
+        .setAspectMask(vk::ImageAspectFlagBits::eColor)
+        .setMipLevel(0)
+        .setBaseArrayLayer(0)
+        .setLayerCount(1);
+
+      vk::ImageBlit region = vk::ImageBlit{}
+        .setSrcSubresource(subresource)
+        .setSrcOffsets({vk::Offset3D{0, 0, 0}, vk::Offset3D{static_cast<int32_t>(renderViewport.width), static_cast<int32_t>(renderViewport.height), 1}})
+        .setDstSubresource(subresource)
+        .setDstOffsets({vk::Offset3D{0, 0, 0}, vk::Offset3D{static_cast<int32_t>(scissors.extent.width), static_cast<int32_t>(scissors.extent.height), 1}});
+
+      cmd.blitImage(renderGraph.image(colorResource), vk::ImageLayout::eTransferSrcOptimal, swapImage, vk::ImageLayout::eTransferDstOptimal, 1, &region, vk::Filter::eLinear);
+    };
+  }
+
+  renderGraph.execute(commandBuffer);
+
+  shadowMap.state = shadowReadState;
+
+  if (timestampsSupported) {
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, timestampQueryPool, frame * 2 + 1);
+    timestampsPending[frame] = true;
+  }
 
   commandBuffer.end();
 
+  TRACE_END(recordZone);
+
   vk::Flags<vk::PipelineStageFlagBits> waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
   
   vk::SubmitInfo submitInfo = vk::SubmitInfo{}
@@ -233,33 +535,50 @@ void VkEngine::drawFrame(float deltaTime) {
     .setWaitSemaphores(presentCompleteSemaphores[frame])
     .setCommandBuffers(commandBuffer)
     .setCommandBufferCount(1)
-    .setSignalSemaphores(renderCompleteSemaphores[frame])
+    .setSignalSemaphores(renderCompleteSemaphores[imageIndex])
     .setSignalSemaphoreCount(1)
     .setWaitDstStageMask(waitStage);
 
+  TRACE_BEGIN(submitZone, "submit");
+
   if (queue.submit(1, &submitInfo, fences[frame]) != vk::Result::eSuccess) {
     throw std::runtime_error{"Failed to submit to queue"};
   };
 
+  TRACE_END(submitZone);
+
+  frameSerials[frame] = ++submitSerial;
+
   uint32_t imageIndices = {imageIndex};
 
+  presentId++;
+
+  vk::PresentIdKHR presentIdInfo = vk::PresentIdKHR{}
+    .setSwapchainCount(1)
+    .setPresentIds(presentId);
+
   vk::PresentInfoKHR presentInfo = vk::PresentInfoKHR{}
+    .setPNext(presentWaitSupported ? &presentIdInfo : nullptr)
     .setWaitSemaphoreCount(1)
-    .setWaitSemaphores(renderCompleteSemaphores[frame])
+    .setWaitSemaphores(renderCompleteSemaphores[imageIndex])
     .setSwapchainCount(1)
     .setSwapchains(swap)
     .setImageIndices(imageIndices);
 
+  TRACE_BEGIN(presentZone, "present");
   vk::Result presentResult = queue.presentKHR(&presentInfo);
+  TRACE_END(presentZone);
+
+  if (!presentWaitSupported) {
+    framePacer.presented(presentId, FramePacer::Clock::now(), false);
+  }
 
   switch (presentResult) {
     case vk::Result::eSuccess:
       break;
     case vk::Result::eSuboptimalKHR:
-      rebuiltSwapchain();
-      break;
     case vk::Result::eErrorOutOfDateKHR:
-      rebuiltSwapchain();
+      shouldRebuildSwapchain = true;
       break;
     case vk::Result::eNotReady:
       throw std::runtime_error{"Not ready swapchain"};
@@ -269,10 +588,83 @@ void VkEngine::drawFrame(float deltaTime) {
       break;
   }
 
-  frame = (frame + 1) % MAX_CONCURRENT_FRAMES;
+  frame = (frame + 1) % settings.framesInFlight;
 };
 
+void VkEngine::recordForwardPass(vk::CommandBuffer& commandBuffer, const vk::ImageView& colorView, const vk::DescriptorSet& objectSet, const vk::DescriptorSet& lightSet, const ForwardPhase& phase) {
+  vk::ClearValue clearValue = vk::ClearValue{}.setColor(vk::ClearColorValue{}.setUint32({0xFF, 0XFF, 0xFF, 0xFF}));
+  vk::ClearValue depthClearValue = vk::ClearValue{}.setDepthStencil(vk::ClearDepthStencilValue{}.setDepth(1.0f).setStencil(0));
+
+  vk::RenderingAttachmentInfo depthAttachment = vk::RenderingAttachmentInfo{}
+    .setImageView(depthImage.view)
+    .setImageLayout(phase.depthPrepassed ? vk::ImageLayout::eDepthReadOnlyOptimal : vk::ImageLayout::eDepthAttachmentOptimal)
+    .setLoadOp(phase.depthPrepassed || phase.late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear)
+    .setStoreOp(phase.storeDepth ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eNone)
+    .setClearValue(depthClearValue);
+
+  vk::RenderingAttachmentInfo attachment = vk::RenderingAttachmentInfo{}
+    .setImageView(colorView)
+    .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
+    .setLoadOp(phase.late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear)
+    .setStoreOp(vk::AttachmentStoreOp::eStore)
+    .setClearValue(clearValue);
+
+  vk::RenderingInfo renderingInfo = vk::RenderingInfo{}
+    .setRenderArea(renderScissors)
+    .setLayerCount(1)
+    .setViewMask(0)
+    .setColorAttachmentCount(1)
+    .setColorAttachments(attachment)
+    .setPDepthAttachment(&depthAttachment);
+
+  commandBuffer.beginRendering(renderingInfo);
+
+  commandBuffer.setViewport(0, 1, &renderViewport);
+  commandBuffer.setScissor(0, 1, &renderScissors);
+  commandBuffer.setDepthCompareOp(phase.depthPrepassed ? vk::CompareOp::eEqual : vk::CompareOp::eLessOrEqual);
+  commandBuffer.setDepthWriteEnable(!phase.depthPrepassed);
+
+  if (!pipelines.empty()) {
+    std::vector<vk::DescriptorSet> frameSets{objectSet, lightSet};
+
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelines[0].pipelineLayout, 0, 1, &bindlessTextures.descriptorSet, 0, nullptr);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelines[0].pipelineLayout, 2, frameSets.size(), frameSets.data(), 0, nullptr);
+  }
+
+  vk::DeviceSize offsets[1] = {0};
+  uint32_t boundPipelineIdx = UINT32_MAX;
+
+  for (size_t i = 0; i < scene.objects.size(); i++) {
+    const Object& object = scene.objects[i];
+    const Mesh& mesh = meshes[object.meshIdx];
+    const Texture& texture = textures[object.textureIdx];
+    const Pipeline& pipeline = pipelines[object.pipelineIdx];
+
+    if (object.pipelineIdx != boundPipelineIdx) {
+      commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.graphicsPipeline);
+      commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.pipelineLayout, 1, 1, &pipeline.descriptorSets[frame], 0, nullptr);
+      boundPipelineIdx = object.pipelineIdx;
+    }
+
+    DrawConstants constants{static_cast<uint32_t>(i), object.materialIdx, texture.index};
+
+    commandBuffer.pushConstants(pipeline.pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(DrawConstants), &constants);
+    commandBuffer.bindVertexBuffers(0, 1, &mesh.vertexBuffer.buffer, offsets);
+    commandBuffer.bindIndexBuffer(mesh.indexBuffer.buffer, 0, vk::IndexType::eUint16);
+
+    if (phase.drawBuffer) {
+      commandBuffer.drawIndexedIndirect(phase.drawBuffer, (phase.firstDraw + i) * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
+    } else {
+      commandBuffer.drawIndexed(mesh.indicesCount, 1, 0, 0, 1);
+    }
+  }
+
+  commandBuffer.endRendering();
+}
+
 void VkEngine::processInput(float deltaTime) {
+  framePacer.inputSampled(presentId + 1);
+
   SDL_Event event;
   while(SDL_PollEvent(&event)) {
     if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) {
@@ -284,68 +676,85 @@ void VkEngine::processInput(float deltaTime) {
       break;
     }
     if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
-      shouldBeResized = true;
+      shouldRebuildSwapchain = true;
+    }
+    if (event.type == SDL_KEYDOWN) {
+      switch (event.key.keysym.sym) {
+        case SDLK_F1:
+          setPresentMode(vk::PresentModeKHR::eFifo);
+          break;
+        case SDLK_F2:
+          setPresentMode(vk::PresentModeKHR::eFifoRelaxed);
+          break;
+        case SDLK_F3:
+          setPresentMode(vk::PresentModeKHR::eMailbox);
+          break;
+        case SDLK_F4:
+          setPresentMode(vk::PresentModeKHR::eImmediate);
+          break;
+        case SDLK_F5:
+          settings.depthPrepass = !settings.depthPrepass;
+          break;
+        case SDLK_F6:
+          settings.occlusionCulling = !settings.occlusionCulling;
+          break;
+        case SDLK_F7:
+          settings.dynamicResolution = !settings.dynamicResolution;
+          break;
+        case SDLK_F8:
+          writeMemoryReport(settings.memoryReportPath);
+          break;
+        default:
+          break;
+      }
     }
     if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_RIGHT) {
       SDL_SetRelativeMouseMode(SDL_TRUE);
       SDL_SetWindowGrab(display.window, SDL_TRUE);
       camera.mode = CameraMode::Move; 
+      simulation.setCameraMode(camera.mode);
     }
     if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_RIGHT) {
       SDL_SetRelativeMouseMode(SDL_FALSE);
       SDL_SetWindowGrab(display.window, SDL_FALSE);
       camera.mode = CameraMode::Fixed; 
-    }
-    if (event.type == SDL_KEYDOWN && camera.mode == CameraMode::Move) {
-      switch (event.key.keysym.sym) {
-        case SDLK_w:
-          camera.pos += camera.front * camera.velocity * deltaTime;
-          break;
-        case SDLK_s:
-          camera.pos -= camera.front * camera.velocity * deltaTime;
-          break;
-        case SDLK_a:
-          camera.pos -= camera.right * camera.velocity * deltaTime;
-          break;
-        case SDLK_d:
-          camera.pos += camera.right * camera.velocity * deltaTime;
-          break;
-        default:
-          break;
-      }
+      simulation.setCameraMode(camera.mode);
     }
     if (event.type == SDL_MOUSEMOTION && camera.mode == CameraMode::Move) {
-      camera.yaw += event.motion.xrel * camera.sensitivity;
-      camera.pitch += -event.motion.yrel * camera.sensitivity;
+      simulation.addMouseMotion(event.motion.xrel, event.motion.yrel);
+    }
+  }
 
-      camera.pitch = std::clamp(camera.pitch, -90.0f, 90.0f);
+  // Movement follows held keys rather than key repeat events, the simulation thread integrates it
+  const Uint8* keyboard = SDL_GetKeyboardState(nullptr);
+  uint32_t keys = 0;
 
-      glm::vec3 front{0.0f};
+  keys |= keyboard[SDL_SCANCODE_W] ? SIMULATION_KEY_FORWARD : 0;
+  keys |= keyboard[SDL_SCANCODE_S] ? SIMULATION_KEY_BACK : 0;
+  keys |= keyboard[SDL_SCANCODE_A] ? SIMULATION_KEY_LEFT : 0;
+  keys |= keyboard[SDL_SCANCODE_D] ? SIMULATION_KEY_RIGHT : 0;
 
-      front.x = glm::cos(glm::radians(camera.yaw)) * glm::cos(glm::radians(camera.pitch));
-      front.y = glm::sin(glm::radians(camera.pitch));
-      front.z = glm::sin(glm::radians(camera.yaw)) * glm::cos(glm::radians(camera.pitch));
-      
-      camera.front = glm::normalize(front);
-      camera.right = glm::normalize(glm::cross(camera.front, camera.up));
-    }
-  }
+  simulation.setKeys(keys);
 };
 
 void VkEngine::destroy() {
   vk::Device d = device.device;
 
+  simulation.stop();
+  shaderReloader.stop();
+  jobs.stop();
   d.waitIdle();
 
-  for (size_t i = 0; i < MAX_CONCURRENT_FRAMES; i++) {
+  // Deferred entries reference engine owned tables and allocators, so they run before any of those is destroyed
+  deletionQueue.flushAll();
+  textureStreamer.destroy(allocator);
+
+  for (size_t i = 0; i < settings.framesInFlight; i++) {
     d.destroyFence(fences[i]);
-    d.destroySemaphore(renderCompleteSemaphores[i]);
     d.destroySemaphore(presentCompleteSemaphores[i]);
   }
 
-  for (Object& object : objects) {
-    object.destroy(allocator);
-  }
+  objectBuffer.destroy(allocator);
 
   for (Texture& texture : textures) {
     texture.destroy(allocator, d);
@@ -360,18 +769,35 @@ void VkEngine::destroy() {
   }
 
   light.destroy(allocator);
+  clusteredLights.destroy(allocator, d);
+  shadowMap.destroy(allocator, d);
+  depthPrepass.destroy(d);
+  occlusionCulling.destroy(allocator, d);
+  d.destroyQueryPool(statisticsQueryPool);
+  d.destroyQueryPool(timestampQueryPool);
+
+  renderGraph.destroy();
   
   destroySwapchainResources();
 
+  for (const RetiredSwapchain& retired : retiredSwapchains) {
+    destroyRetiredSwapchain(retired);
+  }
+
   d.destroySampler(sampler);
   d.destroyCommandPool(commandPool);
 
+  bindlessTextures.destroy(d);
+
   d.destroyDescriptorSetLayout(objectSetLayout);
-  d.destroyDescriptorSetLayout(textureSetLayout);
   d.destroyDescriptorSetLayout(descriptorSetLayout);
   d.destroyDescriptorSetLayout(lightSetLayout);
 
-  d.destroyDescriptorPool(descriptorPool);
+  descriptorAllocator.destroy(d);
+
+  for (DescriptorAllocator& frameDescriptorAllocator : frameDescriptorAllocators) {
+    frameDescriptorAllocator.destroy(d);
+  }
 
   vkb::destroy_swapchain(swapchain);
   vkb::destroy_surface(instance, surface);
@@ -383,6 +809,8 @@ void VkEngine::destroy() {
 };
 
 void VkEngine::createInstance() {
+  TRACE_FUNCTION();
+
   vkb::Result<vkb::Instance> instanceResult = vkb::InstanceBuilder{}
     .set_app_name("VkRenderer")
     .require_api_version(1, 3)
@@ -400,6 +828,8 @@ void VkEngine::createInstance() {
 };
 
 void VkEngine::pickPhysicalDevice() {
+  TRACE_FUNCTION();
+
   surface = display.createVulkanSurface(instance.instance);
 
   vkb::Result<vkb::PhysicalDevice> physicalDeviceResult = vkb::PhysicalDeviceSelector{instance}
@@ -408,6 +838,14 @@ void VkEngine::pickPhysicalDevice() {
     .require_present(true)
     .add_required_extension_features(vk::PhysicalDeviceDynamicRenderingFeatures{}.setDynamicRendering(1))
     .add_required_extension_features(vk::PhysicalDeviceSynchronization2Features{}.setSynchronization2(1))
+    .add_required_extension_features(
+      vk::PhysicalDeviceDescriptorIndexingFeatures{}
+        .setRuntimeDescriptorArray(1)
+        .setDescriptorBindingPartiallyBound(1)
+        .setDescriptorBindingVariableDescriptorCount(1)
+        .setDescriptorBindingSampledImageUpdateAfterBind(1)
+        .setDescriptorBindingUpdateUnusedWhilePending(1)
+    )
     .select();
 
   if (!physicalDeviceResult) {
@@ -415,9 +853,21 @@ void VkEngine::pickPhysicalDevice() {
   }
 
   physicalDevice = physicalDeviceResult.value();
-};
+
+  presentWaitSupported =
+    physicalDevice.enable_extension_if_present(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+    physicalDevice.enable_extension_if_present(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) &&
+    physicalDevice.enable_extension_features_if_present(vk::PhysicalDevicePresentIdFeaturesKHR{}.setPresentId(1)) &&
+    physicalDevice.enable_extension_features_if_present(vk::PhysicalDevicePresentWaitFeaturesKHR{}.setPresentWait(1));
+
+  memoryBudgetSupported = physicalDevice.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+  statisticsSupported = physicalDevice.enable_features_if_present(vk::PhysicalDeviceFeatures{}.setPipelineStatisticsQuery(1));
+};
 
 void VkEngine::pickDevice() {
+  TRACE_FUNCTION();
+
   vkb::Result<vkb::Device> deviceResult = vkb::DeviceBuilder{physicalDevice}
     .build();
 
@@ -426,9 +876,16 @@ void VkEngine::pickDevice() {
   }
 
   device = deviceResult.value();
+
+  if (presentWaitSupported) {
+    vkWaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(device.fp_vkGetDeviceProcAddr(device.device, "vkWaitForPresentKHR"));
+    presentWaitSupported = vkWaitForPresent != nullptr;
+  }
 };
 
 void VkEngine::createAllocator() {
+  TRACE_FUNCTION();
+
   VmaVulkanFunctions vulkanFunctions{};
   vulkanFunctions.vkGetDeviceProcAddr = instance.fp_vkGetDeviceProcAddr;
   vulkanFunctions.vkGetInstanceProcAddr = instance.fp_vkGetInstanceProcAddr;
@@ -438,13 +895,25 @@ void VkEngine::createAllocator() {
   createInfo.instance = instance.instance;
   createInfo.physicalDevice = physicalDevice.physical_device;
   createInfo.device = device.device;
+
+  if (memoryBudgetSupported) {
+    createInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+  }
  
   if (vmaCreateAllocator(&createInfo, &allocator) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to create a VmaAllocator"};
   };
 };
 
+void VkEngine::createRenderGraph() {
+  TRACE_FUNCTION();
+
+  renderGraph = RenderGraph{allocator, vk::Device{device}, settings.framesInFlight};
+}
+
 void VkEngine::createSwapchain() {
+  TRACE_FUNCTION();
+
   int w, h;
   SDL_GetWindowSize(display.window, &w, &h);
 
@@ -452,7 +921,7 @@ void VkEngine::createSwapchain() {
     .setWidth(w)
     .setHeight(h);
 
-  swapchain = utils::createSwapchain(device, extent, MAX_CONCURRENT_FRAMES, &swapchain);
+  swapchain = utils::createSwapchain(device, extent, settings.swapchainImageCount, settings.presentMode, &swapchain);
   
   vkb::Result<std::vector<VkImageView>> imageViewsResult = swapchain.get_image_views();
   vkb::Result<std::vector<VkImage>> imagesResult = swapchain.get_images();
@@ -467,13 +936,25 @@ void VkEngine::createSwapchain() {
 
   swapchainImageViews = imageViewsResult.value();
   swapchainImages = imagesResult.value();
+
+  vk::Device d = device.device;
+
+  renderCompleteSemaphores.resize(swapchainImages.size());
+
+  for (size_t i = 0; i < swapchainImages.size(); i++) {
+    renderCompleteSemaphores[i] = d.createSemaphore(vk::SemaphoreCreateInfo{});
+  }
 }
 
 void VkEngine::createDepthImage() {
-  depthImage = Image{allocator, device.device, commandPool, queue, vk::Extent3D{swapchain.extent}.setDepth(1), vk::Format::eD32Sfloat, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth};
+  TRACE_FUNCTION();
+
+  depthImage = Image{allocator, device.device, commandPool, queue, vk::Extent3D{swapchain.extent}.setDepth(1), vk::Format::eD32Sfloat, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eDepth};
 }
 
 void VkEngine::createViewportAndScissors() {
+  TRACE_FUNCTION();
+
   vk::Extent3D extent = vk::Extent3D{}
     .setDepth(0)
     .setHeight(swapchain.extent.height)
@@ -486,6 +967,8 @@ void VkEngine::createViewportAndScissors() {
 };
 
 void VkEngine::createQueue() {
+  TRACE_FUNCTION();
+
   vkb::Result<uint32_t> queueIndexResult = device.get_queue_index(vkb::QueueType::graphics);
 
   if (!queueIndexResult) {
@@ -503,20 +986,23 @@ void VkEngine::createQueue() {
 };
 
 void VkEngine::createSyncPrimitives() {
-  fences.resize(MAX_CONCURRENT_FRAMES);
-  renderCompleteSemaphores.resize(MAX_CONCURRENT_FRAMES);
-  presentCompleteSemaphores.resize(MAX_CONCURRENT_FRAMES);
+  TRACE_FUNCTION();
+
+  fences.resize(settings.framesInFlight);
+  presentCompleteSemaphores.resize(settings.framesInFlight);
+  frameSerials.resize(settings.framesInFlight, 0);
 
   vk::Device d = device.device;
 
-  for (size_t i = 0; i < MAX_CONCURRENT_FRAMES; i++) {
+  for (size_t i = 0; i < settings.framesInFlight; i++) {
     fences[i] = d.createFence(vk::FenceCreateInfo{}.setFlags(vk::FenceCreateFlagBits::eSignaled));
-    renderCompleteSemaphores[i] = d.createSemaphore(vk::SemaphoreCreateInfo{});
     presentCompleteSemaphores[i] = d.createSemaphore(vk::SemaphoreCreateInfo{});
   }
 };
 
 void VkEngine::createCommandPool() {
+  TRACE_FUNCTION();
+
   vk::CommandPoolCreateInfo commandPoolCreateInfo = vk::CommandPoolCreateInfo{}
     .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
     .setQueueFamilyIndex(queueIndex);
@@ -527,12 +1013,14 @@ void VkEngine::createCommandPool() {
 };
 
 void VkEngine::createCommandBuffers() {
-  commadBuffers.resize(MAX_CONCURRENT_FRAMES);  
+  TRACE_FUNCTION();
+
+  commadBuffers.resize(settings.framesInFlight);  
   vk::Device d = device.device;
 
   vk::CommandBufferAllocateInfo commandBufferAllocateInfo = vk::CommandBufferAllocateInfo{}
     .setCommandPool(commandPool)
-    .setCommandBufferCount(MAX_CONCURRENT_FRAMES)
+    .setCommandBufferCount(settings.framesInFlight)
     .setLevel(vk::CommandBufferLevel::ePrimary);
   
   if (d.allocateCommandBuffers(&commandBufferAllocateInfo, commadBuffers.data()) != vk::Result::eSuccess) {
@@ -541,7 +1029,219 @@ void VkEngine::createCommandBuffers() {
 };
 
 
+void VkEngine::createClusteredLights() {
+  TRACE_FUNCTION();
+
+  clusteredLights = ClusteredLights{allocator, vk::Device{device}, settings.framesInFlight, lightSetLayout};
+}
+
+void VkEngine::createShadowMap() {
+  TRACE_FUNCTION();
+
+  shadowMap = ShadowMap{allocator, vk::Device{device}, 1024, {bindlessTextures.descriptorSetLayout, descriptorSetLayout, objectSetLayout}};
+}
+
+void VkEngine::createTextureStreamer() {
+  TRACE_FUNCTION();
+
+  textureStreamer = TextureStreamer{static_cast<uint64_t>(settings.textureBudget) * 1024 * 1024};
+}
+
+void VkEngine::mountAssetArchive() {
+  TRACE_FUNCTION();
+
+  if (!settings.archivePath.empty()) {
+    assetArchive = AssetArchive{settings.archivePath};
+    assetReader.start();
+  }
+}
+
+// Assets missing from the archive come back empty and are loaded from loose files instead
+std::vector<std::vector<char>> VkEngine::readAssets(const std::vector<std::string_view>& paths) {
+  TRACE_FUNCTION();
+
+  std::vector<std::vector<char>> contents(paths.size());
+  std::vector<ReadRequest> requests;
+
+  if (!assetArchive.isOpen()) {
+    return contents;
+  }
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    const AssetArchiveEntry* entry = assetArchive.find(paths[i]);
+
+    if (!entry) {
+      continue;
+    }
+
+    contents[i].resize(entry->size);
+    requests.push_back(ReadRequest{assetArchive.descriptor(), entry->offset, entry->size, contents[i].data()});
+  }
+
+  // Every read is queued at once so the disk sees one deep queue instead of a chain of open/read/close
+  assetReader.read(requests);
+
+  return contents;
+}
+
+// The render thread is worker 0, so it keeps working through its own jobs whenever it waits on them
+void VkEngine::createJobSystem() {
+  TRACE_FUNCTION();
+
+  jobs.start(settings.workerThreads);
+}
+
+void VkEngine::createSimulation() {
+  TRACE_FUNCTION();
+
+  simulation.start(camera, settings.simulationRate);
+}
+
+void VkEngine::applySimulation() {
+  TRACE_FUNCTION();
+
+  const SimulationSnapshot& snapshot = simulation.latest();
+
+  // Ticks rarely line up with frames, so the camera is blended across the last tick to avoid judder
+  float blend = simulation.blend(snapshot);
+  CameraMode mode = camera.mode;
+
+  camera = blendCamera(snapshot.previousCamera, snapshot.camera, blend);
+  camera.mode = mode;
+
+  if (snapshot.tick == appliedSimulationTick) {
+    return;
+  }
+
+  for (const SimulatedBody& body : snapshot.bodies) {
+    if (body.revision > appliedSimulationTick && scene.valid(body.handle)) {
+      scene.setTransform(body.handle, body.transform);
+    }
+  }
+
+  appliedSimulationTick = snapshot.tick;
+}
+
+void VkEngine::createShaderReloader() {
+  TRACE_FUNCTION();
+
+  shaderReloader.start(vk::Device{device}, "./shaders");
+
+  for (uint32_t i = 0; i < pipelines.size(); i++) {
+    shaderReloader.watch(i, pipelines[i]);
+  }
+
+  shaderReloader.watch(ShaderPass::Shadow, {"./shaders/shadow.vert.spv", "./shaders/shadow.frag.spv"});
+  shaderReloader.watch(ShaderPass::DepthPrepass, {"./shaders/depth.vert.spv"});
+  shaderReloader.watch(ShaderPass::OcclusionCulling, {"./shaders/hiz-reduce.comp.spv", "./shaders/occlusion-cull.comp.spv"});
+  shaderReloader.watch(ShaderPass::ClusteredLights, {"./shaders/cluster-lights.comp.spv"});
+}
+
+void VkEngine::applyShaderReloads() {
+  vk::Device d = device.device;
+
+  for (ShaderReload& reload : shaderReloader.take()) {
+    Pipeline& pipeline = pipelines[reload.pipelineIdx];
+
+    if (!pipeline.graphicsPipeline) {
+      d.destroyPipeline(reload.graphicsPipeline);
+      reload.vertexShader.destroy(d);
+      reload.fragmentShader.destroy(d);
+      continue;
+    }
+
+    // Recorded frames still reference the old pipeline until their fences signal
+    vk::Pipeline oldPipeline = pipeline.graphicsPipeline;
+    Shader oldVertexShader = pipeline.vertexShader;
+    Shader oldFragmentShader = pipeline.fragmentShader;
+
+    deletionQueue.push(submitSerial, [d, oldPipeline, oldVertexShader, oldFragmentShader]() mutable {
+      d.destroyPipeline(oldPipeline);
+      oldVertexShader.destroy(d);
+      oldFragmentShader.destroy(d);
+    });
+
+    pipeline.graphicsPipeline = reload.graphicsPipeline;
+    pipeline.vertexShader = reload.vertexShader;
+    pipeline.fragmentShader = reload.fragmentShader;
+  }
+
+  // The fixed passes are few and cheap to build, so they are rebuilt here rather than on the watcher thread
+  std::vector<vk::DescriptorSetLayout> passSetLayouts{bindlessTextures.descriptorSetLayout, descriptorSetLayout, objectSetLayout};
+
+  for (ShaderPass pass : shaderReloader.takePasses()) {
+    try {
+      switch (pass) {
+        case ShaderPass::Shadow:
+          shadowMap.reloadPipeline(d, passSetLayouts, deletionQueue, submitSerial);
+          break;
+        case ShaderPass::DepthPrepass:
+          depthPrepass.reloadPipeline(d, passSetLayouts, deletionQueue, submitSerial);
+          break;
+        case ShaderPass::OcclusionCulling:
+          occlusionCulling.reloadPipelines(d, deletionQueue, submitSerial);
+          break;
+        case ShaderPass::ClusteredLights:
+          clusteredLights.reloadPipeline(d, lightSetLayout, deletionQueue, submitSerial);
+          break;
+      }
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "Failed to reload pass shaders: %s\n", e.what());
+    }
+  }
+}
+
+void VkEngine::createDepthPrepass() {
+  TRACE_FUNCTION();
+
+  depthPrepass = DepthPrepass{vk::Device{device}, {bindlessTextures.descriptorSetLayout, descriptorSetLayout, objectSetLayout}};
+}
+
+void VkEngine::createOcclusionCulling() {
+  TRACE_FUNCTION();
+
+  occlusionCulling = OcclusionCulling{allocator, vk::Device{device}, settings.framesInFlight, objectSetLayout, depthImage.view, swapchain.extent};
+}
+
+void VkEngine::createQueryPool() {
+  TRACE_FUNCTION();
+
+  vk::Device d = vk::Device{device};
+
+  if (statisticsSupported) {
+    vk::QueryPoolCreateInfo queryPoolCreateInfo = vk::QueryPoolCreateInfo{}
+      .setQueryType(vk::QueryType::ePipelineStatistics)
+      .setQueryCount(settings.framesInFlight)
+      .setPipelineStatistics(vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations);
+
+    statisticsQueryPool = d.createQueryPool(queryPoolCreateInfo, nullptr);
+    statisticsPending.resize(settings.framesInFlight, false);
+  }
+
+  timestampsSupported = physicalDevice.properties.limits.timestampComputeAndGraphics;
+  timestampPeriod = physicalDevice.properties.limits.timestampPeriod;
+
+  if (timestampsSupported) {
+    vk::QueryPoolCreateInfo queryPoolCreateInfo = vk::QueryPoolCreateInfo{}
+      .setQueryType(vk::QueryType::eTimestamp)
+      .setQueryCount(settings.framesInFlight * 2);
+
+    timestampQueryPool = d.createQueryPool(queryPoolCreateInfo, nullptr);
+    timestampsPending.resize(settings.framesInFlight, false);
+  }
+}
+
+void VkEngine::createObjectBuffer() {
+  TRACE_FUNCTION();
+
+  objectBuffer = ObjectBuffer{allocator, settings.framesInFlight};
+
+  materials.push_back(Material{});
+}
+
 void VkEngine::createPipelines() {
+  TRACE_FUNCTION();
+
   vk::Device d = vk::Device{device};
 
   pipelines.push_back(
@@ -552,9 +1252,9 @@ void VkEngine::createPipelines() {
       d,
       viewport,
       scissors,
-      MAX_CONCURRENT_FRAMES,
-      descriptorPool,
-      {textureSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
+      settings.framesInFlight,
+      descriptorAllocator,
+      {bindlessTextures.descriptorSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
     }
   );
 
@@ -566,9 +1266,9 @@ void VkEngine::createPipelines() {
       d,
       viewport,
       scissors,
-      MAX_CONCURRENT_FRAMES,
-      descriptorPool,
-      {textureSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
+      settings.framesInFlight,
+      descriptorAllocator,
+      {bindlessTextures.descriptorSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
     }
   );
 
@@ -580,9 +1280,9 @@ void VkEngine::createPipelines() {
       d,
       viewport,
       scissors,
-      MAX_CONCURRENT_FRAMES,
-      descriptorPool,
-      {textureSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
+      settings.framesInFlight,
+      descriptorAllocator,
+      {bindlessTextures.descriptorSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
     }
   );
 
@@ -594,14 +1294,16 @@ void VkEngine::createPipelines() {
       d,
       viewport,
       scissors,
-      MAX_CONCURRENT_FRAMES,
-      descriptorPool,
-      {textureSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
+      settings.framesInFlight,
+      descriptorAllocator,
+      {bindlessTextures.descriptorSetLayout, descriptorSetLayout, objectSetLayout, lightSetLayout},
     }
   );
 };
 
 void VkEngine::createSampler() {
+  TRACE_FUNCTION();
+
   vk::SamplerCreateInfo samplerCreateInfo = vk::SamplerCreateInfo{}
     .setMagFilter(vk::Filter::eLinear)
     .setMinFilter(vk::Filter::eLinear)
@@ -610,40 +1312,52 @@ void VkEngine::createSampler() {
     .setAddressModeV(vk::SamplerAddressMode::eRepeat)
     .setAddressModeW(vk::SamplerAddressMode::eRepeat)
     .setAnisotropyEnable(0)
-    .setCompareEnable(0);
+    .setCompareEnable(0)
+    .setMinLod(0.0f)
+    .setMaxLod(VK_LOD_CLAMP_NONE);
 
   sampler = vk::Device{device}.createSampler(samplerCreateInfo);
 }
 
-void VkEngine::createDescriptorPool() {
-  vk::DescriptorPoolSize samplerPool = vk::DescriptorPoolSize{}
-    .setDescriptorCount(MAX_CONCURRENT_FRAMES * 64)
-    .setType(vk::DescriptorType::eCombinedImageSampler);
+void VkEngine::createBindlessTextures() {
+  TRACE_FUNCTION();
 
-  vk::DescriptorPoolSize uniformPool = vk::DescriptorPoolSize{}
-    .setDescriptorCount(MAX_CONCURRENT_FRAMES * 64)
-    .setType(vk::DescriptorType::eUniformBuffer);
+  vk::PhysicalDevice pd = physicalDevice.physical_device;
 
-  std::vector<vk::DescriptorPoolSize> poolSizes{
-    samplerPool,
-    uniformPool
-  };
+  vk::StructureChain<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties> properties = pd.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>();
+  const vk::PhysicalDeviceDescriptorIndexingProperties& limits = properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+
+  uint32_t capacity = std::min({
+    MAX_BINDLESS_TEXTURES,
+    limits.maxDescriptorSetUpdateAfterBindSampledImages,
+    limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+    limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+  });
 
-  vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo = vk::DescriptorPoolCreateInfo{}
-    .setMaxSets(MAX_CONCURRENT_FRAMES * 64)
-    .setPoolSizes(poolSizes)
-    .setPoolSizeCount(poolSizes.size());
+  bindlessTextures = BindlessTextures{vk::Device{device}, capacity};
+}
 
-  descriptorPool = vk::Device{device}.createDescriptorPool(descriptorPoolCreateInfo, nullptr);
+void VkEngine::createDescriptorAllocators() {
+  TRACE_FUNCTION();
 
   vk::Device d = vk::Device{device};
 
-  vk::DescriptorSetLayoutBinding samplerBinding = vk::DescriptorSetLayoutBinding{}
-    .setBinding(0)
-    .setDescriptorCount(1)
-    .setStageFlags(vk::ShaderStageFlagBits::eAllGraphics)
-    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-    .setImmutableSamplers(sampler);
+  std::vector<PoolSizeRatio> ratios{
+    {vk::DescriptorType::eUniformBuffer, 1.0f},
+    {vk::DescriptorType::eStorageBuffer, 1.0f},
+  };
+
+  std::vector<PoolSizeRatio> frameRatios{
+    {vk::DescriptorType::eUniformBuffer, 2.0f},
+    {vk::DescriptorType::eStorageBuffer, 4.0f},
+    {vk::DescriptorType::eCombinedImageSampler, 1.0f},
+  };
+
+  descriptorAllocator = DescriptorAllocator{d, 16, ratios};
+
+  for (size_t i = 0; i < settings.framesInFlight; i++) {
+    frameDescriptorAllocators.push_back(DescriptorAllocator{d, 16, frameRatios});
+  }
 
   vk::DescriptorSetLayoutBinding projectionBidning = vk::DescriptorSetLayoutBinding{}
     .setBinding(0)
@@ -654,8 +1368,19 @@ void VkEngine::createDescriptorPool() {
   vk::DescriptorSetLayoutBinding objectBidning = vk::DescriptorSetLayoutBinding{}
     .setBinding(0)
     .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eAllGraphics | vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer);
+
+  vk::DescriptorSetLayoutBinding materialBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(1)
+    .setDescriptorCount(1)
     .setStageFlags(vk::ShaderStageFlagBits::eAllGraphics)
-    .setDescriptorType(vk::DescriptorType::eUniformBuffer);
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer);
+
+  std::vector<vk::DescriptorSetLayoutBinding> objectBindings{
+    objectBidning,
+    materialBinding,
+  };
 
   vk::DescriptorSetLayoutBinding lightBinding = vk::DescriptorSetLayoutBinding{}
     .setBinding(0)
@@ -663,88 +1388,418 @@ void VkEngine::createDescriptorPool() {
     .setStageFlags(vk::ShaderStageFlagBits::eAllGraphics)
     .setDescriptorType(vk::DescriptorType::eUniformBuffer);
 
-  vk::DescriptorSetLayoutCreateInfo textureSetLayoutCreateInfo = vk::DescriptorSetLayoutCreateInfo{}
-    .setBindings(samplerBinding)
-    .setBindingCount(1);
+  vk::DescriptorSetLayoutBinding clusterParamsBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(1)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eUniformBuffer);
+
+  vk::DescriptorSetLayoutBinding pointLightsBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(2)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer);
+
+  vk::DescriptorSetLayoutBinding clustersBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(3)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute)
+    .setDescriptorType(vk::DescriptorType::eStorageBuffer);
+
+  vk::DescriptorSetLayoutBinding shadowMapBinding = vk::DescriptorSetLayoutBinding{}
+    .setBinding(4)
+    .setDescriptorCount(1)
+    .setStageFlags(vk::ShaderStageFlagBits::eFragment)
+    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+
+  std::vector<vk::DescriptorSetLayoutBinding> lightBindings{
+    lightBinding,
+    clusterParamsBinding,
+    pointLightsBinding,
+    clustersBinding,
+    shadowMapBinding,
+  };
 
   vk::DescriptorSetLayoutCreateInfo objectSetLayoutCreateInfo = vk::DescriptorSetLayoutCreateInfo{}
-    .setBindings(objectBidning)
-    .setBindingCount(1);
+    .setBindings(objectBindings)
+    .setBindingCount(objectBindings.size());
 
   vk::DescriptorSetLayoutCreateInfo lightSetLayoutCreateInfo = vk::DescriptorSetLayoutCreateInfo{}
-    .setBindings(lightBinding)
-    .setBindingCount(1);
+    .setBindings(lightBindings)
+    .setBindingCount(lightBindings.size());
 
   vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = vk::DescriptorSetLayoutCreateInfo{}
     .setBindings(projectionBidning)
     .setBindingCount(1);
 
-  textureSetLayout = d.createDescriptorSetLayout(textureSetLayoutCreateInfo, nullptr);
   descriptorSetLayout = d.createDescriptorSetLayout(descriptorSetLayoutCreateInfo, nullptr);
   objectSetLayout = d.createDescriptorSetLayout(objectSetLayoutCreateInfo, nullptr);
   lightSetLayout = d.createDescriptorSetLayout(lightSetLayoutCreateInfo, nullptr);
 }
 
+const FrameStats& VkEngine::frameStats() const {
+  return framePacer.stats();
+}
+
+void VkEngine::resetFrameStats() {
+  framePacer.resetStats();
+}
+
+const ShadowStats& VkEngine::shadowStats() const {
+  return shadowMap.stats;
+}
+
+const RenderStats& VkEngine::renderStats() const {
+  return lastRenderStats;
+}
+
+MemoryReport VkEngine::memoryReport() const {
+  return memory::report(allocator);
+}
+
+std::string VkEngine::memoryReportJson(const bool detailed) const {
+  return memory::reportJson(allocator, detailed);
+}
+
+void VkEngine::writeMemoryReport(const std::string_view path) const {
+  std::string json = memoryReportJson(true);
+  std::ofstream file{path.data(), std::ios::out | std::ios::trunc};
+
+  if (!file.is_open()) {
+    throw std::runtime_error{std::string{"Failed to open file: "} + path.data()};
+  }
+
+  file.write(json.data(), json.size());
+}
+
 void VkEngine::setProjection(const Projection& p) {
   projection = p;
+  shadowMap.dirty = true;
+}
+
+void VkEngine::setPresentMode(const vk::PresentModeKHR presentMode) {
+  if (settings.presentMode == presentMode) {
+    return;
+  }
+
+  settings.presentMode = presentMode;
+  shouldRebuildSwapchain = true;
 }
 
 void VkEngine::setLight(const glm::vec3& pos, const glm::vec3 color, const float ambient) {
-  Light l{
-    allocator,
-    vk::Device{device},
-    MAX_CONCURRENT_FRAMES,
-    descriptorPool,
-    objectSetLayout,
-  };
+  Light l{allocator};
   
   l.properties.pos = pos;
   l.properties.color = color;
   l.properties.ambient = ambient;
+  l.properties.shadowFar = shadowMap.far;
 
-  UniformBuffer ubo{};
+  Transform transform{};
 
-  ubo.translation = glm::translate(ubo.translation, pos);
-  ubo.color = glm::vec3{1.0};
-  ubo.scale = glm::scale(ubo.scale, glm::vec3{0.5});
+  transform.position = pos;
+  transform.scale = glm::vec3{0.5};
 
-  addObject(ubo, 0, 0, 0);
+  lightMarker = addObject(transform, glm::vec3{1.0}, 0, 0, 0);
+  scene.get(lightMarker).castsShadow = false;
   
   light = l;
+  shadowMap.dirty = true;
 }
 
-void VkEngine::addObject(const UniformBuffer& uniform, const uint32_t meshIdx, const uint32_t textureIdx, const uint32_t pipelineIdx) {
-  Object object{
-    allocator,
-    vk::Device{device},
-    MAX_CONCURRENT_FRAMES,
-    descriptorPool,
-    objectSetLayout,
-  };
+void VkEngine::moveLight(const glm::vec3& pos) {
+  if (light.properties.pos == pos) {
+    return;
+  }
+
+  light.properties.pos = pos;
+
+  Transform transform = scene.transform(lightMarker);
+  transform.position = pos;
+  scene.setTransform(lightMarker, transform);
+
+  shadowMap.dirty = true;
+}
+
+uint32_t VkEngine::addPointLight(const PointLight& pointLight) {
+  pointLights.push_back(pointLight);
+  return pointLights.size() - 1;
+}
+
+ObjectHandle VkEngine::addObject(const Transform& transform, const glm::vec3& color, const uint32_t meshIdx, const uint32_t textureIdx, const uint32_t pipelineIdx, const uint32_t materialIdx) {
+  Object object{};
   
-  object.uniform = uniform;
+  object.color = color;
   object.textureIdx = textureIdx;
   object.meshIdx = meshIdx;
   object.pipelineIdx = pipelineIdx;
+  object.materialIdx = materialIdx;
 
-  objects.push_back(object);
+  return scene.add(object, transform);
 }
 
-void VkEngine::loadMesh(const std::string_view path) {
-  meshes.push_back(Mesh{allocator, path});
+void VkEngine::removeObject(const ObjectHandle handle) {
+  simulation.remove(handle);
+  scene.remove(handle);
 }
 
-void VkEngine::loadTexture(const std::string_view path) {
-  Image image{allocator, vk::Device{device}, commandPool, queue, path, vk::ImageLayout::eShaderReadOnlyOptimal};
+// Applied right away so the next frame shows it, the simulation then carries it forward
+void VkEngine::setTransform(const ObjectHandle handle, const Transform& transform) {
+  simulation.setTransform(handle, transform);
+  scene.setTransform(handle, transform);
+}
 
-  textures.push_back(
-    Texture{
-      sampler,
-      vk::Device{device},
-      descriptorPool,
-      image,
-      MAX_CONCURRENT_FRAMES,
-      textureSetLayout,
+void VkEngine::setMotion(const ObjectHandle handle, const glm::vec3& velocity, const glm::vec3& angularVelocity) {
+  simulation.setMotion(handle, scene.transform(handle), velocity, angularVelocity);
+}
+
+uint32_t VkEngine::addMaterial(const Material& material) {
+  materials.push_back(material);
+  return materials.size() - 1;
+}
+
+void VkEngine::loadScene(const std::string_view path) {
+  TRACE_FUNCTION();
+
+  SceneFile sceneFile{path};
+  const SceneFileHeader& header = sceneFile.header();
+
+  const SceneFileObject* sceneObjects = sceneFile.objects();
+
+  for (uint32_t i = 0; i < header.objectCount; i++) {
+    if (sceneObjects[i].pipelineIdx >= pipelines.size() || !pipelines[sceneObjects[i].pipelineIdx].graphicsPipeline) {
+      throw std::runtime_error{std::string{"Scene object uses an unknown pipeline: "} + path.data()};
     }
-  );
+  }
+
+  std::vector<std::string_view> paths;
+
+  for (uint32_t i = 0; i < header.meshCount; i++) {
+    paths.push_back(sceneFile.meshPath(i));
+  }
+
+  for (uint32_t i = 0; i < header.textureCount; i++) {
+    paths.push_back(sceneFile.texturePath(i));
+  }
+
+  std::vector<std::vector<char>> contents = readAssets(paths);
+
+  std::vector<Mesh> loadedMeshes(header.meshCount);
+  std::vector<StreamedTexture> decodedTextures(header.textureCount);
+
+  // Parsing meshes and decoding images dominate load time and touch no engine state, only registering them is serial
+  try {
+    jobs.parallelFor(paths.size(), 1, [&](const uint32_t begin, const uint32_t end) {
+      for (uint32_t i = begin; i < end; i++) {
+        const std::vector<char>& content = contents[i];
+        std::string path{paths[i]};
+
+        if (i < header.meshCount) {
+          loadedMeshes[i] = content.empty() ? Mesh{allocator, path} : Mesh{allocator, content.data(), content.size(), path};
+        } else {
+          decodedTextures[i - header.meshCount] = content.empty() ? TextureStreamer::decode(path) : TextureStreamer::decode(content.data(), content.size(), path);
+        }
+      }
+    });
+  } catch (const std::exception&) {
+    for (Mesh& mesh : loadedMeshes) {
+      mesh.destroy(allocator);
+    }
+
+    throw;
+  }
+
+  std::vector<uint32_t> meshIndices;
+  std::vector<uint32_t> textureIndices;
+
+  for (uint32_t i = 0; i < header.meshCount; i++) {
+    meshIndices.push_back(storeMesh(loadedMeshes[i]));
+  }
+
+  for (uint32_t i = 0; i < header.textureCount; i++) {
+    uint32_t textureIdx = freeTextures.empty() ? textures.size() : freeTextures.back();
+    storeTexture(textureIdx, textureStreamer.add(allocator, vk::Device{device}, bindlessTextures, sampler, textureIdx, std::move(decodedTextures[i])));
+    textureIndices.push_back(textureIdx);
+  }
+
+  scene.reserve(scene.size() + header.objectCount);
+
+  for (uint32_t i = 0; i < header.objectCount; i++) {
+    const SceneFileObject& sceneObject = sceneObjects[i];
+
+    Object object{};
+    object.color = glm::vec3{sceneObject.color[0], sceneObject.color[1], sceneObject.color[2]};
+    object.meshIdx = meshIndices[sceneObject.meshIdx];
+    object.textureIdx = textureIndices[sceneObject.textureIdx];
+    object.pipelineIdx = sceneObject.pipelineIdx;
+
+    Transform transform{};
+    transform.position = glm::vec3{sceneObject.position[0], sceneObject.position[1], sceneObject.position[2]};
+    transform.rotation = glm::quat{sceneObject.rotation[0], sceneObject.rotation[1], sceneObject.rotation[2], sceneObject.rotation[3]};
+    transform.scale = glm::vec3{sceneObject.scale[0], sceneObject.scale[1], sceneObject.scale[2]};
+
+    scene.add(object, transform);
+  }
+
+  if (header.light.enabled) {
+    const SceneFileLight& l = header.light;
+    setLight(glm::vec3{l.pos[0], l.pos[1], l.pos[2]}, glm::vec3{l.color[0], l.color[1], l.color[2]}, l.ambient);
+  }
+}
+
+uint32_t VkEngine::loadMesh(const std::string_view path) {
+  TRACE_FUNCTION();
+
+  std::vector<char> content = std::move(readAssets({path})[0]);
+
+  if (!content.empty()) {
+    return loadMesh(path, content.data(), content.size());
+  }
+
+  return storeMesh(Mesh{allocator, path});
+}
+
+uint32_t VkEngine::loadMesh(const std::string_view name, const char* data, const size_t size) {
+  TRACE_FUNCTION();
+
+  return storeMesh(Mesh{allocator, data, size, name});
+}
+
+uint32_t VkEngine::storeMesh(const Mesh& mesh) {
+  if (!freeMeshes.empty()) {
+    uint32_t meshIdx = freeMeshes.back();
+    freeMeshes.pop_back();
+    meshes[meshIdx] = mesh;
+    return meshIdx;
+  }
+
+  meshes.push_back(mesh);
+  return meshes.size() - 1;
+}
+
+uint32_t VkEngine::loadTexture(const std::string_view path) {
+  TRACE_FUNCTION();
+
+  std::vector<char> content = std::move(readAssets({path})[0]);
+
+  if (!content.empty()) {
+    return loadTexture(path, content.data(), content.size());
+  }
+
+  uint32_t textureIdx = freeTextures.empty() ? textures.size() : freeTextures.back();
+
+  // Only the mip tail is uploaded here, the streamer brings in finer levels once objects need them
+  return storeTexture(textureIdx, textureStreamer.load(allocator, vk::Device{device}, bindlessTextures, sampler, textureIdx, path));
+}
+
+uint32_t VkEngine::loadTexture(const std::string_view name, const char* data, const size_t size) {
+  TRACE_FUNCTION();
+
+  uint32_t textureIdx = freeTextures.empty() ? textures.size() : freeTextures.back();
+  return storeTexture(textureIdx, textureStreamer.load(allocator, vk::Device{device}, bindlessTextures, sampler, textureIdx, data, size, name));
+}
+
+uint32_t VkEngine::storeTexture(const uint32_t textureIdx, const Texture& texture) {
+  std::vector<uint32_t>::iterator freeIt = std::find(freeTextures.begin(), freeTextures.end(), textureIdx);
+
+  if (freeIt != freeTextures.end()) {
+    freeTextures.erase(freeIt);
+    textures[textureIdx] = texture;
+    return textureIdx;
+  }
+
+  if (textureIdx != textures.size()) {
+    throw std::runtime_error{"Failed to store a texture in a slot that is still in use"};
+  }
+
+  textures.push_back(texture);
+  return textureIdx;
+}
+
+void VkEngine::unloadMesh(const uint32_t meshIdx) {
+  if (meshIdx >= meshes.size() || !meshes[meshIdx].vertexBuffer.buffer) {
+    throw std::runtime_error{"Failed to unload an unknown mesh"};
+  }
+
+  for (const Object& object : scene.objects) {
+    if (object.meshIdx == meshIdx) {
+      throw std::runtime_error{"Failed to unload a mesh that is still used by an object"};
+    }
+  }
+
+  // Frames in flight may still read the buffers, so they go once this frame's fence has signalled
+  Mesh mesh = meshes[meshIdx];
+  VmaAllocator vma = allocator;
+
+  deletionQueue.push(submitSerial, [vma, mesh]() mutable {
+    mesh.destroy(vma);
+  });
+
+  meshes[meshIdx] = Mesh{};
+  freeMeshes.push_back(meshIdx);
+}
+
+void VkEngine::unloadTexture(const uint32_t textureIdx) {
+  if (textureIdx >= textures.size() || !textures[textureIdx].image.image) {
+    throw std::runtime_error{"Failed to unload an unknown texture"};
+  }
+
+  for (const Object& object : scene.objects) {
+    if (object.textureIdx == textureIdx) {
+      throw std::runtime_error{"Failed to unload a texture that is still used by an object"};
+    }
+  }
+
+  // The bindless slot is only handed out again once no submitted frame can sample it. The table is an engine member,
+  // destroy() flushes the deletion queue before tearing it down
+  Texture texture = textures[textureIdx];
+  textureStreamer.unload(allocator, textureIdx);
+
+  VmaAllocator vma = allocator;
+  vk::Device d = device.device;
+  BindlessTextures* table = &bindlessTextures;
+
+  deletionQueue.push(submitSerial, [table, vma, d, texture]() mutable {
+    texture.destroy(vma, d);
+    table->release(texture.index);
+  });
+
+  textures[textureIdx] = Texture{};
+  freeTextures.push_back(textureIdx);
+}
+
+void VkEngine::unloadPipeline(const uint32_t pipelineIdx) {
+  if (pipelineIdx >= pipelines.size() || !pipelines[pipelineIdx].graphicsPipeline) {
+    throw std::runtime_error{"Failed to unload an unknown pipeline"};
+  }
+
+  if (pipelineIdx == 0) {
+    throw std::runtime_error{"Failed to unload the first pipeline, its layout binds the shared descriptor sets"};
+  }
+
+  for (const Object& object : scene.objects) {
+    if (object.pipelineIdx == pipelineIdx) {
+      throw std::runtime_error{"Failed to unload a pipeline that is still used by an object"};
+    }
+  }
+
+  shaderReloader.forget(pipelineIdx);
+
+  Pipeline& pipeline = pipelines[pipelineIdx];
+  Pipeline retired = pipeline;
+  vk::Device d{device};
+  VmaAllocator vma = allocator;
+  DescriptorAllocator* sets = &descriptorAllocator;
+
+  // The per frame projection sets are recycled once no frame binds them, destroy() flushes the queue before the allocator goes
+  deletionQueue.push(submitSerial, [d, vma, sets, retired]() mutable {
+    retired.destroy(vma, d);
+    sets->release(retired.descriptorSetLayouts[1], retired.descriptorSets);
+  });
+
+  pipeline.graphicsPipeline = nullptr;
+  pipeline.pipelineLayout = nullptr;
+  pipeline.vertexShader.module = nullptr;
+  pipeline.fragmentShader.module = nullptr;
+  pipeline.projection = Buffer{};
+  pipeline.descriptorSets.clear();
 }
@@ -9,38 +9,112 @@
 #include <VkBootstrap.h>
 
 #include "light.hpp"
+#include "clustered-lights.hpp"
+#include "shadow-map.hpp"
+#include "depth-prepass.hpp"
+#include "occlusion-culling.hpp"
 #include "vk-pipeline.hpp"
 #include "sdl-display.hpp"
 #include "scene.hpp"
 #include "object.hpp"
+#include "object-storage.hpp"
+#include "object-buffer.hpp"
+#include "material.hpp"
 #include "mesh.hpp"
 #include "texture.hpp"
+#include "bindless-textures.hpp"
+#include "texture-streamer.hpp"
+#include "descriptor-allocator.hpp"
+#include "deletion-queue.hpp"
+#include "memory-stats.hpp"
+#include "render-graph.hpp"
+#include "shader-reloader.hpp"
+#include "simulation.hpp"
+#include "job-system.hpp"
+#include "asset-archive.hpp"
+#include "async-reader.hpp"
+#include "settings.hpp"
+#include "frame-pacer.hpp"
+#include "resolution-scaler.hpp"
+
+struct RenderStats {
+  uint64_t fragmentInvocations = 0;
+  float overdraw = 0.0f;
+  float gpuTime = 0.0f;
+  float resolutionScale = 1.0f;
+  float textureMemory = 0.0f;
+  float textureBudget = 0.0f;
+};
+
+// A replaced swapchain is kept until a present on its successor completes, render fences say nothing about presentation
+struct RetiredSwapchain {
+  vkb::Swapchain swapchain;
+  std::vector<VkImageView> imageViews;
+  std::vector<vk::Semaphore> semaphores;
+  uint64_t presentId = 0;
+};
+
+struct ForwardPhase {
+  bool depthPrepassed = false;
+  bool late = false;
+  bool storeDepth = false;
+  vk::Buffer drawBuffer;
+  uint32_t firstDraw = 0;
+};
 
 class VkEngine {
 public:
   std::vector<Mesh> meshes;
   std::vector<Texture> textures;
-  std::vector<Object> objects;
+  ObjectStorage scene;
+  std::vector<Material> materials;
+  std::vector<PointLight> pointLights;
   
   std::vector<Pipeline> pipelines;
 
   bool isRunning = true;
 
-  void init(const Display& d);
+  void init(const Display& d, const Settings& s);
   
   void setProjection(const Projection& projection);
+  void setPresentMode(const vk::PresentModeKHR presentMode);
   void setLight(const glm::vec3& pos, const glm::vec3 color, const float ambient);
-  void addObject(const UniformBuffer& uniform, const uint32_t meshIdx, const uint32_t textureIdx, const uint32_t pipelineIdx);
-  void loadMesh(const std::string_view path);
-  void loadTexture(const std::string_view path);
-
+  void moveLight(const glm::vec3& pos);
+  uint32_t addPointLight(const PointLight& pointLight);
+  ObjectHandle addObject(const Transform& transform, const glm::vec3& color, const uint32_t meshIdx, const uint32_t textureIdx, const uint32_t pipelineIdx, const uint32_t materialIdx = 0);
+  void removeObject(const ObjectHandle handle);
+  void setTransform(const ObjectHandle handle, const Transform& transform);
+  void setMotion(const ObjectHandle handle, const glm::vec3& velocity, const glm::vec3& angularVelocity);
+  uint32_t addMaterial(const Material& material);
+  uint32_t loadMesh(const std::string_view path);
+  uint32_t loadMesh(const std::string_view name, const char* data, const size_t size);
+  uint32_t loadTexture(const std::string_view path);
+  uint32_t loadTexture(const std::string_view name, const char* data, const size_t size);
+  void unloadMesh(const uint32_t meshIdx);
+  void unloadTexture(const uint32_t textureIdx);
+  void unloadPipeline(const uint32_t pipelineIdx);
+  void loadScene(const std::string_view path);
+
+  float beginFrame();
   void drawFrame(float deltaTime);
   void processInput(float deltaTime);
   void destroy();
+
+  const FrameStats& frameStats() const;
+  void resetFrameStats();
+  const ShadowStats& shadowStats() const;
+  const RenderStats& renderStats() const;
+  MemoryReport memoryReport() const;
+  std::string memoryReportJson(const bool detailed) const;
+  void writeMemoryReport(const std::string_view path) const;
 private:
   Display display;
+  Settings settings;
+  FramePacer framePacer;
+  ResolutionScaler resolutionScaler;
   Projection projection;
   Light light;
+  ObjectHandle lightMarker;
   Camera camera;
 
   vkb::Instance instance;
@@ -57,28 +131,71 @@ private:
 
   Image depthImage;
 
+  RenderGraph renderGraph;
+
   VmaAllocator allocator;
 
   std::vector<vk::Fence> fences;
   std::vector<vk::Semaphore> renderCompleteSemaphores;
   std::vector<vk::Semaphore> presentCompleteSemaphores;
+  std::vector<uint64_t> frameSerials;
+  uint64_t submitSerial = 0;
 
-  vk::DescriptorPool descriptorPool;
+  DeletionQueue deletionQueue;
+  std::vector<uint32_t> freeMeshes;
+  std::vector<uint32_t> freeTextures;
+
+  DescriptorAllocator descriptorAllocator;
+  std::vector<DescriptorAllocator> frameDescriptorAllocators;
 
   vk::DescriptorSetLayout descriptorSetLayout;
-  vk::DescriptorSetLayout textureSetLayout;
   vk::DescriptorSetLayout objectSetLayout;
   vk::DescriptorSetLayout lightSetLayout;
 
   vk::CommandPool commandPool;
   std::vector<vk::CommandBuffer> commadBuffers;
 
-  uint16_t MAX_CONCURRENT_FRAMES = 2;
+  BindlessTextures bindlessTextures;
+  TextureStreamer textureStreamer;
+  ShaderReloader shaderReloader;
+  Simulation simulation;
+  JobSystem jobs;
+  uint64_t appliedSimulationTick = 0;
+  AssetArchive assetArchive;
+  AsyncReader assetReader;
+  ObjectBuffer objectBuffer;
+  ClusteredLights clusteredLights;
+  ShadowMap shadowMap;
+  DepthPrepass depthPrepass;
+  OcclusionCulling occlusionCulling;
+
+  vk::QueryPool statisticsQueryPool;
+  bool statisticsSupported = false;
+  std::vector<bool> statisticsPending;
+  vk::QueryPool timestampQueryPool;
+  bool timestampsSupported = false;
+  float timestampPeriod = 0.0f;
+  std::vector<bool> timestampsPending;
+  RenderStats lastRenderStats;
+
+  uint32_t MAX_BINDLESS_TEXTURES = 16384;
   uint16_t frame = 0;
-  bool shouldBeResized = false;
+  bool shouldRebuildSwapchain = false;
+
+  uint32_t imageIndex = 0;
+  bool frameAcquired = false;
+
+  bool memoryBudgetSupported = false;
+  bool presentWaitSupported = false;
+  PFN_vkWaitForPresentKHR vkWaitForPresent = nullptr;
+  uint64_t presentId = 0;
+  uint64_t lastCompletedPresentId = 0;
+  std::vector<RetiredSwapchain> retiredSwapchains;
 
   vk::Viewport viewport;
   vk::Rect2D scissors;
+  vk::Viewport renderViewport;
+  vk::Rect2D renderScissors;
 
   vk::Sampler sampler;
 
@@ -86,16 +203,39 @@ private:
   void pickPhysicalDevice();
   void pickDevice();
   void createAllocator();
+  void createRenderGraph();
   void createSwapchain();
   void rebuiltSwapchain();
   void destroySwapchainResources();
+  void destroyRetiredSwapchain(const RetiredSwapchain& retired);
   void createDepthImage();
   void createViewportAndScissors();
   void createQueue();
   void createSyncPrimitives();
-  void createDescriptorPool();
+  void createDescriptorAllocators();
   void createCommandPool();
   void createCommandBuffers();
   void createSampler();
+  void createBindlessTextures();
+  void createTextureStreamer();
+  void createObjectBuffer();
+  void createClusteredLights();
+  void createShadowMap();
+  void createDepthPrepass();
+  void createOcclusionCulling();
+  void createQueryPool();
   void createPipelines();
+  void createShaderReloader();
+  void createSimulation();
+  void createJobSystem();
+  void applySimulation();
+  void applyShaderReloads();
+  void mountAssetArchive();
+  std::vector<std::vector<char>> readAssets(const std::vector<std::string_view>& paths);
+  uint32_t storeMesh(const Mesh& mesh);
+  uint32_t storeTexture(const uint32_t textureIdx, const Texture& texture);
+
+  void waitForPresent();
+
+  void recordForwardPass(vk::CommandBuffer& commandBuffer, const vk::ImageView& colorView, const vk::DescriptorSet& objectSet, const vk::DescriptorSet& lightSet, const ForwardPhase& phase);
 };
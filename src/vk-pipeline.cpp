@@ -16,12 +16,13 @@ Pipeline::Pipeline(
   const vk::Viewport& v, 
   const vk::Rect2D& s, 
   const uint32_t swapImgCount,
-  const vk::DescriptorPool& descriporPool,
+  DescriptorAllocator& descriptorAllocator,
   const std::vector<vk::DescriptorSetLayout>& descSetLayouts
 ): vertexShader{vert}, fragmentShader{frag}, descriptorSetLayouts{descSetLayouts}, swapchainImageCount{swapImgCount}, viewport{v}, scissors{s} {
   createVertexInputState();
-  createDescriptors(descriporPool, allocator, device);
-  createPipeline(device);
+  createDescriptors(descriptorAllocator, allocator, device);
+  createPipelineLayout(device);
+  graphicsPipeline = build(device, vertexShader.module, fragmentShader.module);
 };
 
 void Pipeline::createVertexInputState() {
@@ -64,15 +65,8 @@ void Pipeline::createVertexInputState() {
   };
 }
 
-void Pipeline::createDescriptors(const vk::DescriptorPool& descriptorPool, const VmaAllocator& allocator, const vk::Device& device) {
-  std::vector<vk::DescriptorSetLayout> layouts(swapchainImageCount, descriptorSetLayouts[1]);
-
-  vk::DescriptorSetAllocateInfo allocateInfo = vk::DescriptorSetAllocateInfo{}
-    .setDescriptorPool(descriptorPool)
-    .setDescriptorSetCount(swapchainImageCount)
-    .setSetLayouts(layouts);
-
-  descriptorSets = device.allocateDescriptorSets(allocateInfo);
+void Pipeline::createDescriptors(DescriptorAllocator& descriptorAllocator, const VmaAllocator& allocator, const vk::Device& device) {
+  descriptorSets = descriptorAllocator.allocate(device, descriptorSetLayouts[1], swapchainImageCount);
 
   projection = Buffer{allocator, sizeof(Projection), vk::BufferUsageFlagBits::eUniformBuffer};
 
@@ -98,16 +92,31 @@ void Pipeline::createDescriptors(const vk::DescriptorPool& descriptorPool, const
   }
 }
 
-void Pipeline::createPipeline(const vk::Device& device) {
+void Pipeline::createPipelineLayout(const vk::Device& device) {
+  vk::PushConstantRange pushConstantRange = vk::PushConstantRange{}
+    .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment)
+    .setOffset(0)
+    .setSize(sizeof(DrawConstants));
+
+  vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
+      .setSetLayouts(descriptorSetLayouts)
+      .setSetLayoutCount(descriptorSetLayouts.size())
+      .setPushConstantRanges(pushConstantRange)
+      .setPushConstantRangeCount(1);
+
+  pipelineLayout = device.createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
+}
+
+vk::Pipeline Pipeline::build(const vk::Device& device, const vk::ShaderModule& vertexModule, const vk::ShaderModule& fragmentModule) const {
   vk::PipelineShaderStageCreateInfo vertexShaderStage = vk::PipelineShaderStageCreateInfo{}
     .setStage(vk::ShaderStageFlagBits::eVertex)
-    .setModule(vertexShader.module)
+    .setModule(vertexModule)
     .setPName("main")
     .setPSpecializationInfo(nullptr);
 
   vk::PipelineShaderStageCreateInfo fragmentShaderStage = vk::PipelineShaderStageCreateInfo{}
     .setStage(vk::ShaderStageFlagBits::eFragment)
-    .setModule(fragmentShader.module)
+    .setModule(fragmentModule)
     .setPName("main")
     .setPSpecializationInfo(nullptr);
   
@@ -168,18 +177,17 @@ void Pipeline::createPipeline(const vk::Device& device) {
     .setAttachmentCount(1)
     .setAttachments(colorBlendAttachmentState);
   
-  vk::DynamicState dynamicStates[2] = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+  vk::DynamicState dynamicStates[4] = {
+    vk::DynamicState::eViewport,
+    vk::DynamicState::eScissor,
+    vk::DynamicState::eDepthCompareOp,
+    vk::DynamicState::eDepthWriteEnable,
+  };
 
   vk::PipelineDynamicStateCreateInfo dynamicState = vk::PipelineDynamicStateCreateInfo{}
     .setDynamicStates(dynamicStates)
-    .setDynamicStateCount(2);
+    .setDynamicStateCount(4);
 
-  vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
-      .setSetLayouts(descriptorSetLayouts)
-      .setSetLayoutCount(descriptorSetLayouts.size());
-
-  pipelineLayout = device.createPipelineLayout(pipelineLayoutCreateInfo, nullptr);
-    
   vk::GraphicsPipelineCreateInfo graphicsPipelineCreateInfo = vk::GraphicsPipelineCreateInfo{}
     .setPNext(&pipelineRenderingCreateInfo)
     .setStages(stages)
@@ -202,7 +210,7 @@ void Pipeline::createPipeline(const vk::Device& device) {
     throw std::runtime_error{"Failed to create a pipeline"};
   }
 
-  graphicsPipeline = pipelineResult.value;
+  return pipelineResult.value;
 }
 
 void Pipeline::destroy(const VmaAllocator& allocator, const vk::Device& device) {
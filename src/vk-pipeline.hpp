@@ -1,8 +1,15 @@
 #pragma once
 
 #include "buffer.hpp"
+#include "descriptor-allocator.hpp"
 #include "vk-shader.hpp"
 
+struct DrawConstants {
+  uint32_t objectIdx;
+  uint32_t materialIdx;
+  uint32_t textureIdx;
+};
+
 class Pipeline {
 public:
   Shader vertexShader;
@@ -32,13 +39,15 @@ public:
     const vk::Viewport& viewport, 
     const vk::Rect2D& scissors, 
     const uint32_t swapchainImageCount,
-    const vk::DescriptorPool& descriptorPool,
+    DescriptorAllocator& descriptorAllocator,
     const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts
   );
 
+  vk::Pipeline build(const vk::Device& device, const vk::ShaderModule& vertexModule, const vk::ShaderModule& fragmentModule) const;
+
   void destroy(const VmaAllocator& allocator, const vk::Device& device);
 private:
   void createVertexInputState();
-  void createDescriptors(const vk::DescriptorPool& descriptorPool, const VmaAllocator& allocator, const vk::Device& device);
-  void createPipeline(const vk::Device& device);
+  void createDescriptors(DescriptorAllocator& descriptorAllocator, const VmaAllocator& allocator, const vk::Device& device);
+  void createPipelineLayout(const vk::Device& device);
 };
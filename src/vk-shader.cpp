@@ -2,7 +2,7 @@
 #include "vk-shader.hpp"
 #include "fs.hpp"
 
-Shader::Shader(const vk::Device& device, const std::string_view path) {
+Shader::Shader(const vk::Device& device, const std::string_view p): path{p} {
   createShaderModule(device, path);
 }
 
@@ -11,10 +11,11 @@ void Shader::destroy(const vk::Device& device) {
 }
 
 void Shader::createShaderModule(const vk::Device& device, const std::string_view path) {
-  std::vector<char> file = fs::readFile(path);
+  // Mappings are page aligned, so the SPIR-V words can be handed to the driver in place
+  fs::MappedFile file{path};
 
   vk::ShaderModuleCreateInfo createInfo = vk::ShaderModuleCreateInfo{}
-    .setPCode(reinterpret_cast<uint32_t*>(file.data()))
+    .setPCode(reinterpret_cast<const uint32_t*>(file.data()))
     .setCodeSize(file.size());
   
   module = device.createShaderModule(createInfo, VK_NULL_HANDLE);
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <string>
 #include <string_view>
 #include <vulkan/vulkan.hpp>
 
 class Shader {
 public:
   vk::ShaderModule module;
+  std::string path;
 
   Shader(const vk::Device& device, const std::string_view path);
   void destroy(const vk::Device& device);
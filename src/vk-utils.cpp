@@ -6,12 +6,13 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-vkb::Swapchain utils::createSwapchain(vkb::Device device, vk::Extent2D extent, uint16_t minImageCount, vkb::Swapchain* old) {
+vkb::Swapchain utils::createSwapchain(vkb::Device device, vk::Extent2D extent, uint32_t minImageCount, vk::PresentModeKHR presentMode, vkb::Swapchain* old) {
   vkb::SwapchainBuilder builder = vkb::SwapchainBuilder{device}
-    .set_old_swapchain(*old)
     .set_desired_extent(extent.width, extent.height)
-    .set_required_min_image_count(minImageCount)
-    .set_desired_present_mode(VkPresentModeKHR::VK_PRESENT_MODE_MAILBOX_KHR);
+    .set_desired_min_image_count(minImageCount)
+    .set_image_usage_flags(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+    .set_desired_present_mode(static_cast<VkPresentModeKHR>(presentMode))
+    .add_fallback_present_mode(VkPresentModeKHR::VK_PRESENT_MODE_FIFO_KHR);
 
   if (old) {
     builder.set_old_swapchain(*old);
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "job-system.hpp"
+
+static const uint32_t SPAWN_JOBS = 1 << 20;
+static const uint32_t KERNEL_ELEMENTS = 1 << 22;
+static const uint32_t REPEATS = 5;
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(const Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>{Clock::now() - start}.count();
+}
+
+// Empty jobs all spawned from one thread, so everything other threads run is stolen
+static void spawnBench(JobSystem& jobs, double& nsPerJob, double& stolenRatio) {
+  std::atomic<uint32_t> sink{0};
+  double best = 1e30;
+  JobStats stats{};
+
+  for (uint32_t r = 0; r < REPEATS; r++) {
+    jobs.resetStats();
+    JobCounter counter;
+    Clock::time_point start = Clock::now();
+
+    for (uint32_t i = 0; i < SPAWN_JOBS; i++) {
+      jobs.run(counter, [&sink]() {
+        sink.fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+
+    jobs.wait(counter);
+
+    double ns = elapsedNs(start);
+
+    if (ns < best) {
+      best = ns;
+      stats = jobs.stats();
+    }
+  }
+
+  nsPerJob = best / SPAWN_JOBS;
+  stolenRatio = stats.executed > 0 ? static_cast<double>(stats.stolen) / stats.executed : 0.0;
+}
+
+// Compute bound kernel, roughly the per object cost of a transform update
+static double kernelBench(JobSystem& jobs, std::vector<float>& data) {
+  double best = 1e30;
+
+  for (uint32_t r = 0; r < REPEATS; r++) {
+    Clock::time_point start = Clock::now();
+
+    jobs.parallelFor(data.size(), 4096, [&](const uint32_t begin, const uint32_t end) {
+      for (uint32_t i = begin; i < end; i++) {
+        float x = data[i];
+
+        for (uint32_t k = 0; k < 8; k++) {
+          x = std::sin(x) * 0.5f + std::cos(x * 0.25f);
+        }
+
+        data[i] = x;
+      }
+    });
+
+    best = std::min(best, elapsedNs(start));
+  }
+
+  return best / 1e6;
+}
+
+int main(int argc, char** argv) {
+  std::string_view usage = "usage: vkr-job-bench [max-threads]\n";
+  uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  uint32_t maxThreads = hardwareThreads;
+
+  try {
+    if (argc > 2) {
+      throw std::runtime_error{std::string{usage}};
+    }
+
+    if (argc == 2) {
+      maxThreads = std::stoul(argv[1]);
+    }
+  } catch (const std::exception&) {
+    std::fputs(usage.data(), stderr);
+    return 1;
+  }
+
+  std::vector<uint32_t> threadCounts;
+
+  for (uint32_t count = 1; count < maxThreads; count *= 2) {
+    threadCounts.push_back(count);
+  }
+
+  threadCounts.push_back(maxThreads);
+
+  std::printf("hardware threads %u\n", hardwareThreads);
+  std::printf("%8s %14s %10s %14s %9s %11s\n", "threads", "spawn ns/job", "stolen", "kernel ms", "speedup", "efficiency");
+
+  std::vector<float> data(KERNEL_ELEMENTS);
+  double baseline = 0.0;
+
+  for (uint32_t threads : threadCounts) {
+    for (size_t i = 0; i < data.size(); i++) {
+      data[i] = static_cast<float>(i % 1024) / 1024.0f;
+    }
+
+    JobSystem jobs;
+    jobs.start(threads);
+
+    double nsPerJob = 0.0;
+    double stolenRatio = 0.0;
+    spawnBench(jobs, nsPerJob, stolenRatio);
+
+    double kernelMs = kernelBench(jobs, data);
+
+    jobs.stop();
+
+    if (threads == threadCounts.front()) {
+      baseline = kernelMs * threads;
+    }
+
+    double speedup = baseline / kernelMs;
+
+    std::printf("%8u %14.1f %9.1f%% %14.2f %8.2fx %10.1f%%\n",
+      threads,
+      nsPerJob,
+      stolenRatio * 100.0,
+      kernelMs,
+      speedup,
+      speedup / threads * 100.0);
+  }
+}
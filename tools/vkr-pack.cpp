@@ -0,0 +1,39 @@
+#include <cinttypes>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "asset-archive.hpp"
+
+static void list(const std::string_view path) {
+  AssetArchive archive{path};
+
+  for (const AssetArchiveEntry& entry : archive.entries()) {
+    std::string name{archive.name(entry)};
+    std::printf("%12" PRIu64 " %12" PRIu64 " %s\n", entry.offset, entry.size, name.c_str());
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string_view usage = "usage: vkr-pack list <archive> | vkr-pack create <archive> <file>...\n";
+
+  try {
+    if (argc == 3 && std::string_view{argv[1]} == "list") {
+      list(argv[2]);
+      return 0;
+    }
+
+    if (argc >= 4 && std::string_view{argv[1]} == "create") {
+      writeAssetArchive(argv[2], std::vector<std::string>{argv + 3, argv + argc});
+      return 0;
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  std::fputs(usage.data(), stderr);
+  return 1;
+}
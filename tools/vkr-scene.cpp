@@ -0,0 +1,59 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "scene-file.hpp"
+
+static void generate(const std::string_view path, const uint32_t count) {
+  SceneDesc desc{};
+
+  desc.meshes = {"./assets/cube.obj", "./assets/suzanne.obj"};
+  desc.textures = {"./textures/default.jpg"};
+  desc.light = SceneFileLight{{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, 0.03f, 1};
+
+  uint32_t side = std::ceil(std::cbrt(static_cast<double>(count)));
+
+  for (uint32_t i = 0; i < count; i++) {
+    SceneFileObject object{};
+
+    object.position[0] = (i % side) * 3.0f;
+    object.position[1] = ((i / side) % side) * 3.0f;
+    object.position[2] = -10.0f - (i / (side * side)) * 3.0f;
+    object.rotation[0] = 1.0f;
+    object.scale[0] = object.scale[1] = object.scale[2] = 1.0f;
+    object.color[0] = object.color[1] = object.color[2] = 0.5f;
+    object.meshIdx = i % 2;
+    object.textureIdx = 0;
+    object.pipelineIdx = 2;
+
+    desc.objects.push_back(object);
+  }
+
+  writeSceneFile(path, desc);
+}
+
+int main(int argc, char** argv) {
+  std::string_view usage = "usage: vkr-scene dump <scene> | vkr-scene generate <scene> <count>\n";
+
+  try {
+    if (argc == 3 && std::string_view{argv[1]} == "dump") {
+      SceneFile scene{argv[2]};
+      std::fputs(scene.toText().c_str(), stdout);
+      return 0;
+    }
+
+    if (argc == 4 && std::string_view{argv[1]} == "generate") {
+      generate(argv[2], std::stoul(argv[3]));
+      return 0;
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  std::fputs(usage.data(), stderr);
+  return 1;
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "transform-kernels.hpp"
+
+static const uint32_t DEFAULT_OBJECTS = 1 << 17;
+static const uint32_t REPEATS = 10;
+
+using Clock = std::chrono::steady_clock;
+
+struct Scene {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec3> scales;
+  std::vector<uint32_t> indices;
+  glm::mat4 viewProjection;
+};
+
+struct Output {
+  std::vector<glm::mat4> models;
+  std::vector<glm::mat3x4> normals;
+  std::vector<glm::mat4> clips;
+};
+
+static bool quatWFirst() {
+  glm::quat identity{1.0f, 0.0f, 0.0f, 0.0f};
+  return reinterpret_cast<const float*>(&identity)[0] == 1.0f;
+}
+
+// Best of several runs, in nanoseconds per object
+template <typename F>
+static double measure(const uint32_t count, const F& function) {
+  double best = 1e30;
+
+  for (uint32_t r = 0; r < REPEATS; r++) {
+    Clock::time_point start = Clock::now();
+    function();
+    best = std::min(best, std::chrono::duration<double, std::nano>{Clock::now() - start}.count());
+  }
+
+  return best / count;
+}
+
+static float maxError(const float* a, const float* b, const size_t count) {
+  float error = 0.0f;
+
+  for (size_t i = 0; i < count; i++) {
+    error = std::max(error, std::fabs(a[i] - b[i]));
+  }
+
+  return error;
+}
+
+static Scene createScene(const uint32_t count) {
+  std::mt19937 random{1234};
+  std::uniform_real_distribution<float> position{-500.0f, 500.0f};
+  std::uniform_real_distribution<float> scale{0.25f, 4.0f};
+  std::uniform_real_distribution<float> component{-1.0f, 1.0f};
+
+  Scene scene{};
+
+  for (uint32_t i = 0; i < count; i++) {
+    scene.positions.push_back(glm::vec3{position(random), position(random), position(random)});
+    scene.rotations.push_back(glm::normalize(glm::quat{component(random), component(random), component(random), component(random)}));
+    scene.scales.push_back(glm::vec3{scale(random), scale(random), scale(random)});
+  }
+
+  // Dirty lists come in whatever order objects were touched, not in storage order
+  scene.indices.resize(count);
+  std::iota(scene.indices.begin(), scene.indices.end(), 0);
+  std::shuffle(scene.indices.begin(), scene.indices.end(), random);
+
+  glm::mat4 view = glm::lookAt(glm::vec3{0.0f, 50.0f, 200.0f}, glm::vec3{0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+  scene.viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 2000.0f) * view;
+
+  return scene;
+}
+
+// The per object path kernels replace, composed from glm's matrix helpers one object at a time
+static void composeGlm(const Scene& scene, Output& output) {
+  for (uint32_t idx : scene.indices) {
+    glm::mat4 model = glm::translate(glm::mat4{1.0f}, scene.positions[idx]) * glm::mat4_cast(scene.rotations[idx]) * glm::scale(glm::mat4{1.0f}, scene.scales[idx]);
+
+    output.models[idx] = model;
+    output.normals[idx] = glm::mat3x4{glm::transpose(glm::inverse(glm::mat3{model}))};
+  }
+}
+
+static void multiplyGlm(const Scene& scene, Output& output) {
+  for (size_t i = 0; i < output.models.size(); i++) {
+    output.clips[i] = scene.viewProjection * output.models[i];
+  }
+}
+
+static Output createOutput(const uint32_t count) {
+  Output output{};
+  output.models.resize(count);
+  output.normals.resize(count);
+  output.clips.resize(count);
+  return output;
+}
+
+int main(int argc, char** argv) {
+  std::string_view usage = "usage: vkr-transform-bench [object-count]\n";
+  uint32_t count = DEFAULT_OBJECTS;
+
+  try {
+    if (argc > 2) {
+      throw std::runtime_error{std::string{usage}};
+    }
+
+    if (argc == 2) {
+      count = std::stoul(argv[1]);
+    }
+
+    if (count == 0) {
+      throw std::runtime_error{std::string{usage}};
+    }
+  } catch (const std::exception&) {
+    std::fputs(usage.data(), stderr);
+    return 1;
+  }
+
+  Scene scene = createScene(count);
+  Output reference = createOutput(count);
+
+  double composeBaseline = measure(count, [&]() { composeGlm(scene, reference); });
+  double multiplyBaseline = measure(count, [&]() { multiplyGlm(scene, reference); });
+
+  std::printf("objects %u, detected %s\n", count, kernels::name(kernels::detect()).data());
+  std::printf("%8s %15s %9s %15s %9s %10s\n", "variant", "compose ns/obj", "speedup", "multiply ns/obj", "speedup", "max error");
+  std::printf("%8s %15.2f %8.2fx %15.2f %8.2fx %10s\n", "glm", composeBaseline, 1.0, multiplyBaseline, 1.0, "-");
+
+  for (uint32_t i = 0; i < static_cast<uint32_t>(KernelIsa::Count); i++) {
+    KernelIsa isa = static_cast<KernelIsa>(i);
+
+    if (!kernels::supported(isa)) {
+      std::printf("%8s %15s\n", kernels::name(isa).data(), "unsupported");
+      continue;
+    }
+
+    kernels::use(isa);
+
+    Output output = createOutput(count);
+
+    TransformArrays arrays{};
+    arrays.positions = reinterpret_cast<const float*>(scene.positions.data());
+    arrays.rotations = reinterpret_cast<const float*>(scene.rotations.data());
+    arrays.scales = reinterpret_cast<const float*>(scene.scales.data());
+    arrays.models = reinterpret_cast<float*>(output.models.data());
+    arrays.normals = reinterpret_cast<float*>(output.normals.data());
+    arrays.rotationWFirst = quatWFirst();
+
+    double compose = measure(count, [&]() {
+      kernels::composeTransforms(count, scene.indices.data(), arrays);
+    });
+
+    double multiply = measure(count, [&]() {
+      kernels::multiplyMatrices(count, reinterpret_cast<const float*>(&scene.viewProjection), reinterpret_cast<const float*>(output.models.data()), reinterpret_cast<float*>(output.clips.data()));
+    });
+
+    // Positions reach the hundreds, so differences around 1e-4 are only rounding
+    float error = std::max(maxError(reinterpret_cast<const float*>(output.models.data()), reinterpret_cast<const float*>(reference.models.data()), count * 16),
+      maxError(reinterpret_cast<const float*>(output.normals.data()), reinterpret_cast<const float*>(reference.normals.data()), count * 12));
+
+    std::printf("%8s %15.2f %8.2fx %15.2f %8.2fx %10.2g\n",
+      kernels::name(isa).data(),
+      compose,
+      composeBaseline / compose,
+      multiply,
+      multiplyBaseline / multiply,
+      error);
+  }
+}